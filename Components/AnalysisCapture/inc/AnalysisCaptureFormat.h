@@ -0,0 +1,142 @@
+#ifndef ANALYSIS_CAPTURE_FORMAT_H
+#define ANALYSIS_CAPTURE_FORMAT_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include "Centroid.h"
+
+/**
+ * @brief On-disk layout of an analysis capture.
+ *
+ * A capture is a file header followed by fixed-size frame records, one per
+ * analysed frame, in native little-endian byte order. Every record has room
+ * for the same number of bins and clusters, so record i starts at
+ * headerBytes + i * recordBytes and the file can be read in place. A record
+ * holds a FrameHeader, then the magnitudes (float per bin), the assignments
+ * (byte per bin), the centroids (frequency and magnitude floats per cluster)
+ * and the energies (float per cluster), each section starting on an 8-byte
+ * boundary.
+ */
+namespace AnalysisCapture {
+    static_assert(std::endian::native == std::endian::little,
+                  "Captures are written in little-endian byte order");
+    static_assert(sizeof(Centroid) == 2 * sizeof(float));
+
+    /** "GVCP", the first four bytes of a capture */
+    constexpr uint32_t magic = 0x50435647;
+
+    /** Version of the layout, bumped on any change */
+    constexpr uint32_t version = 1;
+
+    /**
+     * @brief Stages of the analysis timed for every frame.
+     */
+    enum Stage : uint32_t { spectral, graph, clustering, publish, numStages };
+
+    /**
+     * @brief Flags describing a frame.
+     */
+    enum Flags : uint32_t {
+        /** The frame had more bins than the record holds */
+        binsTruncated = 1u << 0,
+        /** The frame had more clusters than the record holds */
+        clustersTruncated = 1u << 1,
+        /** The frame starts from restored centroids */
+        restored = 1u << 2,
+        /** The frame kept the centroids and only reassigned the bins */
+        incremental = 1u << 3
+    };
+
+    /**
+     * @brief Header at the start of the file.
+     */
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t headerBytes;
+        uint32_t recordBytes;
+        /** Bins each record has room for */
+        uint32_t maxBins;
+        /** Clusters each record has room for */
+        uint32_t maxClusters;
+        uint32_t reserved0;
+        uint32_t reserved1;
+        /** Number of records the file has room for */
+        uint64_t capacity;
+        /** Number of records written; updated after each record */
+        uint64_t numFrames;
+        /** Wall-clock start of the capture, in milliseconds since 1970 */
+        int64_t startTimeMs;
+        uint64_t reserved2;
+    };
+    static_assert(sizeof(FileHeader) == 64);
+
+    /**
+     * @brief Header at the start of each frame record.
+     */
+    struct FrameHeader {
+        /** Index of the frame since the capture started */
+        uint64_t index;
+        /** Time since the capture started, in nanoseconds */
+        uint64_t timestampNs;
+        /** Number of samples analysed since the worker started */
+        uint64_t samplePosition;
+        double sampleRate;
+        /** Number of bins stored; the frame's own count may be larger */
+        uint32_t numBins;
+        /** Number of clusters stored */
+        uint32_t numClusters;
+        uint32_t fftSize;
+        uint32_t hopSize;
+        /** Number of k-means iterations the clustering ran */
+        uint32_t iterations;
+        /** Combination of Flags */
+        uint32_t flags;
+        /** Time spent in each Stage, in microseconds */
+        float stageMicroseconds[numStages];
+    };
+    static_assert(sizeof(FrameHeader) == 72);
+
+    /**
+     * @brief Round a byte count up to the next multiple of 8.
+     * @param bytes The byte count.
+     * @return The rounded count.
+     */
+    constexpr size_t align8(const size_t bytes) {
+        return (bytes + 7) & ~size_t{7};
+    }
+
+    /**
+     * @brief Offsets of the sections of a record, from its start.
+     */
+    struct RecordLayout {
+        size_t magnitudes;
+        size_t assignments;
+        size_t centroids;
+        size_t energies;
+        size_t recordBytes;
+
+        /**
+         * @brief Compute the layout of a record.
+         * @param maxBins Bins each record has room for.
+         * @param maxClusters Clusters each record has room for.
+         * @return The layout.
+         */
+        static constexpr RecordLayout make(const size_t maxBins,
+                                           const size_t maxClusters) {
+            RecordLayout layout{};
+            layout.magnitudes = sizeof(FrameHeader);
+            layout.assignments =
+                    layout.magnitudes + align8(maxBins * sizeof(float));
+            layout.centroids = layout.assignments + align8(maxBins);
+            layout.energies =
+                    layout.centroids + align8(maxClusters * sizeof(Centroid));
+            layout.recordBytes =
+                    layout.energies + align8(maxClusters * sizeof(float));
+            return layout;
+        }
+    };
+} // namespace AnalysisCapture
+
+#endif // ANALYSIS_CAPTURE_FORMAT_H
@@ -0,0 +1,81 @@
+#ifndef ANALYSIS_CAPTURE_READER_H
+#define ANALYSIS_CAPTURE_READER_H
+
+#include <juce_core/juce_core.h>
+#include <memory>
+#include "AnalysisCaptureFormat.h"
+
+/**
+ * @brief Reads an analysis capture in place through a read-only memory map.
+ *
+ * Frames are returned as views into the mapping, so iterating a capture of
+ * any size copies nothing. A capture that is still being written can be
+ * read; it shows the frames written when it was opened.
+ */
+class AnalysisCaptureReader {
+public:
+    /**
+     * @brief View of one frame record inside the mapping.
+     */
+    struct FrameView {
+        /** The frame header */
+        const AnalysisCapture::FrameHeader *header = nullptr;
+        /** header->numBins magnitudes */
+        const float *magnitudes = nullptr;
+        /** header->numBins cluster assignments */
+        const uint8_t *assignments = nullptr;
+        /** header->numClusters centroids */
+        const Centroid *centroids = nullptr;
+        /** header->numClusters energies */
+        const float *energies = nullptr;
+    };
+
+    /**
+     * @brief Constructor for the AnalysisCaptureReader. Maps and validates
+     * the file.
+     * @param file The capture file.
+     */
+    explicit AnalysisCaptureReader(const juce::File &file);
+
+    /**
+     * @brief Check if the file is a capture this reader understands.
+     * @return True if the file was mapped and its header is valid.
+     */
+    [[nodiscard]] bool isValid() const { return header != nullptr; }
+
+    /**
+     * @brief Get the file header.
+     * @return The header. Only valid if isValid() is true.
+     */
+    [[nodiscard]] const AnalysisCapture::FileHeader &getHeader() const {
+        return *header;
+    }
+
+    /**
+     * @brief Get the number of complete frames in the capture.
+     * @return The number of frames.
+     */
+    [[nodiscard]] uint64_t getNumFrames() const { return numFrames; }
+
+    /**
+     * @brief Get a view of a frame.
+     * @param index The frame index, less than getNumFrames().
+     * @return The view into the mapping.
+     */
+    [[nodiscard]] FrameView getFrame(uint64_t index) const;
+
+private:
+    /** Read-only mapping of the whole file */
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+
+    /** The file header, or null if the file is not a valid capture */
+    const AnalysisCapture::FileHeader *header = nullptr;
+
+    /** Offsets of the sections of each record */
+    AnalysisCapture::RecordLayout layout{};
+
+    /** Number of complete frames */
+    uint64_t numFrames = 0;
+};
+
+#endif // ANALYSIS_CAPTURE_READER_H
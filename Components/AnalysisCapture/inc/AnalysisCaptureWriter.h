@@ -0,0 +1,121 @@
+#ifndef ANALYSIS_CAPTURE_WRITER_H
+#define ANALYSIS_CAPTURE_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <juce_core/juce_core.h>
+#include <memory>
+#include "AnalysisCaptureFormat.h"
+
+/**
+ * @brief Appends analysis frames to a preallocated, memory-mapped capture
+ * file.
+ *
+ * The file is sized to its full length, with its blocks reserved where the
+ * platform allows, and mapped when the capture is created; no data is written
+ * up front, so creating a long capture is as quick as a short one. Appending
+ * a frame is then a copy into the mapping and an update of the frame count:
+ * it never allocates, locks or makes a system call, so it can run on the
+ * analysis thread for every frame. Once the file is full further frames are
+ * counted and dropped.
+ */
+class AnalysisCaptureWriter {
+public:
+    /**
+     * @brief One analysis frame, as pointers into the analysis state.
+     */
+    struct Frame {
+        uint64_t samplePosition = 0;
+        double sampleRate = 0.0;
+        int fftSize = 0;
+        int hopSize = 0;
+        /** One magnitude per bin */
+        const float *magnitudes = nullptr;
+        int numBins = 0;
+        /** Cluster of each bin */
+        const int *assignments = nullptr;
+        /** One centroid per cluster */
+        const Centroid *centroids = nullptr;
+        /** One energy per cluster */
+        const float *energies = nullptr;
+        int numClusters = 0;
+        int iterations = 0;
+        /** Combination of AnalysisCapture::Flags */
+        uint32_t flags = 0;
+        /** Time spent in each AnalysisCapture::Stage, in microseconds */
+        const float *stageMicroseconds = nullptr;
+    };
+
+    /**
+     * @brief Create a capture file, replacing any existing file.
+     * @param file The file to write.
+     * @param maxBins Bins each record has room for.
+     * @param maxClusters Clusters each record has room for, at most 255.
+     * @param maxFrames Number of frames the file has room for.
+     * @return The writer, or null if the file could not be created or mapped.
+     */
+    static std::unique_ptr<AnalysisCaptureWriter>
+    create(const juce::File &file, int maxBins, int maxClusters,
+           uint64_t maxFrames);
+
+    /**
+     * @brief Append a frame. Never allocates or blocks.
+     * @param frame The frame.
+     * @return True if the frame was written, false if the file is full.
+     */
+    bool append(const Frame &frame);
+
+    /**
+     * @brief Get the number of frames written.
+     * @return The number of frames.
+     */
+    [[nodiscard]] uint64_t getNumFrames() const {
+        return numFrames.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of frames dropped because the file was full.
+     * @return The number of frames.
+     */
+    [[nodiscard]] uint64_t getNumDropped() const {
+        return numDropped.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the capture file.
+     * @return The file.
+     */
+    [[nodiscard]] const juce::File &getFile() const { return file; }
+
+private:
+    /**
+     * @brief Constructor for the AnalysisCaptureWriter.
+     * @param fileIn The capture file, already sized.
+     * @param mappedIn The writable mapping of the whole file.
+     */
+    AnalysisCaptureWriter(juce::File fileIn,
+                          std::unique_ptr<juce::MemoryMappedFile> mappedIn);
+
+    /** The capture file */
+    juce::File file;
+
+    /** Writable mapping of the whole file */
+    std::unique_ptr<juce::MemoryMappedFile> mapped;
+
+    /** The file header, inside the mapping */
+    AnalysisCapture::FileHeader *header;
+
+    /** Offsets of the sections of each record */
+    AnalysisCapture::RecordLayout layout;
+
+    /** Time the capture started, for the frame timestamps */
+    std::chrono::steady_clock::time_point startTime;
+
+    /** Number of frames written */
+    std::atomic<uint64_t> numFrames{0};
+
+    /** Number of frames dropped because the file was full */
+    std::atomic<uint64_t> numDropped{0};
+};
+
+#endif // ANALYSIS_CAPTURE_WRITER_H
@@ -0,0 +1,77 @@
+#ifndef ANALYSIS_REPLAY_H
+#define ANALYSIS_REPLAY_H
+
+#include <cstdint>
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Cluster energies recorded in an analysis capture, looked up by sample
+ * position to drive the reverbs without running the analysis.
+ *
+ * The energies are copied out of the capture when it is loaded, so looking
+ * them up never touches the file and never allocates, and can run on the
+ * audio thread. The same capture and the same input always give the same
+ * output, whatever the speed of the machine.
+ */
+class AnalysisReplay {
+public:
+    /**
+     * @brief Load the energies of every frame in a capture.
+     *
+     * A capture spanning a restart of the analysis counts samples from zero
+     * again after the restart; only the frames before it are loaded.
+     *
+     * @param file The capture file.
+     * @return The replay, or null if the file is not a valid capture or holds
+     * no frames.
+     */
+    static std::unique_ptr<AnalysisReplay> load(const juce::File &file);
+
+    /**
+     * @brief Get the energies in effect at a sample position: those of the
+     * last frame analysed at or before it. Never allocates if the destination
+     * has room for getNumClusters() values.
+     * @param samplePosition The position, in samples since the capture's
+     * analysis started.
+     * @param destination Receives the energies; empty before the first frame.
+     */
+    void fetchEnergies(uint64_t samplePosition,
+                       std::vector<float> &destination) const;
+
+    /**
+     * @brief Get the number of energies each frame holds.
+     * @return The number of clusters.
+     */
+    [[nodiscard]] int getNumClusters() const { return numClusters; }
+
+    /**
+     * @brief Get the number of frames loaded.
+     * @return The number of frames.
+     */
+    [[nodiscard]] size_t getNumFrames() const { return positions.size(); }
+
+    /**
+     * @brief Get the sample position of the last frame.
+     * @return The position, in samples.
+     */
+    [[nodiscard]] uint64_t getLength() const { return positions.back(); }
+
+private:
+    /**
+     * @brief Constructor for the AnalysisReplay. Use load().
+     */
+    AnalysisReplay() = default;
+
+    /** Sample position of each frame, in increasing order */
+    std::vector<uint64_t> positions;
+
+    /** numClusters energies per frame, zero past the frame's own clusters */
+    std::vector<float> energies;
+
+    /** Number of energies per frame */
+    int numClusters = 0;
+};
+
+#endif // ANALYSIS_REPLAY_H
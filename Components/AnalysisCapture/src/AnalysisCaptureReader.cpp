@@ -0,0 +1,56 @@
+#include "AnalysisCaptureReader.h"
+
+#include <algorithm>
+#include <atomic>
+
+using namespace AnalysisCapture;
+
+/**
+ * @brief Constructor for the AnalysisCaptureReader. Maps and validates the
+ * file.
+ * @param file The capture file.
+ */
+AnalysisCaptureReader::AnalysisCaptureReader(const juce::File &file) :
+    mapped(std::make_unique<juce::MemoryMappedFile>(
+            file, juce::MemoryMappedFile::readOnly)) {
+    const auto size = mapped->getSize();
+    if (mapped->getData() == nullptr || size < sizeof(FileHeader))
+        return;
+    const auto *candidate = static_cast<const FileHeader *>(mapped->getData());
+    if (candidate->magic != magic || candidate->version != version ||
+        candidate->headerBytes != sizeof(FileHeader) ||
+        candidate->maxClusters > 255)
+        return;
+    layout = RecordLayout::make(candidate->maxBins, candidate->maxClusters);
+    if (candidate->recordBytes != layout.recordBytes)
+        return;
+    /// Trust the count only as far as the file actually reaches. The fence
+    /// pairs with the writer's release, for a capture still being written.
+    const uint64_t written = candidate->numFrames;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t fits = (size - sizeof(FileHeader)) / layout.recordBytes;
+    numFrames = std::min({written, candidate->capacity, fits});
+    header = candidate;
+}
+
+/**
+ * @brief Get a view of a frame.
+ * @param index The frame index, less than getNumFrames().
+ * @return The view into the mapping.
+ */
+AnalysisCaptureReader::FrameView
+AnalysisCaptureReader::getFrame(const uint64_t index) const {
+    jassert(index < numFrames);
+    const auto *record = static_cast<const char *>(mapped->getData()) +
+                         sizeof(FileHeader) + index * layout.recordBytes;
+    FrameView frame;
+    frame.header = reinterpret_cast<const FrameHeader *>(record);
+    frame.magnitudes =
+            reinterpret_cast<const float *>(record + layout.magnitudes);
+    frame.assignments =
+            reinterpret_cast<const uint8_t *>(record + layout.assignments);
+    frame.centroids =
+            reinterpret_cast<const Centroid *>(record + layout.centroids);
+    frame.energies = reinterpret_cast<const float *>(record + layout.energies);
+    return frame;
+}
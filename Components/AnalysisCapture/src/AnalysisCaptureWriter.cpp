@@ -0,0 +1,145 @@
+#include "AnalysisCaptureWriter.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if JUCE_LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace AnalysisCapture;
+
+/**
+ * @brief Create a capture file, replacing any existing file.
+ * @param file The file to write.
+ * @param maxBins Bins each record has room for.
+ * @param maxClusters Clusters each record has room for, at most 255.
+ * @param maxFrames Number of frames the file has room for.
+ * @return The writer, or null if the file could not be created or mapped.
+ */
+std::unique_ptr<AnalysisCaptureWriter>
+AnalysisCaptureWriter::create(const juce::File &file, const int maxBins,
+                              const int maxClusters,
+                              const uint64_t maxFrames) {
+    if (maxBins <= 0 || maxClusters <= 0 || maxClusters > 255 ||
+        maxFrames == 0)
+        return nullptr;
+    const auto layout = RecordLayout::make(static_cast<size_t>(maxBins),
+                                           static_cast<size_t>(maxClusters));
+    const auto totalBytes =
+            static_cast<juce::int64>(sizeof(FileHeader) +
+                                     maxFrames * layout.recordBytes);
+
+    /// Size the file without writing it: the file system hands out zeroed
+    /// blocks, so this costs the same for a long capture as a short one
+    if (!file.deleteFile() ||
+        file.getParentDirectory().createDirectory().failed())
+        return nullptr;
+    {
+        juce::FileOutputStream stream(file);
+        if (!stream.openedOk() || !stream.setPosition(totalBytes) ||
+            stream.truncate().failed())
+            return nullptr;
+    }
+#if JUCE_LINUX
+    /// Reserve the blocks too, so appending does not wait for the file
+    /// system to allocate them; where this is unsupported the file stays
+    /// sparse
+    if (const int fd = ::open(file.getFullPathName().toRawUTF8(), O_WRONLY);
+        fd >= 0) {
+        ::posix_fallocate(fd, 0, static_cast<off_t>(totalBytes));
+        ::close(fd);
+    }
+#endif
+
+    auto mapped = std::make_unique<juce::MemoryMappedFile>(
+            file, juce::MemoryMappedFile::readWrite);
+    if (mapped->getData() == nullptr ||
+        static_cast<juce::int64>(mapped->getSize()) < totalBytes)
+        return nullptr;
+
+    auto *header = static_cast<FileHeader *>(mapped->getData());
+    header->magic = magic;
+    header->version = version;
+    header->headerBytes = sizeof(FileHeader);
+    header->recordBytes = static_cast<uint32_t>(layout.recordBytes);
+    header->maxBins = static_cast<uint32_t>(maxBins);
+    header->maxClusters = static_cast<uint32_t>(maxClusters);
+    header->capacity = maxFrames;
+    header->numFrames = 0;
+    header->startTimeMs = juce::Time::currentTimeMillis();
+    return std::unique_ptr<AnalysisCaptureWriter>(
+            new AnalysisCaptureWriter(file, std::move(mapped)));
+}
+
+/**
+ * @brief Constructor for the AnalysisCaptureWriter.
+ * @param fileIn The capture file, already sized.
+ * @param mappedIn The writable mapping of the whole file.
+ */
+AnalysisCaptureWriter::AnalysisCaptureWriter(
+        juce::File fileIn, std::unique_ptr<juce::MemoryMappedFile> mappedIn) :
+    file(std::move(fileIn)), mapped(std::move(mappedIn)),
+    header(static_cast<FileHeader *>(mapped->getData())),
+    layout(RecordLayout::make(header->maxBins, header->maxClusters)),
+    startTime(std::chrono::steady_clock::now()) {}
+
+/**
+ * @brief Append a frame. Never allocates or blocks.
+ * @param frame The frame.
+ * @return True if the frame was written, false if the file is full.
+ */
+bool AnalysisCaptureWriter::append(const Frame &frame) {
+    const uint64_t index = numFrames.load(std::memory_order_relaxed);
+    if (index >= header->capacity) {
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    auto *record = static_cast<char *>(mapped->getData()) + sizeof(FileHeader) +
+                   index * layout.recordBytes;
+    const int numBins =
+            std::min(frame.numBins, static_cast<int>(header->maxBins));
+    const int numClusters =
+            std::min(frame.numClusters, static_cast<int>(header->maxClusters));
+
+    auto *frameHeader = reinterpret_cast<FrameHeader *>(record);
+    frameHeader->index = index;
+    frameHeader->timestampNs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - startTime)
+                    .count());
+    frameHeader->samplePosition = frame.samplePosition;
+    frameHeader->sampleRate = frame.sampleRate;
+    frameHeader->numBins = static_cast<uint32_t>(numBins);
+    frameHeader->numClusters = static_cast<uint32_t>(numClusters);
+    frameHeader->fftSize = static_cast<uint32_t>(frame.fftSize);
+    frameHeader->hopSize = static_cast<uint32_t>(frame.hopSize);
+    frameHeader->iterations = static_cast<uint32_t>(frame.iterations);
+    frameHeader->flags = frame.flags |
+                         (numBins < frame.numBins ? binsTruncated : 0u) |
+                         (numClusters < frame.numClusters ? clustersTruncated
+                                                          : 0u);
+    for (uint32_t stage = 0; stage < numStages; ++stage)
+        frameHeader->stageMicroseconds[stage] =
+                frame.stageMicroseconds != nullptr
+                        ? frame.stageMicroseconds[stage]
+                        : 0.0f;
+
+    std::memcpy(record + layout.magnitudes, frame.magnitudes,
+                static_cast<size_t>(numBins) * sizeof(float));
+    auto *assignments =
+            reinterpret_cast<uint8_t *>(record + layout.assignments);
+    for (int i = 0; i < numBins; ++i)
+        assignments[i] = static_cast<uint8_t>(frame.assignments[i]);
+    std::memcpy(record + layout.centroids, frame.centroids,
+                static_cast<size_t>(numClusters) * sizeof(Centroid));
+    std::memcpy(record + layout.energies, frame.energies,
+                static_cast<size_t>(numClusters) * sizeof(float));
+
+    /// Publish the record to readers of the live file only once it is whole
+    std::atomic_ref(header->numFrames).store(index + 1,
+                                             std::memory_order_release);
+    numFrames.store(index + 1, std::memory_order_relaxed);
+    return true;
+}
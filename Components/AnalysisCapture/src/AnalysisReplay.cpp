@@ -0,0 +1,57 @@
+#include "AnalysisReplay.h"
+
+#include <algorithm>
+#include "AnalysisCaptureReader.h"
+
+/**
+ * @brief Load the energies of every frame in a capture.
+ * @param file The capture file.
+ * @return The replay, or null if the file is not a valid capture or holds no
+ * frames.
+ */
+std::unique_ptr<AnalysisReplay> AnalysisReplay::load(const juce::File &file) {
+    const AnalysisCaptureReader reader(file);
+    if (!reader.isValid() || reader.getNumFrames() == 0)
+        return nullptr;
+    std::unique_ptr<AnalysisReplay> replay(new AnalysisReplay());
+    replay->numClusters = static_cast<int>(reader.getHeader().maxClusters);
+    const auto stride = static_cast<size_t>(replay->numClusters);
+    replay->positions.reserve(reader.getNumFrames());
+    replay->energies.reserve(reader.getNumFrames() * stride);
+    for (uint64_t i = 0; i < reader.getNumFrames(); ++i) {
+        const auto frame = reader.getFrame(i);
+        const uint64_t position = frame.header->samplePosition;
+        if (!replay->positions.empty() && position < replay->positions.back())
+            break;
+        replay->positions.push_back(position);
+        const auto count =
+                std::min<size_t>(frame.header->numClusters, stride);
+        replay->energies.insert(replay->energies.end(), frame.energies,
+                                frame.energies + count);
+        replay->energies.resize(replay->energies.size() + stride - count,
+                                0.0f);
+    }
+    return replay;
+}
+
+/**
+ * @brief Get the energies in effect at a sample position.
+ * @param samplePosition The position, in samples since the capture's analysis
+ * started.
+ * @param destination Receives the energies; empty before the first frame.
+ */
+void AnalysisReplay::fetchEnergies(const uint64_t samplePosition,
+                                   std::vector<float> &destination) const {
+    /// The first frame past the position; the one before it is in effect
+    const auto next = std::upper_bound(positions.begin(), positions.end(),
+                                       samplePosition);
+    if (next == positions.begin()) {
+        destination.clear();
+        return;
+    }
+    const auto frame = static_cast<size_t>(next - positions.begin() - 1);
+    const auto stride = static_cast<size_t>(numClusters);
+    const auto first =
+            energies.begin() + static_cast<std::ptrdiff_t>(frame * stride);
+    destination.assign(first, first + static_cast<std::ptrdiff_t>(stride));
+}
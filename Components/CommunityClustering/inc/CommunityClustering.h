@@ -4,6 +4,7 @@
 #include <vector>
 #include "Centroid.h"
 #include "GraphNode.h"
+#include "Kernels.h"
 
 class CommunityClustering {
 public:
@@ -19,13 +20,62 @@ public:
     static std::vector<int> clusterNodes(const std::vector<GraphNode> &nodes,
                                          int k, int maxIterations = 100);
 
+    /**
+     * @brief Cluster the nodes into k communities, starting from the given
+     * centroids.
+     *
+     * Starting from the previous frame's (or a restored session's) centroids
+     * usually converges in one or two iterations, and keeps cluster indices
+     * stable from frame to frame.
+     *
+     * @param nodes Vector of GraphNode from your spectral graph.
+     * @param centroids The initial centroids, replaced by the final ones. If
+     * it does not hold k centroids, the first k nodes are used instead.
+     * @param k Number of clusters (communities) to form.
+     * @param maxIterations Maximum iterations for convergence.
+     * @param iterationsRun If not null, receives the number of iterations
+     * run.
+     * @param kernels The kernels to measure distances with.
+     * @return A vector of cluster assignments corresponding to each node.
+     */
+    static std::vector<int>
+    clusterNodes(const std::vector<GraphNode> &nodes,
+                 std::vector<Centroid> &centroids, int k,
+                 int maxIterations = 100, int *iterationsRun = nullptr,
+                 const Kernels::Table &kernels = Kernels::get());
+
+    /**
+     * @brief Assign each node to the nearest of some fixed centroids, without
+     * moving them: the assignment step of one k-means iteration.
+     *
+     * Much cheaper than clustering, for frames between full re-clusterings.
+     *
+     * @param nodes Vector of GraphNode from your spectral graph.
+     * @param centroids The centroids, at least one.
+     * @param kernels The kernels to measure distances with.
+     * @return A vector of cluster assignments corresponding to each node.
+     */
+    static std::vector<int>
+    assignNodes(const std::vector<GraphNode> &nodes,
+                const std::vector<Centroid> &centroids,
+                const Kernels::Table &kernels = Kernels::get());
+
 private:
     /// TODO - use log spacing?
     /**
-     *@brief Calculate the squared distance between a node and a centroid.
+     * @brief Map a frequency and magnitude to the space distances are
+     * measured in.
+     *
+     * The squared distance between a node and a centroid is the squared
+     * Euclidean distance between their features.
+     *
+     * @param frequency The frequency in Hz.
+     * @param magnitude The linear magnitude.
+     * @param logFrequency The natural log of the frequency.
+     * @param decibels The magnitude in decibels.
      */
-    static float distanceSquared(const GraphNode &node,
-                                 const Centroid &centroid);
+    static void toFeatures(float frequency, float magnitude,
+                           float &logFrequency, float &decibels);
 };
 
 #endif // COMMUNITY_CLUSTERING_H
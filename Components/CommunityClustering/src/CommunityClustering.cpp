@@ -1,4 +1,5 @@
 #include "CommunityClustering.h"
+#include <cmath>
 #include <random>
 #include <vector>
 
@@ -14,39 +15,65 @@
 std::vector<int>
 CommunityClustering::clusterNodes(const std::vector<GraphNode> &nodes,
                                   const int k, const int maxIterations) {
+    std::vector<Centroid> centroids;
+    return clusterNodes(nodes, centroids, k, maxIterations);
+}
+
+/**
+ * @brief Cluster the nodes into k communities, starting from the given
+ * centroids.
+ *
+ * @param nodes Vector of GraphNode from your spectral graph.
+ * @param centroids The initial centroids, replaced by the final ones.
+ * @param k Number of clusters (communities) to form.
+ * @param maxIterations Maximum iterations for convergence.
+ * @param iterationsRun If not null, receives the number of iterations run.
+ * @param kernels The kernels to measure distances with.
+ * @return A vector of cluster assignments corresponding to each node.
+ */
+std::vector<int>
+CommunityClustering::clusterNodes(const std::vector<GraphNode> &nodes,
+                                  std::vector<Centroid> &centroids,
+                                  const int k, const int maxIterations,
+                                  int *iterationsRun,
+                                  const Kernels::Table &kernels) {
     const int n = static_cast<int>(nodes.size());
     std::vector<int> assignments(n, 0);
+    if (iterationsRun != nullptr)
+        *iterationsRun = 0;
     if (n == 0 || k <= 0)
         return assignments;
-    /// Initialize centroids by picking k nodes (or using a more random
-    /// approach)
-    std::vector<Centroid> centroids;
-    centroids.reserve(k);
-    for (int i = 0; i < k; ++i) {
-        const int idx = i % n;
-        centroids.push_back({nodes[idx].frequency, nodes[idx].magnitude});
+    if (static_cast<int>(centroids.size()) != k) {
+        /// Initialize centroids by picking k nodes (or using a more random
+        /// approach)
+        centroids.clear();
+        centroids.reserve(k);
+        for (int i = 0; i < k; ++i) {
+            const int idx = i % n;
+            centroids.push_back({nodes[idx].frequency, nodes[idx].magnitude});
+        }
     }
 
+    /// Distances are measured in log frequency and decibels. The node
+    /// features never change, so they are computed once.
+    std::vector<float> nodeLogFrequencies(n), nodeDecibels(n);
+    for (int i = 0; i < n; ++i)
+        toFeatures(nodes[i].frequency, nodes[i].magnitude,
+                   nodeLogFrequencies[i], nodeDecibels[i]);
+    std::vector<float> centroidLogFrequencies(k), centroidDecibels(k);
+
     bool changed = true;
     int iterations = 0;
     while (changed && iterations < maxIterations) {
-        changed = false;
         /// Assignment step: assign each node to the nearest centroid.
-        for (int i = 0; i < n; ++i) {
-            int bestCluster = 0;
-            float bestDistance = distanceSquared(nodes[i], centroids[0]);
-            for (int j = 1; j < k; ++j) {
-                const float d = distanceSquared(nodes[i], centroids[j]);
-                if (d < bestDistance) {
-                    bestDistance = d;
-                    bestCluster = j;
-                }
-            }
-            if (assignments[i] != bestCluster) {
-                assignments[i] = bestCluster;
-                changed = true;
-            }
-        }
+        for (int j = 0; j < k; ++j)
+            toFeatures(centroids[j].frequency, centroids[j].magnitude,
+                       centroidLogFrequencies[j], centroidDecibels[j]);
+        changed = kernels.assignNearest(nodeLogFrequencies.data(),
+                                        nodeDecibels.data(), n,
+                                        centroidLogFrequencies.data(),
+                                        centroidDecibels.data(), k,
+                                        assignments.data()) > 0;
 
         /// Update step: recompute centroids.
         std::vector<Centroid> newCentroids(k, {0.0f, 0.0f});
@@ -78,22 +105,49 @@ CommunityClustering::clusterNodes(const std::vector<GraphNode> &nodes,
         iterations++;
     }
 
+    if (iterationsRun != nullptr)
+        *iterationsRun = iterations;
     return assignments;
 }
 
 /**
- *@brief Calculate the squared distance between a node and a centroid.
+ * @brief Assign each node to the nearest of some fixed centroids, without
+ * moving them.
+ * @param nodes Vector of GraphNode from your spectral graph.
+ * @param centroids The centroids, at least one.
+ * @param kernels The kernels to measure distances with.
+ * @return A vector of cluster assignments corresponding to each node.
  */
-float CommunityClustering::distanceSquared(const GraphNode &node,
-                                           const Centroid &centroid) {
-    const float logF_node = std::log(node.frequency + 1e-6f);
-    const float logF_centroid = std::log(centroid.frequency + 1e-6f);
-
-    const float dB_node = 20.0f * std::log10(node.magnitude + 1e-6f);
-    const float dB_centroid = 20.0f * std::log10(centroid.magnitude + 1e-6f);
-
-    const float df = logF_node - logF_centroid;
-    const float dm = dB_node - dB_centroid;
+std::vector<int>
+CommunityClustering::assignNodes(const std::vector<GraphNode> &nodes,
+                                 const std::vector<Centroid> &centroids,
+                                 const Kernels::Table &kernels) {
+    const int n = static_cast<int>(nodes.size());
+    const int k = static_cast<int>(centroids.size());
+    std::vector<int> assignments(n, 0);
+    if (n == 0 || k == 0)
+        return assignments;
+    std::vector<float> nodeLogFrequencies(n), nodeDecibels(n);
+    for (int i = 0; i < n; ++i)
+        toFeatures(nodes[i].frequency, nodes[i].magnitude,
+                   nodeLogFrequencies[i], nodeDecibels[i]);
+    std::vector<float> centroidLogFrequencies(k), centroidDecibels(k);
+    for (int j = 0; j < k; ++j)
+        toFeatures(centroids[j].frequency, centroids[j].magnitude,
+                   centroidLogFrequencies[j], centroidDecibels[j]);
+    kernels.assignNearest(nodeLogFrequencies.data(), nodeDecibels.data(), n,
+                          centroidLogFrequencies.data(),
+                          centroidDecibels.data(), k, assignments.data());
+    return assignments;
+}
 
-    return df * df + dm * dm;
+/**
+ * @brief Map a frequency and magnitude to the space distances are measured
+ * in.
+ */
+void CommunityClustering::toFeatures(const float frequency,
+                                     const float magnitude,
+                                     float &logFrequency, float &decibels) {
+    logFrequency = std::log(frequency + 1e-6f);
+    decibels = 20.0f * std::log10(magnitude + 1e-6f);
 }
@@ -1,6 +1,7 @@
 #ifndef COMMUNITY_REVERB_H
 #define COMMUNITY_REVERB_H
 
+#include <cmath>
 #include <juce_dsp/juce_dsp.h>
 
 /**
@@ -14,13 +15,16 @@ struct CommunityReverb {
     /** Reverb parameters. */
     juce::dsp::Reverb::Parameters params;
 
+    /** Damping every reverb is built with. */
+    static constexpr float defaultDamping = 0.5f;
+
     /**
      * @brief Constructor for the CommunityReverb class.
      */
     CommunityReverb() {
         /// Initialize with some default reverb parameters.
         params.roomSize = 0.5f;
-        params.damping = 0.5f;
+        params.damping = defaultDamping;
         params.wetLevel = 0.33f;
         params.dryLevel = 0.4f;
         params.width = 1.0f;
@@ -47,6 +51,51 @@ struct CommunityReverb {
         reverb.setParameters(params);
     }
 
+    /**
+     * @brief Get the time the longest tail of any reverb takes to decay to a
+     * level.
+     *
+     * The longest tail is at full room size, where juce::Reverb's combs feed
+     * back 0.98 per pass, through its longest comb: 1617 samples at 44.1 kHz,
+     * plus the stereo spread. The delay lines scale with the sample rate, so
+     * the time does not depend on it. Damping only shortens the tail.
+     *
+     * @param level The level, relative to the start of the tail.
+     * @return The time in seconds.
+     */
+    static double getLongestTailSeconds(const float level) {
+        constexpr double maxFeedback = 0.28 + 0.7;
+        constexpr double longestCombSeconds = (1617.0 + 23.0) / 44100.0;
+        return longestCombSeconds * std::log(static_cast<double>(level)) /
+               std::log(maxFeedback);
+    }
+
+    /**
+     * @brief Get the number of bytes a reverb holds at a sample rate.
+     *
+     * Mirrors the comb and all-pass delay line sizes allocated by
+     * juce::Reverb::setSampleRate().
+     *
+     * @param sampleRate The sample rate the reverb is prepared with.
+     * @return The number of bytes.
+     */
+    static size_t getMemoryBytes(const double sampleRate) {
+        static constexpr size_t combTunings[] = {1116, 1188, 1277, 1356,
+                                                 1422, 1491, 1557, 1617};
+        static constexpr size_t allPassTunings[] = {556, 441, 341, 225};
+        static constexpr size_t stereoSpread = 23;
+        const auto intSampleRate = static_cast<size_t>(sampleRate);
+        size_t samples = 0;
+        /// Left channel, then the right channel with the stereo spread added
+        for (const size_t spread: {size_t{0}, stereoSpread}) {
+            for (const size_t tuning: combTunings)
+                samples += intSampleRate * (tuning + spread) / 44100;
+            for (const size_t tuning: allPassTunings)
+                samples += intSampleRate * (tuning + spread) / 44100;
+        }
+        return sizeof(CommunityReverb) + samples * sizeof(float);
+    }
+
     /**
      * @brief Process the provided audio block through the reverb.
      *
@@ -0,0 +1,89 @@
+#ifndef HARMONIC_PERCUSSIVE_SEPARATOR_H
+#define HARMONIC_PERCUSSIVE_SEPARATOR_H
+
+#include <vector>
+#include "RunningMedian.h"
+
+/**
+ * @brief Splits magnitude spectra into harmonic and percussive components by
+ * median filtering (Fitzgerald, 2010).
+ *
+ * Tonal partials are steady over time and percussive transients are flat
+ * over frequency, so a median over the last frames of each bin estimates the
+ * harmonic part and a median across neighbouring bins of a frame estimates
+ * the percussive part. Each bin's magnitude is then shared between the two
+ * with soft masks. The medians are running medians, so a frame costs
+ * O(bins * log window) rather than sorting a window per bin.
+ */
+class HarmonicPercussiveSeparator {
+public:
+    /**
+     * @brief Constructor for the HarmonicPercussiveSeparator.
+     * @param numBins Number of bins per frame.
+     * @param timeWindow Number of frames the harmonic median spans; rounded
+     * up to an odd number.
+     * @param frequencyWindow Number of bins the percussive median spans;
+     * rounded up to an odd number.
+     */
+    explicit HarmonicPercussiveSeparator(int numBins, int timeWindow = 17,
+                                         int frequencyWindow = 17);
+
+    /**
+     * @brief Separate a frame.
+     * @param magnitudes The frame's magnitudes, one per bin.
+     */
+    void process(const std::vector<float> &magnitudes);
+
+    /**
+     * @brief Forget previous frames; the next frame starts the time medians.
+     */
+    void reset() { primed = false; }
+
+    /**
+     * @brief Get the harmonic component of the last frame.
+     * @return One magnitude per bin.
+     */
+    [[nodiscard]] const std::vector<float> &getHarmonic() const {
+        return harmonic;
+    }
+
+    /**
+     * @brief Get the percussive component of the last frame.
+     * @return One magnitude per bin.
+     */
+    [[nodiscard]] const std::vector<float> &getPercussive() const {
+        return percussive;
+    }
+
+    /**
+     * @brief Get the number of bins per frame.
+     * @return The number of bins.
+     */
+    [[nodiscard]] int getNumBins() const {
+        return static_cast<int>(timeMedians.size());
+    }
+
+    /**
+     * @brief Get the number of bytes held by the separator.
+     * @return The approximate number of bytes.
+     */
+    [[nodiscard]] size_t getMemoryBytes() const;
+
+private:
+    /** Median over time of each bin */
+    std::vector<RunningMedian> timeMedians;
+
+    /** Median over frequency, slid across each frame */
+    RunningMedian frequencyMedian;
+
+    /** Harmonic component of the last frame */
+    std::vector<float> harmonic;
+
+    /** Percussive component of the last frame */
+    std::vector<float> percussive;
+
+    /** Whether the time medians hold previous frames */
+    bool primed = false;
+};
+
+#endif // HARMONIC_PERCUSSIVE_SEPARATOR_H
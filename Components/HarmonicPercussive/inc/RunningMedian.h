@@ -0,0 +1,101 @@
+#ifndef RUNNING_MEDIAN_H
+#define RUNNING_MEDIAN_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Median of the last few values of a stream, updated in O(log w) per
+ * value for a window of w values.
+ *
+ * The window is kept in two heaps over the same slots: a max-heap of the
+ * lower half and a min-heap of the upper half, so the median is at their
+ * roots. A new value overwrites the oldest slot in place and is sifted within
+ * its heap, and at most one swap of the roots restores the split, instead of
+ * sorting the window again. Nothing is allocated after construction.
+ */
+class RunningMedian {
+public:
+    /**
+     * @brief Constructor for the RunningMedian.
+     * @param windowSize Number of values the median is taken over, at least 1.
+     */
+    explicit RunningMedian(int windowSize);
+
+    /**
+     * @brief Fill the whole window with one value.
+     * @param value The value.
+     */
+    void reset(float value = 0.0f);
+
+    /**
+     * @brief Replace the oldest value in the window.
+     * @param value The new value.
+     * @return The median of the window, including the new value.
+     */
+    float push(float value);
+
+    /**
+     * @brief Get the median of the window.
+     * @return The median; the mean of the middle two for an even window.
+     */
+    [[nodiscard]] float getMedian() const;
+
+    /**
+     * @brief Get the number of values the median is taken over.
+     * @return The window size.
+     */
+    [[nodiscard]] int getWindowSize() const { return windowSize; }
+
+    /**
+     * @brief Get the number of bytes held by the window.
+     * @return The number of bytes.
+     */
+    [[nodiscard]] size_t getMemoryBytes() const {
+        return values.capacity() * sizeof(float) +
+               (heap.capacity() + position.capacity()) * sizeof(int);
+    }
+
+private:
+    /** Number of values in the window */
+    int windowSize;
+
+    /** Size of the lower half, the max-heap at the start of heap */
+    int lowerSize;
+
+    /** Slot the next value overwrites */
+    int oldest = 0;
+
+    /** Value in each slot */
+    std::vector<float> values;
+
+    /** Slots ordered as the two heaps: the lower half's max-heap in
+     * [0, lowerSize), then the upper half's min-heap */
+    std::vector<int> heap;
+
+    /** Index in heap of each slot */
+    std::vector<int> position;
+
+    /**
+     * @brief Check if one heap entry belongs above another.
+     * @param a Index in heap of the first entry.
+     * @param b Index in heap of the second entry.
+     * @return True if a belongs above b in the heap holding both.
+     */
+    [[nodiscard]] bool isAbove(int a, int b) const;
+
+    /**
+     * @brief Swap two heap entries and their slots' positions.
+     * @param a Index in heap of the first entry.
+     * @param b Index in heap of the second entry.
+     */
+    void swapEntries(int a, int b);
+
+    /**
+     * @brief Move an entry up or down its heap until the heap is ordered.
+     * @param index Index in heap of the entry.
+     */
+    void sift(int index);
+};
+
+#endif // RUNNING_MEDIAN_H
@@ -0,0 +1,72 @@
+#include "HarmonicPercussiveSeparator.h"
+
+#include <algorithm>
+
+/**
+ * @brief Constructor for the HarmonicPercussiveSeparator.
+ * @param numBins Number of bins per frame.
+ * @param timeWindow Number of frames the harmonic median spans.
+ * @param frequencyWindow Number of bins the percussive median spans.
+ */
+HarmonicPercussiveSeparator::HarmonicPercussiveSeparator(
+        const int numBins, const int timeWindow, const int frequencyWindow) :
+    timeMedians(static_cast<size_t>(std::max(0, numBins)),
+                RunningMedian(timeWindow | 1)),
+    frequencyMedian(frequencyWindow | 1),
+    harmonic(static_cast<size_t>(std::max(0, numBins))),
+    percussive(static_cast<size_t>(std::max(0, numBins))) {}
+
+/**
+ * @brief Separate a frame.
+ * @param magnitudes The frame's magnitudes, one per bin.
+ */
+void HarmonicPercussiveSeparator::process(
+        const std::vector<float> &magnitudes) {
+    const int numBins = std::min(getNumBins(),
+                                 static_cast<int>(magnitudes.size()));
+    if (numBins == 0)
+        return;
+    /// Start every bin's history from the first frame rather than silence,
+    /// which would make everything look percussive for half a window
+    if (!primed) {
+        for (int k = 0; k < numBins; ++k)
+            timeMedians[k].reset(magnitudes[k]);
+        primed = true;
+    }
+
+    /// The frequency window is centred on each bin, so it runs half a window
+    /// ahead; the edges repeat the first and last bins
+    const int half = frequencyMedian.getWindowSize() / 2;
+    frequencyMedian.reset(magnitudes[0]);
+    for (int k = 1; k <= half; ++k)
+        frequencyMedian.push(magnitudes[std::min(k, numBins - 1)]);
+
+    for (int k = 0; k < numBins; ++k) {
+        const float harmonicEstimate = timeMedians[k].push(magnitudes[k]);
+        const float percussiveEstimate =
+                k == 0 ? frequencyMedian.getMedian()
+                       : frequencyMedian.push(
+                                 magnitudes[std::min(k + half, numBins - 1)]);
+        /// Soft (Wiener) masks, so the components add up to the input
+        const float h2 = harmonicEstimate * harmonicEstimate;
+        const float p2 = percussiveEstimate * percussiveEstimate;
+        const float total = h2 + p2;
+        const float mask = total > 0.0f ? h2 / total : 0.5f;
+        harmonic[k] = magnitudes[k] * mask;
+        percussive[k] = magnitudes[k] - harmonic[k];
+    }
+}
+
+/**
+ * @brief Get the number of bytes held by the separator.
+ * @return The approximate number of bytes.
+ */
+size_t HarmonicPercussiveSeparator::getMemoryBytes() const {
+    size_t bytes = sizeof(HarmonicPercussiveSeparator) +
+                   frequencyMedian.getMemoryBytes() +
+                   (harmonic.capacity() + percussive.capacity()) *
+                           sizeof(float);
+    for (const auto &median: timeMedians)
+        bytes += sizeof(RunningMedian) + median.getMemoryBytes();
+    return bytes;
+}
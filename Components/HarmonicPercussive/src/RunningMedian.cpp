@@ -0,0 +1,112 @@
+#include "RunningMedian.h"
+
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+/**
+ * @brief Constructor for the RunningMedian.
+ * @param windowSize Number of values the median is taken over, at least 1.
+ */
+RunningMedian::RunningMedian(const int windowSize) :
+    windowSize(std::max(1, windowSize)), lowerSize((this->windowSize + 1) / 2),
+    values(static_cast<size_t>(this->windowSize)),
+    heap(static_cast<size_t>(this->windowSize)),
+    position(static_cast<size_t>(this->windowSize)) {
+    reset();
+}
+
+/**
+ * @brief Fill the whole window with one value.
+ * @param value The value.
+ */
+void RunningMedian::reset(const float value) {
+    /// Equal values satisfy both heaps in any order
+    std::ranges::fill(values, value);
+    std::iota(heap.begin(), heap.end(), 0);
+    std::iota(position.begin(), position.end(), 0);
+    oldest = 0;
+}
+
+/**
+ * @brief Replace the oldest value in the window.
+ * @param value The new value.
+ * @return The median of the window, including the new value.
+ */
+float RunningMedian::push(const float value) {
+    const int slot = oldest;
+    oldest = oldest + 1 < windowSize ? oldest + 1 : 0;
+    values[slot] = value;
+    sift(position[slot]);
+    /// Only the changed value can be on the wrong side of the split, and it
+    /// is now at the root of its heap, so one swap of the roots fixes it
+    if (lowerSize < windowSize &&
+        values[heap[0]] > values[heap[lowerSize]]) {
+        swapEntries(0, lowerSize);
+        sift(0);
+        sift(lowerSize);
+    }
+    return getMedian();
+}
+
+/**
+ * @brief Get the median of the window.
+ * @return The median; the mean of the middle two for an even window.
+ */
+float RunningMedian::getMedian() const {
+    if (windowSize % 2 == 1)
+        return values[heap[0]];
+    return 0.5f * (values[heap[0]] + values[heap[lowerSize]]);
+}
+
+/**
+ * @brief Check if one heap entry belongs above another.
+ * @param a Index in heap of the first entry.
+ * @param b Index in heap of the second entry.
+ * @return True if a belongs above b in the heap holding both.
+ */
+bool RunningMedian::isAbove(const int a, const int b) const {
+    if (a < lowerSize)
+        return values[heap[a]] > values[heap[b]];
+    return values[heap[a]] < values[heap[b]];
+}
+
+/**
+ * @brief Swap two heap entries and their slots' positions.
+ * @param a Index in heap of the first entry.
+ * @param b Index in heap of the second entry.
+ */
+void RunningMedian::swapEntries(const int a, const int b) {
+    std::swap(heap[a], heap[b]);
+    position[heap[a]] = a;
+    position[heap[b]] = b;
+}
+
+/**
+ * @brief Move an entry up or down its heap until the heap is ordered.
+ * @param index Index in heap of the entry.
+ */
+void RunningMedian::sift(const int index) {
+    const bool lower = index < lowerSize;
+    const int base = lower ? 0 : lowerSize;
+    const int size = lower ? lowerSize : windowSize - lowerSize;
+    int local = index - base;
+    while (local > 0) {
+        const int parent = (local - 1) / 2;
+        if (!isAbove(base + local, base + parent))
+            break;
+        swapEntries(base + local, base + parent);
+        local = parent;
+    }
+    while (true) {
+        int child = 2 * local + 1;
+        if (child >= size)
+            break;
+        if (child + 1 < size && isAbove(base + child + 1, base + child))
+            ++child;
+        if (!isAbove(base + child, base + local))
+            break;
+        swapEntries(base + child, base + local);
+        local = child;
+    }
+}
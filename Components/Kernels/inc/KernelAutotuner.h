@@ -0,0 +1,152 @@
+#ifndef KERNEL_AUTOTUNER_H
+#define KERNEL_AUTOTUNER_H
+
+#include <array>
+#include <cstdint>
+#include <juce_core/juce_core.h>
+#include <optional>
+#include "Kernels.h"
+
+/**
+ * @brief Picks the fastest variant of each kernel on this machine.
+ *
+ * The tuner times every available variant of every kernel at the sizes the
+ * processor actually uses and keeps the fastest. The choices are persisted in
+ * a small JSON cache keyed by CPU model and configuration, so only the first
+ * instance on a machine pays for tuning, on a background thread; later
+ * instances, and later runs, use the cached choice straight away. Each caller
+ * gets the table of its own configuration, so instances prepared differently
+ * in one process each run their own choice.
+ */
+class KernelAutotuner {
+public:
+    /**
+     * @brief The processing configuration the kernels are tuned for.
+     */
+    struct Config {
+        double sampleRate = 48000.0;
+        int blockSize = 512;
+        int fftSize = 1024;
+        int numClusters = 12;
+    };
+
+    /** The instruction set chosen for each kernel, in Kernels::Table order. */
+    using Choice = std::array<Kernels::Isa, Kernels::numKernels>;
+
+    /**
+     * @brief The fastest call of each variant of each kernel, in seconds,
+     * indexed by kernel then instruction set. Zero if a variant was not timed.
+     */
+    using Timings =
+            std::array<std::array<double, static_cast<size_t>(
+                                                  Kernels::Isa::count)>,
+                       Kernels::numKernels>;
+
+    /**
+     * @brief Get the kernels cached for a configuration, or queue it for
+     * tuneIfPending() if there are none.
+     *
+     * Does nothing when GRAPHVERB_FORCE_ISA is set. A configuration is only
+     * read from the cache once per process, so hosts may call this from
+     * every prepareToPlay(). Until a queued configuration is tuned, callers
+     * keep the kernels they have, e.g. Kernels::get(), and find() returns
+     * its table once it is. Reads the cache file, so not for the audio
+     * thread.
+     *
+     * @param config The configuration.
+     * @param cacheFile The cache file.
+     * @return The configuration's kernels, or nullptr if the variant was
+     * forced or the configuration is waiting to be tuned.
+     */
+    static const Kernels::Table *
+    prepare(const Config &config,
+            const juce::File &cacheFile = getDefaultCacheFile());
+
+    /**
+     * @brief Get the kernels of a configuration already loaded or tuned in
+     * this process. Never reads the cache file; not for the audio thread.
+     * @param config The configuration.
+     * @return The configuration's kernels, or nullptr if there are none yet.
+     */
+    static const Kernels::Table *find(const Config &config);
+
+    /**
+     * @brief Tune and cache one configuration queued by prepare(), if any.
+     *
+     * Tuning takes a few tens of milliseconds and writes the cache, so this
+     * belongs on a background thread. Cheap when nothing is queued, and safe
+     * to call from several threads at once; only one of them tunes.
+     *
+     * @return True if a configuration was tuned.
+     */
+    static bool tuneIfPending();
+
+    /**
+     * @brief Get the number of tuned choices tuneIfPending() could not write
+     * to their cache, e.g. because it is read-only. Their configurations are
+     * tuned again by the next process.
+     * @return The number of failed writes.
+     */
+    static uint64_t getNumFailedSaves();
+
+    /**
+     * @brief Time every variant of every kernel and pick the fastest.
+     * @param config The configuration.
+     * @param secondsPerCandidate How long to time each variant of a kernel.
+     * @param timings If not null, receives the timing of every variant.
+     * @return The fastest variant of each kernel.
+     */
+    static Choice tune(const Config &config,
+                       double secondsPerCandidate = 0.002,
+                       Timings *timings = nullptr);
+
+    /**
+     * @brief Look a configuration up in the cache.
+     * @param cacheFile The cache file.
+     * @param config The configuration.
+     * @return The cached choice, or nothing if this CPU and configuration
+     * have not been tuned or a cached variant is unavailable.
+     */
+    static std::optional<Choice> load(const juce::File &cacheFile,
+                                      const Config &config);
+
+    /**
+     * @brief Add or replace a configuration in the cache.
+     * @param cacheFile The cache file.
+     * @param config The configuration.
+     * @param choice The choice to store.
+     * @return True if the cache was written.
+     */
+    static bool save(const juce::File &cacheFile, const Config &config,
+                     const Choice &choice);
+
+    /**
+     * @brief Get the default location of the cache.
+     * @return The cache file in the user's application data directory.
+     */
+    static juce::File getDefaultCacheFile();
+
+    /**
+     * @brief Get the name of a kernel, as used in the cache.
+     * @param kernel The kernel's index in Kernels::Table order.
+     * @return The kernel name.
+     */
+    static const char *getKernelName(int kernel);
+
+private:
+    /**
+     * @brief Get the key identifying this CPU in the cache.
+     * @return The CPU vendor and model.
+     */
+    static juce::String getCpuKey();
+
+    /**
+     * @brief Get the key identifying a configuration in the cache. Block
+     * sizes are rounded up to a power of two.
+     * @param config The configuration.
+     * @return The configuration key.
+     */
+    static juce::String getConfigKey(const Config &config);
+};
+
+#endif // KERNEL_AUTOTUNER_H
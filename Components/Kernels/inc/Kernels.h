@@ -0,0 +1,198 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <array>
+
+/**
+ * @brief Hot DSP kernels, compiled once per instruction set and dispatched at
+ * runtime.
+ *
+ * Every variant is built into the same binary with its own compile flags. The
+ * best variant the CPU supports is picked the first time get() is called.
+ * Setting the GRAPHVERB_FORCE_ISA environment variable to one of the names
+ * returned by getName() forces a variant, for testing; an unsupported or
+ * unknown name falls back to the automatic choice. Tables mixing variants,
+ * e.g. for the autotuner, come from combine() and are used by whoever holds
+ * them; get() is never replaced.
+ */
+namespace Kernels {
+    /**
+     * @brief The instruction sets a kernel variant can be compiled for.
+     */
+    enum class Isa { scalar, sse2, avx2, avx512, neon, count };
+
+    /**
+     * @brief A bank of complex resonators, one array per field, as updated by
+     * Table::resonate.
+     *
+     * Each sample, a mode's state z = re + j im is multiplied by its pole and
+     * driven by the input: z = pole * z + inputGain * in. The bank's output is
+     * the sum of outputGain * im over the modes.
+     */
+    struct ModeBank {
+        /** Real part of each mode's state, updated in place */
+        float *re;
+        /** Imaginary part of each mode's state, updated in place */
+        float *im;
+        /** Real part of each mode's pole */
+        const float *poleRe;
+        /** Imaginary part of each mode's pole */
+        const float *poleIm;
+        /** Gain of the input into each mode */
+        const float *inputGains;
+        /** Gain of each mode in the output */
+        const float *outputGains;
+        /** Number of modes */
+        int numModes;
+    };
+
+    /**
+     * @brief One variant of every kernel.
+     */
+    struct Table {
+        /**
+         * @brief Multiply two arrays element-wise, e.g. to apply a window.
+         * @param dst The output; may alias a.
+         * @param a The first input.
+         * @param b The second input.
+         * @param n The number of elements.
+         */
+        void (*multiply)(float *dst, const float *a, const float *b, int n);
+
+        /**
+         * @brief Compute magnitudes of interleaved complex values.
+         * @param dst The output, one magnitude per bin.
+         * @param interleaved The input, real and imaginary parts interleaved.
+         * @param numBins The number of complex values.
+         */
+        void (*magnitudes)(float *dst, const float *interleaved, int numBins);
+
+        /**
+         * @brief Assign each point to the nearest centroid.
+         * @param xs The first coordinate of each point.
+         * @param ys The second coordinate of each point.
+         * @param n The number of points.
+         * @param cxs The first coordinate of each centroid.
+         * @param cys The second coordinate of each centroid.
+         * @param k The number of centroids.
+         * @param assignments The current assignments, updated in place.
+         * @return The number of assignments that changed.
+         */
+        int (*assignNearest)(const float *xs, const float *ys, int n,
+                             const float *cxs, const float *cys, int k,
+                             int *assignments);
+
+        /**
+         * @brief Accumulate a weighted array: dst += weight * src.
+         * @param dst The accumulator.
+         * @param src The input.
+         * @param weight The weight.
+         * @param n The number of elements.
+         */
+        void (*addWeighted)(float *dst, const float *src, float weight, int n);
+
+        /**
+         * @brief Mix dry and wet signals, apply gain and soft clip:
+         * out = tanh(gain * (dryGain * out + wetGain * wet)).
+         *
+         * The SIMD variants use a rational tanh approximation that is within
+         * a few ulp of std::tanh.
+         *
+         * @param out The dry signal, overwritten with the result.
+         * @param wet The wet signal.
+         * @param dryGain The dry level.
+         * @param wetGain The wet level.
+         * @param gain The output gain.
+         * @param n The number of samples.
+         */
+        void (*mixAndClip)(float *out, const float *wet, float dryGain,
+                           float wetGain, float gain, int n);
+
+        /**
+         * @brief Run a bank of complex resonators over a block of input.
+         *
+         * The SIMD variants update one vector of modes at a time, so a bank
+         * padded with silent modes to a multiple of 16 only ever runs full
+         * vectors. Variants sum the modes in different orders.
+         *
+         * @param bank The resonators, whose state is updated.
+         * @param in The input, driving every mode.
+         * @param out The output, overwritten with the bank's output.
+         * @param numSamples The number of samples.
+         */
+        void (*resonate)(const ModeBank &bank, const float *in, float *out,
+                         int numSamples);
+    };
+
+    /** Number of kernels in a table. */
+    constexpr int numKernels = 6;
+
+    /**
+     * @brief Get the kernels picked automatically or forced with
+     * GRAPHVERB_FORCE_ISA.
+     *
+     * Callers on the audio thread should fetch the table once per block.
+     *
+     * @return The kernel table.
+     */
+    const Table &get();
+
+    /**
+     * @brief Get the instruction set picked automatically or forced with
+     * GRAPHVERB_FORCE_ISA.
+     * @return The instruction set.
+     */
+    Isa getActiveIsa();
+
+    /**
+     * @brief Check if GRAPHVERB_FORCE_ISA selected the active variant.
+     * @return True if the variant was forced.
+     */
+    bool isForced();
+
+    /**
+     * @brief Check if GRAPHVERB_FORCE_ISA named a variant that is unknown,
+     * not compiled in or not supported by the CPU, and was ignored in favour
+     * of the automatic choice.
+     * @return True if the forced variant was ignored.
+     */
+    bool isForceRejected();
+
+    /**
+     * @brief Get a table taking each kernel from a chosen variant.
+     *
+     * Each distinct combination is built once and kept for the rest of the
+     * process, so the table may be held and shared freely, and asking for a
+     * combination again costs a lookup. Not for the audio thread.
+     *
+     * @param isas The instruction set for each kernel, in Table order.
+     * @return The table, or nullptr if one of the variants is unavailable.
+     */
+    const Table *combine(const std::array<Isa, numKernels> &isas);
+
+    /**
+     * @brief Get the kernels compiled for an instruction set.
+     * @param isa The instruction set.
+     * @return The kernel table, or nullptr if the variant was not compiled
+     * into this binary or the CPU does not support it.
+     */
+    const Table *getTable(Isa isa);
+
+    /**
+     * @brief Get the name of an instruction set.
+     * @param isa The instruction set.
+     * @return The name, e.g. "avx2".
+     */
+    const char *getName(Isa isa);
+
+    namespace detail {
+        /** Variants, one per translation unit; nullptr if not compiled. */
+        const Table *getScalarTable();
+        const Table *getSse2Table();
+        const Table *getAvx2Table();
+        const Table *getAvx512Table();
+        const Table *getNeonTable();
+    } // namespace detail
+} // namespace Kernels
+
+#endif // KERNELS_H
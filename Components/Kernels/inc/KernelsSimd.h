@@ -0,0 +1,243 @@
+#ifndef KERNELS_SIMD_H
+#define KERNELS_SIMD_H
+
+#include "Kernels.h"
+
+/**
+ * @brief Kernel bodies shared by the SIMD variants.
+ *
+ * Each variant's translation unit defines a vector traits type V in an
+ * anonymous namespace and instantiates these templates with it. V provides
+ * Reg, width, load, store, set1, add, sub, mul, div, fma (a * b + c), sqrt, min,
+ * max, less, select (mask ? a : b) and loadDeinterleaved.
+ *
+ * Everything here is a template on V, and nothing calls into the standard
+ * library, so no inline function is ever emitted with one variant's compile
+ * flags and then picked by the linker for another variant or for the rest of
+ * the plugin.
+ */
+namespace KernelsSimd {
+    /**
+     * @brief Load fewer than V::width values, padding with zeros.
+     * @param src The values.
+     * @param count The number of values to load.
+     * @return The padded register.
+     */
+    template<typename V>
+    typename V::Reg loadPartial(const float *src, const int count) {
+        float padded[V::width] = {};
+        for (int i = 0; i < count; ++i)
+            padded[i] = src[i];
+        return V::load(padded);
+    }
+
+    /**
+     * @brief Store the first values of a register.
+     * @param dst The destination.
+     * @param value The register.
+     * @param count The number of values to store.
+     */
+    template<typename V>
+    void storePartial(float *dst, const typename V::Reg value,
+                      const int count) {
+        float padded[V::width];
+        V::store(padded, value);
+        for (int i = 0; i < count; ++i)
+            dst[i] = padded[i];
+    }
+
+    /**
+     * @brief Rational approximation of tanh, accurate to a few ulp.
+     * @param x The input.
+     * @return tanh(x).
+     */
+    template<typename V>
+    typename V::Reg tanh(typename V::Reg x) {
+        /// Beyond this tanh rounds to +/-1 in single precision
+        const auto limit = V::set1(7.90531110763549805f);
+        x = V::max(V::min(x, limit), V::set1(-7.90531110763549805f));
+        const auto x2 = V::mul(x, x);
+        auto p = V::fma(x2, V::set1(-2.76076847742355e-16f),
+                        V::set1(2.00018790482477e-13f));
+        p = V::fma(x2, p, V::set1(-8.60467152213735e-11f));
+        p = V::fma(x2, p, V::set1(5.12229709037114e-08f));
+        p = V::fma(x2, p, V::set1(1.48572235717979e-05f));
+        p = V::fma(x2, p, V::set1(6.37261928875436e-04f));
+        p = V::fma(x2, p, V::set1(4.89352455891786e-03f));
+        p = V::mul(x, p);
+        auto q = V::fma(x2, V::set1(1.19825839466702e-06f),
+                        V::set1(1.18534705686654e-04f));
+        q = V::fma(x2, q, V::set1(2.26843463243900e-03f));
+        q = V::fma(x2, q, V::set1(4.89352518554385e-03f));
+        return V::div(p, q);
+    }
+
+    template<typename V>
+    void multiply(float *dst, const float *a, const float *b, const int n) {
+        int i = 0;
+        for (; i + V::width <= n; i += V::width)
+            V::store(dst + i, V::mul(V::load(a + i), V::load(b + i)));
+        if (i < n)
+            storePartial<V>(dst + i,
+                            V::mul(loadPartial<V>(a + i, n - i),
+                                   loadPartial<V>(b + i, n - i)),
+                            n - i);
+    }
+
+    template<typename V>
+    void magnitudes(float *dst, const float *interleaved, const int numBins) {
+        int i = 0;
+        typename V::Reg re, im;
+        for (; i + V::width <= numBins; i += V::width) {
+            V::loadDeinterleaved(interleaved + 2 * i, re, im);
+            V::store(dst + i, V::sqrt(V::fma(re, re, V::mul(im, im))));
+        }
+        if (i < numBins) {
+            float padded[2 * V::width] = {};
+            for (int j = 0; j < 2 * (numBins - i); ++j)
+                padded[j] = interleaved[2 * i + j];
+            V::loadDeinterleaved(padded, re, im);
+            storePartial<V>(dst + i, V::sqrt(V::fma(re, re, V::mul(im, im))),
+                            numBins - i);
+        }
+    }
+
+    template<typename V>
+    int assignNearest(const float *xs, const float *ys, const int n,
+                      const float *cxs, const float *cys, const int k,
+                      int *assignments) {
+        int changed = 0;
+        for (int i = 0; i < n; i += V::width) {
+            const int count = n - i < V::width ? n - i : V::width;
+            const bool full = count == V::width;
+            const auto x = full ? V::load(xs + i) : loadPartial<V>(xs + i, count);
+            const auto y = full ? V::load(ys + i) : loadPartial<V>(ys + i, count);
+            auto dx = V::sub(x, V::set1(cxs[0]));
+            auto dy = V::sub(y, V::set1(cys[0]));
+            auto best = V::fma(dx, dx, V::mul(dy, dy));
+            auto bestIndex = V::set1(0.0f);
+            for (int j = 1; j < k; ++j) {
+                dx = V::sub(x, V::set1(cxs[j]));
+                dy = V::sub(y, V::set1(cys[j]));
+                const auto d = V::fma(dx, dx, V::mul(dy, dy));
+                /// Strictly less, so the first of equal centroids wins
+                const auto closer = V::less(d, best);
+                best = V::select(closer, d, best);
+                bestIndex = V::select(closer, V::set1(static_cast<float>(j)),
+                                      bestIndex);
+            }
+            float indices[V::width];
+            V::store(indices, bestIndex);
+            for (int l = 0; l < count; ++l) {
+                const int index = static_cast<int>(indices[l]);
+                if (assignments[i + l] != index) {
+                    assignments[i + l] = index;
+                    ++changed;
+                }
+            }
+        }
+        return changed;
+    }
+
+    template<typename V>
+    void addWeighted(float *dst, const float *src, const float weight,
+                     const int n) {
+        const auto w = V::set1(weight);
+        int i = 0;
+        for (; i + V::width <= n; i += V::width)
+            V::store(dst + i, V::fma(w, V::load(src + i), V::load(dst + i)));
+        if (i < n)
+            storePartial<V>(dst + i,
+                            V::fma(w, loadPartial<V>(src + i, n - i),
+                                   loadPartial<V>(dst + i, n - i)),
+                            n - i);
+    }
+
+    template<typename V>
+    void mixAndClip(float *out, const float *wet, const float dryGain,
+                    const float wetGain, const float gain, const int n) {
+        const auto dry = V::set1(dryGain);
+        const auto wetLevel = V::set1(wetGain);
+        const auto outputGain = V::set1(gain);
+        int i = 0;
+        for (; i + V::width <= n; i += V::width) {
+            const auto mixed = V::fma(dry, V::load(out + i),
+                                      V::mul(wetLevel, V::load(wet + i)));
+            V::store(out + i, tanh<V>(V::mul(mixed, outputGain)));
+        }
+        if (i < n) {
+            const auto mixed =
+                    V::fma(dry, loadPartial<V>(out + i, n - i),
+                           V::mul(wetLevel, loadPartial<V>(wet + i, n - i)));
+            storePartial<V>(out + i, tanh<V>(V::mul(mixed, outputGain)),
+                            n - i);
+        }
+    }
+
+    template<typename V>
+    void resonate(const Kernels::ModeBank &bank, const float *in, float *out,
+                  const int numSamples) {
+        /// Samples per run: each vector of modes stays in registers for a
+        /// run, summing into one partial output vector per sample
+        constexpr int runLength = 32;
+        for (int start = 0; start < numSamples; start += runLength) {
+            const int run = numSamples - start < runLength ? numSamples - start
+                                                           : runLength;
+            typename V::Reg sums[runLength];
+            for (int s = 0; s < run; ++s)
+                sums[s] = V::set1(0.0f);
+            for (int m = 0; m < bank.numModes; m += V::width) {
+                const int count = bank.numModes - m < V::width
+                                          ? bank.numModes - m
+                                          : V::width;
+                const bool full = count == V::width;
+                /// Padding lanes have no gain and a zero pole, so stay silent
+                const auto load = [m, count, full](const float *p) {
+                    return full ? V::load(p + m) : loadPartial<V>(p + m, count);
+                };
+                auto re = load(bank.re);
+                auto im = load(bank.im);
+                const auto poleRe = load(bank.poleRe);
+                const auto poleIm = load(bank.poleIm);
+                const auto inputGain = load(bank.inputGains);
+                const auto outputGain = load(bank.outputGains);
+                for (int s = 0; s < run; ++s) {
+                    const auto drive =
+                            V::mul(inputGain, V::set1(in[start + s]));
+                    const auto nextRe = V::fma(
+                            poleRe, re, V::sub(drive, V::mul(poleIm, im)));
+                    im = V::fma(poleIm, re, V::mul(poleRe, im));
+                    re = nextRe;
+                    sums[s] = V::fma(outputGain, im, sums[s]);
+                }
+                if (full) {
+                    V::store(bank.re + m, re);
+                    V::store(bank.im + m, im);
+                } else {
+                    storePartial<V>(bank.re + m, re, count);
+                    storePartial<V>(bank.im + m, im, count);
+                }
+            }
+            for (int s = 0; s < run; ++s) {
+                float lanes[V::width];
+                V::store(lanes, sums[s]);
+                float sum = 0.0f;
+                for (const float lane: lanes)
+                    sum += lane;
+                out[start + s] = sum;
+            }
+        }
+    }
+
+    /**
+     * @brief Build the kernel table for a variant.
+     * @return The kernel table.
+     */
+    template<typename V>
+    Kernels::Table makeTable() {
+        return {multiply<V>, magnitudes<V>, assignNearest<V>, addWeighted<V>,
+                mixAndClip<V>, resonate<V>};
+    }
+} // namespace KernelsSimd
+
+#endif // KERNELS_SIMD_H
@@ -0,0 +1,397 @@
+#include "KernelAutotuner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace {
+    /** Version of the cache layout; other versions are ignored */
+    constexpr int cacheVersion = 1;
+
+    /** Modes in the resonator bank timed, about one channel's worth */
+    constexpr int numTimedModes = 1024;
+
+    /** A variant must beat the current best by this factor to replace it */
+    constexpr double improvementThreshold = 0.98;
+
+    /** Serialises prepare() across instances */
+    std::mutex prepareMutex;
+
+    /** Choices already loaded or tuned in this process, by configuration
+     * key */
+    std::map<juce::String, KernelAutotuner::Choice> preparedChoices;
+
+    /**
+     * @brief A configuration with no cached choice, waiting to be tuned.
+     */
+    struct PendingTune {
+        KernelAutotuner::Config config;
+        juce::File cacheFile;
+    };
+
+    /** Configurations waiting to be tuned, by configuration key */
+    std::map<juce::String, PendingTune> pendingTunes;
+
+    /** Whether pendingTunes holds anything, checked without the mutex */
+    std::atomic<bool> tunePending{false};
+
+    /** Serialises tuning, so only one thread times the kernels at once */
+    std::mutex tuneMutex;
+
+    /** Number of tuned choices tuneIfPending() could not write to a cache */
+    std::atomic<uint64_t> failedSaves{0};
+
+    /**
+     * @brief Inputs and outputs for timing the kernels at one configuration.
+     */
+    struct Workload {
+        explicit Workload(const KernelAutotuner::Config &config) :
+            config(config) {
+            juce::Random random(1);
+            const auto fill = [&random](std::vector<float> &values,
+                                        const size_t size, const float scale) {
+                values.resize(size);
+                for (float &value: values)
+                    value = scale * (2.0f * random.nextFloat() - 1.0f);
+            };
+            const auto fftSize = static_cast<size_t>(config.fftSize);
+            const size_t size = std::max(
+                    2 * fftSize, static_cast<size_t>(config.blockSize));
+            fill(a, size, 1.0f);
+            fill(b, size, 1.0f);
+            fill(out, size, 0.0f);
+            fill(xs, fftSize / 2, 5.0f);
+            fill(ys, fftSize / 2, 60.0f);
+            fill(cxs, static_cast<size_t>(config.numClusters), 5.0f);
+            fill(cys, static_cast<size_t>(config.numClusters), 60.0f);
+            assignments.assign(fftSize / 2, 0);
+            /// Poles well inside the unit circle, so the state stays finite
+            const auto modes = static_cast<size_t>(numTimedModes);
+            fill(modeRe, modes, 0.0f);
+            fill(modeIm, modes, 0.0f);
+            fill(poleRe, modes, 0.7f);
+            fill(poleIm, modes, 0.7f);
+            fill(inputGains, modes, 1.0f);
+            fill(outputGains, modes, 1.0f);
+        }
+
+        /**
+         * @brief Run one kernel of a table once.
+         * @param table The kernel table.
+         * @param kernel The kernel's index in Kernels::Table order.
+         */
+        void run(const Kernels::Table &table, const int kernel) {
+            const int fftSize = config.fftSize;
+            switch (kernel) {
+                case 0:
+                    table.multiply(out.data(), a.data(), b.data(), fftSize);
+                    break;
+                case 1:
+                    table.magnitudes(out.data(), a.data(), fftSize / 2 - 1);
+                    break;
+                case 2:
+                    table.assignNearest(xs.data(), ys.data(), fftSize / 2,
+                                        cxs.data(), cys.data(),
+                                        config.numClusters,
+                                        assignments.data());
+                    break;
+                case 3:
+                    table.addWeighted(out.data(), a.data(), 0.5f,
+                                      config.blockSize);
+                    break;
+                case 4:
+                    table.mixAndClip(out.data(), a.data(), 0.5f, 0.5f, 1.0f,
+                                     config.blockSize);
+                    break;
+                default:
+                    table.resonate({modeRe.data(), modeIm.data(),
+                                    poleRe.data(), poleIm.data(),
+                                    inputGains.data(), outputGains.data(),
+                                    numTimedModes},
+                                   a.data(), out.data(), config.blockSize);
+                    break;
+            }
+        }
+
+        /**
+         * @brief Time one kernel of a table.
+         * @param table The kernel table.
+         * @param kernel The kernel's index in Kernels::Table order.
+         * @param seconds How long to keep timing.
+         * @return The fastest call, in seconds.
+         */
+        double time(const Kernels::Table &table, const int kernel,
+                    const double seconds) {
+            using Clock = std::chrono::steady_clock;
+            run(table, kernel);
+            double fastest = std::numeric_limits<double>::max();
+            const auto deadline =
+                    Clock::now() + std::chrono::duration_cast<Clock::duration>(
+                                           std::chrono::duration<double>(
+                                                   seconds));
+            Clock::time_point end;
+            do {
+                const auto start = Clock::now();
+                run(table, kernel);
+                end = Clock::now();
+                fastest = std::min(
+                        fastest,
+                        std::chrono::duration<double>(end - start).count());
+            } while (end < deadline);
+            return fastest;
+        }
+
+        KernelAutotuner::Config config;
+        std::vector<float> a, b, out, xs, ys, cxs, cys;
+        std::vector<float> modeRe, modeIm, poleRe, poleIm, inputGains,
+                outputGains;
+        std::vector<int> assignments;
+    };
+} // namespace
+
+/**
+ * @brief Get the kernels cached for a configuration, or queue it for tuning
+ * if there are none.
+ * @param config The configuration.
+ * @param cacheFile The cache file.
+ * @return The configuration's kernels, or nullptr if the variant was forced
+ * or the configuration is waiting to be tuned.
+ */
+const Kernels::Table *KernelAutotuner::prepare(const Config &config,
+                                               const juce::File &cacheFile) {
+    if (Kernels::isForced())
+        return nullptr;
+    std::lock_guard lock(prepareMutex);
+    const auto key = getConfigKey(config);
+    if (const auto prepared = preparedChoices.find(key);
+        prepared != preparedChoices.end())
+        return Kernels::combine(prepared->second);
+    if (pendingTunes.contains(key))
+        return nullptr;
+    const auto choice = load(cacheFile, config);
+    if (!choice.has_value()) {
+        /// Timed later by tuneIfPending(); the caller's kernels stay
+        pendingTunes[key] = {config, cacheFile};
+        tunePending.store(true, std::memory_order_release);
+        return nullptr;
+    }
+    preparedChoices[key] = *choice;
+    return Kernels::combine(*choice);
+}
+
+/**
+ * @brief Get the kernels of a configuration already loaded or tuned in this
+ * process.
+ * @param config The configuration.
+ * @return The configuration's kernels, or nullptr if there are none yet.
+ */
+const Kernels::Table *KernelAutotuner::find(const Config &config) {
+    std::lock_guard lock(prepareMutex);
+    const auto prepared = preparedChoices.find(getConfigKey(config));
+    return prepared != preparedChoices.end()
+                   ? Kernels::combine(prepared->second)
+                   : nullptr;
+}
+
+/**
+ * @brief Tune and cache one configuration queued by prepare(), if any.
+ * @return True if a configuration was tuned.
+ */
+bool KernelAutotuner::tuneIfPending() {
+    if (!tunePending.load(std::memory_order_acquire))
+        return false;
+    /// Another thread is already tuning; it picks up the rest
+    std::unique_lock tuneLock(tuneMutex, std::try_to_lock);
+    if (!tuneLock.owns_lock())
+        return false;
+    juce::String key;
+    PendingTune pending;
+    {
+        std::lock_guard lock(prepareMutex);
+        if (pendingTunes.empty())
+            return false;
+        key = pendingTunes.begin()->first;
+        pending = pendingTunes.begin()->second;
+    }
+    const Choice choice = tune(pending.config);
+    /// Still used for the rest of the process, just tuned again next time
+    if (!save(pending.cacheFile, pending.config, choice))
+        failedSaves.fetch_add(1, std::memory_order_relaxed);
+    std::lock_guard lock(prepareMutex);
+    pendingTunes.erase(key);
+    tunePending.store(!pendingTunes.empty(), std::memory_order_release);
+    preparedChoices[key] = choice;
+    return true;
+}
+
+/**
+ * @brief Get the number of tuned choices tuneIfPending() could not write to
+ * their cache.
+ * @return The number of failed writes.
+ */
+uint64_t KernelAutotuner::getNumFailedSaves() {
+    return failedSaves.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Time every variant of every kernel and pick the fastest.
+ * @param config The configuration.
+ * @param secondsPerCandidate How long to time each variant of a kernel.
+ * @param timings If not null, receives the timing of every variant.
+ * @return The fastest variant of each kernel.
+ */
+KernelAutotuner::Choice KernelAutotuner::tune(const Config &config,
+                                              const double secondsPerCandidate,
+                                              Timings *timings) {
+    Workload workload(config);
+    if (timings != nullptr)
+        *timings = {};
+    const auto defaultIsa = Kernels::getActiveIsa();
+    Choice choice;
+    for (int kernel = 0; kernel < Kernels::numKernels; ++kernel) {
+        /// Start from the automatic choice and only move off it for a clear
+        /// win, so timing noise does not flip the choice between runs
+        auto bestIsa = defaultIsa;
+        double bestTime = workload.time(*Kernels::getTable(defaultIsa), kernel,
+                                        secondsPerCandidate);
+        if (timings != nullptr)
+            (*timings)[kernel][static_cast<size_t>(defaultIsa)] = bestTime;
+        for (int i = 0; i < static_cast<int>(Kernels::Isa::count); ++i) {
+            const auto isa = static_cast<Kernels::Isa>(i);
+            const auto *table = Kernels::getTable(isa);
+            if (isa == defaultIsa || table == nullptr)
+                continue;
+            const double time =
+                    workload.time(*table, kernel, secondsPerCandidate);
+            if (timings != nullptr)
+                (*timings)[kernel][static_cast<size_t>(i)] = time;
+            if (time < bestTime * improvementThreshold) {
+                bestIsa = isa;
+                bestTime = time;
+            }
+        }
+        choice[static_cast<size_t>(kernel)] = bestIsa;
+    }
+    return choice;
+}
+
+/**
+ * @brief Look a configuration up in the cache.
+ * @param cacheFile The cache file.
+ * @param config The configuration.
+ * @return The cached choice, or nothing if this CPU and configuration have
+ * not been tuned or a cached variant is unavailable.
+ */
+std::optional<KernelAutotuner::Choice>
+KernelAutotuner::load(const juce::File &cacheFile, const Config &config) {
+    const auto cache = juce::JSON::parse(cacheFile);
+    if (static_cast<int>(cache.getProperty("version", 0)) != cacheVersion)
+        return std::nullopt;
+    const auto entry = cache.getProperty("cpus", {})
+                               .getProperty(getCpuKey(), {})
+                               .getProperty(getConfigKey(config), {});
+    if (!entry.isObject())
+        return std::nullopt;
+    Choice choice;
+    for (int kernel = 0; kernel < Kernels::numKernels; ++kernel) {
+        const auto name =
+                entry.getProperty(getKernelName(kernel), {}).toString();
+        bool found = false;
+        for (int i = 0; i < static_cast<int>(Kernels::Isa::count); ++i) {
+            const auto isa = static_cast<Kernels::Isa>(i);
+            if (name == Kernels::getName(isa) &&
+                Kernels::getTable(isa) != nullptr) {
+                choice[static_cast<size_t>(kernel)] = isa;
+                found = true;
+            }
+        }
+        if (!found)
+            return std::nullopt;
+    }
+    return choice;
+}
+
+/**
+ * @brief Add or replace a configuration in the cache.
+ * @param cacheFile The cache file.
+ * @param config The configuration.
+ * @param choice The choice to store.
+ * @return True if the cache was written.
+ */
+bool KernelAutotuner::save(const juce::File &cacheFile, const Config &config,
+                           const Choice &choice) {
+    auto cache = juce::JSON::parse(cacheFile);
+    if (!cache.isObject() ||
+        static_cast<int>(cache.getProperty("version", 0)) != cacheVersion) {
+        cache = new juce::DynamicObject();
+        cache.getDynamicObject()->setProperty("version", cacheVersion);
+    }
+    auto cpus = cache.getProperty("cpus", {});
+    if (!cpus.isObject()) {
+        cpus = new juce::DynamicObject();
+        cache.getDynamicObject()->setProperty("cpus", cpus);
+    }
+    auto cpu = cpus.getProperty(getCpuKey(), {});
+    if (!cpu.isObject()) {
+        cpu = new juce::DynamicObject();
+        cpus.getDynamicObject()->setProperty(getCpuKey(), cpu);
+    }
+    auto *entry = new juce::DynamicObject();
+    for (int kernel = 0; kernel < Kernels::numKernels; ++kernel)
+        entry->setProperty(getKernelName(kernel),
+                           juce::String(Kernels::getName(
+                                   choice[static_cast<size_t>(kernel)])));
+    cpu.getDynamicObject()->setProperty(getConfigKey(config), entry);
+    return cacheFile.getParentDirectory().createDirectory() &&
+           cacheFile.replaceWithText(juce::JSON::toString(cache));
+}
+
+/**
+ * @brief Get the default location of the cache.
+ * @return The cache file in the user's application data directory.
+ */
+juce::File KernelAutotuner::getDefaultCacheFile() {
+    return juce::File::getSpecialLocation(
+                   juce::File::userApplicationDataDirectory)
+            .getChildFile("Graphverb")
+            .getChildFile("kernel-cache.json");
+}
+
+/**
+ * @brief Get the name of a kernel, as used in the cache.
+ * @param kernel The kernel's index in Kernels::Table order.
+ * @return The kernel name.
+ */
+const char *KernelAutotuner::getKernelName(const int kernel) {
+    static constexpr const char *names[] = {"multiply", "magnitudes",
+                                            "assign_nearest", "add_weighted",
+                                            "mix_and_clip", "resonate"};
+    return names[kernel];
+}
+
+/**
+ * @brief Get the key identifying this CPU in the cache.
+ * @return The CPU vendor and model.
+ */
+juce::String KernelAutotuner::getCpuKey() {
+    return juce::SystemStats::getCpuVendor() + " " +
+           juce::SystemStats::getCpuModel();
+}
+
+/**
+ * @brief Get the key identifying a configuration in the cache.
+ * @param config The configuration.
+ * @return The configuration key.
+ */
+juce::String KernelAutotuner::getConfigKey(const Config &config) {
+    /// Hosts vary the block size a lot and the timings barely depend on it,
+    /// so block sizes share an entry per power of two
+    return juce::String(juce::roundToInt(config.sampleRate)) + "/" +
+           juce::String(juce::nextPowerOfTwo(config.blockSize)) + "/" +
+           juce::String(config.fftSize) + "/" +
+           juce::String(config.numClusters);
+}
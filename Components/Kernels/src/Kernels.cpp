@@ -0,0 +1,175 @@
+#include "Kernels.h"
+
+#include <juce_core/juce_core.h>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace {
+    /**
+     * @brief The automatically picked or forced instruction set.
+     */
+    struct Selection {
+        Kernels::Isa isa = Kernels::Isa::scalar;
+        bool forced = false;
+        bool forceRejected = false;
+    };
+
+    /**
+     * @brief Check if the CPU supports an instruction set.
+     * @param isa The instruction set.
+     * @return True if the CPU and OS support it.
+     */
+    bool isSupportedByCpu(const Kernels::Isa isa) {
+        using Isa = Kernels::Isa;
+        switch (isa) {
+            case Isa::scalar:
+                return true;
+            case Isa::sse2:
+                return juce::SystemStats::hasSSE2();
+            case Isa::avx2:
+                return juce::SystemStats::hasAVX2() &&
+                       juce::SystemStats::hasFMA3();
+            case Isa::avx512:
+                return juce::SystemStats::hasAVX512F();
+            case Isa::neon:
+                return juce::SystemStats::hasNeon();
+            case Isa::count:
+                break;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Pick the instruction set to use, honouring GRAPHVERB_FORCE_ISA.
+     * @return The selection.
+     */
+    Selection selectIsa() {
+        using Isa = Kernels::Isa;
+        const juce::String forced = juce::SystemStats::getEnvironmentVariable(
+                "GRAPHVERB_FORCE_ISA", {});
+        if (forced.isNotEmpty()) {
+            for (int i = 0; i < static_cast<int>(Isa::count); ++i) {
+                const auto isa = static_cast<Isa>(i);
+                if (forced.equalsIgnoreCase(Kernels::getName(isa)) &&
+                    Kernels::getTable(isa) != nullptr)
+                    return {isa, true, false};
+            }
+        }
+        /// Widest first; a rejected force is reported by isForceRejected()
+        Selection selection{Isa::scalar, false, forced.isNotEmpty()};
+        for (const auto isa: {Isa::avx512, Isa::avx2, Isa::sse2, Isa::neon})
+            if (Kernels::getTable(isa) != nullptr) {
+                selection.isa = isa;
+                break;
+            }
+        return selection;
+    }
+
+    /**
+     * @brief Get the selection, making it on first use.
+     * @return The selection.
+     */
+    const Selection &getSelection() {
+        static const Selection selection = selectIsa();
+        return selection;
+    }
+} // namespace
+
+/**
+ * @brief Get the kernels picked automatically or forced with
+ * GRAPHVERB_FORCE_ISA.
+ * @return The kernel table.
+ */
+const Kernels::Table &Kernels::get() {
+    static const Table &table = *getTable(getActiveIsa());
+    return table;
+}
+
+/**
+ * @brief Get the instruction set picked automatically or forced with
+ * GRAPHVERB_FORCE_ISA.
+ * @return The instruction set.
+ */
+Kernels::Isa Kernels::getActiveIsa() { return getSelection().isa; }
+
+/**
+ * @brief Check if GRAPHVERB_FORCE_ISA selected the active variant.
+ * @return True if the variant was forced.
+ */
+bool Kernels::isForced() { return getSelection().forced; }
+
+/**
+ * @brief Check if GRAPHVERB_FORCE_ISA named a variant that is unavailable.
+ * @return True if the forced variant was ignored.
+ */
+bool Kernels::isForceRejected() { return getSelection().forceRejected; }
+
+/**
+ * @brief Get a table taking each kernel from a chosen variant, building it
+ * the first time the combination is asked for.
+ * @param isas The instruction set for each kernel, in Table order.
+ * @return The table, or nullptr if one of the variants is unavailable.
+ */
+const Kernels::Table *
+Kernels::combine(const std::array<Isa, numKernels> &isas) {
+    std::array<const Table *, numKernels> sources{};
+    for (int i = 0; i < numKernels; ++i)
+        if ((sources[i] = getTable(isas[i])) == nullptr)
+            return nullptr;
+    /// Deliberately leaked, so no table is freed under a thread holding it
+    /// at exit; there are at most a few combinations per process
+    static std::mutex mutex;
+    static auto &tables =
+            *new std::map<std::array<Isa, numKernels>, std::unique_ptr<Table>>;
+    std::lock_guard lock(mutex);
+    auto &table = tables[isas];
+    if (table == nullptr) {
+        table = std::make_unique<Table>();
+        table->multiply = sources[0]->multiply;
+        table->magnitudes = sources[1]->magnitudes;
+        table->assignNearest = sources[2]->assignNearest;
+        table->addWeighted = sources[3]->addWeighted;
+        table->mixAndClip = sources[4]->mixAndClip;
+        table->resonate = sources[5]->resonate;
+    }
+    return table.get();
+}
+
+/**
+ * @brief Get the kernels compiled for an instruction set.
+ * @param isa The instruction set.
+ * @return The kernel table, or nullptr if the variant was not compiled into
+ * this binary or the CPU does not support it.
+ */
+const Kernels::Table *Kernels::getTable(const Isa isa) {
+    if (!isSupportedByCpu(isa))
+        return nullptr;
+    switch (isa) {
+        case Isa::scalar:
+            return detail::getScalarTable();
+        case Isa::sse2:
+            return detail::getSse2Table();
+        case Isa::avx2:
+            return detail::getAvx2Table();
+        case Isa::avx512:
+            return detail::getAvx512Table();
+        case Isa::neon:
+            return detail::getNeonTable();
+        case Isa::count:
+            break;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Get the name of an instruction set.
+ * @param isa The instruction set.
+ * @return The name, e.g. "avx2".
+ */
+const char *Kernels::getName(const Isa isa) {
+    static constexpr const char *names[] = {"scalar", "sse2", "avx2",
+                                            "avx512", "neon"};
+    const auto index = static_cast<size_t>(isa);
+    return index < std::size(names) ? names[index] : "unknown";
+}
@@ -0,0 +1,56 @@
+#include "Kernels.h"
+
+/// Only compiled in when CMake adds the AVX2 and FMA flags to this file
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#include <immintrin.h>
+#include "KernelsSimd.h"
+
+namespace {
+    /**
+     * @brief Eight-wide AVX2 vector traits with fused multiply-add.
+     */
+    struct Avx2 {
+        using Reg = __m256;
+        using Mask = __m256;
+        static constexpr int width = 8;
+
+        static Reg load(const float *p) { return _mm256_loadu_ps(p); }
+        static void store(float *p, const Reg a) { _mm256_storeu_ps(p, a); }
+        static Reg set1(const float a) { return _mm256_set1_ps(a); }
+        static Reg add(const Reg a, const Reg b) { return _mm256_add_ps(a, b); }
+        static Reg sub(const Reg a, const Reg b) { return _mm256_sub_ps(a, b); }
+        static Reg mul(const Reg a, const Reg b) { return _mm256_mul_ps(a, b); }
+        static Reg div(const Reg a, const Reg b) { return _mm256_div_ps(a, b); }
+        static Reg fma(const Reg a, const Reg b, const Reg c) {
+            return _mm256_fmadd_ps(a, b, c);
+        }
+        static Reg sqrt(const Reg a) { return _mm256_sqrt_ps(a); }
+        static Reg min(const Reg a, const Reg b) { return _mm256_min_ps(a, b); }
+        static Reg max(const Reg a, const Reg b) { return _mm256_max_ps(a, b); }
+        static Mask less(const Reg a, const Reg b) {
+            return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+        }
+        static Reg select(const Mask m, const Reg a, const Reg b) {
+            return _mm256_blendv_ps(b, a, m);
+        }
+        static void loadDeinterleaved(const float *p, Reg &re, Reg &im) {
+            const Reg a = _mm256_loadu_ps(p);
+            const Reg b = _mm256_loadu_ps(p + 8);
+            /// The in-lane shuffles leave the pairs in 0 2 1 3 order
+            const Reg evens = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            const Reg odds = _mm256_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            re = _mm256_castpd_ps(_mm256_permute4x64_pd(
+                    _mm256_castps_pd(evens), _MM_SHUFFLE(3, 1, 2, 0)));
+            im = _mm256_castpd_ps(_mm256_permute4x64_pd(
+                    _mm256_castps_pd(odds), _MM_SHUFFLE(3, 1, 2, 0)));
+        }
+    };
+} // namespace
+
+const Kernels::Table *Kernels::detail::getAvx2Table() {
+    static const Table table = KernelsSimd::makeTable<Avx2>();
+    return &table;
+}
+#else
+const Kernels::Table *Kernels::detail::getAvx2Table() { return nullptr; }
+#endif
@@ -0,0 +1,57 @@
+#include "Kernels.h"
+
+/// Only compiled in when CMake adds the AVX-512 flags to this file
+#if defined(__AVX512F__)
+#include <immintrin.h>
+#include "KernelsSimd.h"
+
+namespace {
+    /**
+     * @brief Sixteen-wide AVX-512 vector traits.
+     */
+    struct Avx512 {
+        using Reg = __m512;
+        using Mask = __mmask16;
+        static constexpr int width = 16;
+
+        static Reg load(const float *p) { return _mm512_loadu_ps(p); }
+        static void store(float *p, const Reg a) { _mm512_storeu_ps(p, a); }
+        static Reg set1(const float a) { return _mm512_set1_ps(a); }
+        static Reg add(const Reg a, const Reg b) { return _mm512_add_ps(a, b); }
+        static Reg sub(const Reg a, const Reg b) { return _mm512_sub_ps(a, b); }
+        static Reg mul(const Reg a, const Reg b) { return _mm512_mul_ps(a, b); }
+        static Reg div(const Reg a, const Reg b) { return _mm512_div_ps(a, b); }
+        static Reg fma(const Reg a, const Reg b, const Reg c) {
+            return _mm512_fmadd_ps(a, b, c);
+        }
+        static Reg sqrt(const Reg a) { return _mm512_sqrt_ps(a); }
+        static Reg min(const Reg a, const Reg b) { return _mm512_min_ps(a, b); }
+        static Reg max(const Reg a, const Reg b) { return _mm512_max_ps(a, b); }
+        static Mask less(const Reg a, const Reg b) {
+            return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+        }
+        static Reg select(const Mask m, const Reg a, const Reg b) {
+            return _mm512_mask_blend_ps(m, b, a);
+        }
+        static void loadDeinterleaved(const float *p, Reg &re, Reg &im) {
+            const Reg a = _mm512_loadu_ps(p);
+            const Reg b = _mm512_loadu_ps(p + 16);
+            const __m512i evens = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14,
+                                                    16, 18, 20, 22, 24, 26, 28,
+                                                    30);
+            const __m512i odds = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15,
+                                                   17, 19, 21, 23, 25, 27, 29,
+                                                   31);
+            re = _mm512_permutex2var_ps(a, evens, b);
+            im = _mm512_permutex2var_ps(a, odds, b);
+        }
+    };
+} // namespace
+
+const Kernels::Table *Kernels::detail::getAvx512Table() {
+    static const Table table = KernelsSimd::makeTable<Avx512>();
+    return &table;
+}
+#else
+const Kernels::Table *Kernels::detail::getAvx512Table() { return nullptr; }
+#endif
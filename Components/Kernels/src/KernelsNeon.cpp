@@ -0,0 +1,48 @@
+#include "Kernels.h"
+
+/// Division and square root need the AArch64 NEON instructions
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#include "KernelsSimd.h"
+
+namespace {
+    /**
+     * @brief Four-wide AArch64 NEON vector traits with fused multiply-add.
+     */
+    struct Neon {
+        using Reg = float32x4_t;
+        using Mask = uint32x4_t;
+        static constexpr int width = 4;
+
+        static Reg load(const float *p) { return vld1q_f32(p); }
+        static void store(float *p, const Reg a) { vst1q_f32(p, a); }
+        static Reg set1(const float a) { return vdupq_n_f32(a); }
+        static Reg add(const Reg a, const Reg b) { return vaddq_f32(a, b); }
+        static Reg sub(const Reg a, const Reg b) { return vsubq_f32(a, b); }
+        static Reg mul(const Reg a, const Reg b) { return vmulq_f32(a, b); }
+        static Reg div(const Reg a, const Reg b) { return vdivq_f32(a, b); }
+        static Reg fma(const Reg a, const Reg b, const Reg c) {
+            return vfmaq_f32(c, a, b);
+        }
+        static Reg sqrt(const Reg a) { return vsqrtq_f32(a); }
+        static Reg min(const Reg a, const Reg b) { return vminq_f32(a, b); }
+        static Reg max(const Reg a, const Reg b) { return vmaxq_f32(a, b); }
+        static Mask less(const Reg a, const Reg b) { return vcltq_f32(a, b); }
+        static Reg select(const Mask m, const Reg a, const Reg b) {
+            return vbslq_f32(m, a, b);
+        }
+        static void loadDeinterleaved(const float *p, Reg &re, Reg &im) {
+            const float32x4x2_t pair = vld2q_f32(p);
+            re = pair.val[0];
+            im = pair.val[1];
+        }
+    };
+} // namespace
+
+const Kernels::Table *Kernels::detail::getNeonTable() {
+    static const Table table = KernelsSimd::makeTable<Neon>();
+    return &table;
+}
+#else
+const Kernels::Table *Kernels::detail::getNeonTable() { return nullptr; }
+#endif
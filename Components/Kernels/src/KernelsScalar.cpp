@@ -0,0 +1,80 @@
+#include "Kernels.h"
+
+#include <cmath>
+
+/**
+ * @brief Portable kernels, compiled with the baseline flags. These are the
+ * reference the SIMD variants are compared against.
+ */
+namespace {
+    void multiply(float *dst, const float *a, const float *b, const int n) {
+        for (int i = 0; i < n; ++i)
+            dst[i] = a[i] * b[i];
+    }
+
+    void magnitudes(float *dst, const float *interleaved, const int numBins) {
+        for (int i = 0; i < numBins; ++i) {
+            const float real = interleaved[2 * i];
+            const float imag = interleaved[2 * i + 1];
+            dst[i] = std::sqrt(real * real + imag * imag);
+        }
+    }
+
+    int assignNearest(const float *xs, const float *ys, const int n,
+                      const float *cxs, const float *cys, const int k,
+                      int *assignments) {
+        int changed = 0;
+        for (int i = 0; i < n; ++i) {
+            int bestCluster = 0;
+            float bestDistance = 0.0f;
+            for (int j = 0; j < k; ++j) {
+                const float dx = xs[i] - cxs[j];
+                const float dy = ys[i] - cys[j];
+                const float d = dx * dx + dy * dy;
+                if (j == 0 || d < bestDistance) {
+                    bestDistance = d;
+                    bestCluster = j;
+                }
+            }
+            if (assignments[i] != bestCluster) {
+                assignments[i] = bestCluster;
+                ++changed;
+            }
+        }
+        return changed;
+    }
+
+    void addWeighted(float *dst, const float *src, const float weight,
+                     const int n) {
+        for (int i = 0; i < n; ++i)
+            dst[i] += weight * src[i];
+    }
+
+    void mixAndClip(float *out, const float *wet, const float dryGain,
+                    const float wetGain, const float gain, const int n) {
+        for (int i = 0; i < n; ++i)
+            out[i] = std::tanh(gain * (dryGain * out[i] + wetGain * wet[i]));
+    }
+
+    void resonate(const Kernels::ModeBank &bank, const float *in, float *out,
+                  const int numSamples) {
+        for (int s = 0; s < numSamples; ++s) {
+            float sum = 0.0f;
+            for (int m = 0; m < bank.numModes; ++m) {
+                const float re = bank.re[m];
+                const float im = bank.im[m];
+                bank.re[m] = bank.poleRe[m] * re - bank.poleIm[m] * im +
+                             bank.inputGains[m] * in[s];
+                bank.im[m] = bank.poleIm[m] * re + bank.poleRe[m] * im;
+                sum += bank.outputGains[m] * bank.im[m];
+            }
+            out[s] = sum;
+        }
+    }
+} // namespace
+
+const Kernels::Table *Kernels::detail::getScalarTable() {
+    static constexpr Table table{multiply, magnitudes, assignNearest,
+                                 addWeighted, mixAndClip, resonate};
+    return &table;
+}
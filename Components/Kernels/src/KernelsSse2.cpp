@@ -0,0 +1,49 @@
+#include "Kernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#include "KernelsSimd.h"
+
+namespace {
+    /**
+     * @brief Four-wide SSE2 vector traits. SSE2 has no fused multiply-add,
+     * so fma is a multiply followed by an add.
+     */
+    struct Sse2 {
+        using Reg = __m128;
+        using Mask = __m128;
+        static constexpr int width = 4;
+
+        static Reg load(const float *p) { return _mm_loadu_ps(p); }
+        static void store(float *p, const Reg a) { _mm_storeu_ps(p, a); }
+        static Reg set1(const float a) { return _mm_set1_ps(a); }
+        static Reg add(const Reg a, const Reg b) { return _mm_add_ps(a, b); }
+        static Reg sub(const Reg a, const Reg b) { return _mm_sub_ps(a, b); }
+        static Reg mul(const Reg a, const Reg b) { return _mm_mul_ps(a, b); }
+        static Reg div(const Reg a, const Reg b) { return _mm_div_ps(a, b); }
+        static Reg fma(const Reg a, const Reg b, const Reg c) {
+            return _mm_add_ps(_mm_mul_ps(a, b), c);
+        }
+        static Reg sqrt(const Reg a) { return _mm_sqrt_ps(a); }
+        static Reg min(const Reg a, const Reg b) { return _mm_min_ps(a, b); }
+        static Reg max(const Reg a, const Reg b) { return _mm_max_ps(a, b); }
+        static Mask less(const Reg a, const Reg b) { return _mm_cmplt_ps(a, b); }
+        static Reg select(const Mask m, const Reg a, const Reg b) {
+            return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b));
+        }
+        static void loadDeinterleaved(const float *p, Reg &re, Reg &im) {
+            const Reg a = _mm_loadu_ps(p);
+            const Reg b = _mm_loadu_ps(p + 4);
+            re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+    };
+} // namespace
+
+const Kernels::Table *Kernels::detail::getSse2Table() {
+    static const Table table = KernelsSimd::makeTable<Sse2>();
+    return &table;
+}
+#else
+const Kernels::Table *Kernels::detail::getSse2Table() { return nullptr; }
+#endif
@@ -0,0 +1,181 @@
+#ifndef MODAL_REVERB_H
+#define MODAL_REVERB_H
+
+#include <cstdint>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <vector>
+#include "Kernels.h"
+
+/**
+ * @brief Modal reverb: a large bank of exponentially damped complex
+ * resonators standing in for the per-cluster juce::Reverb instances.
+ *
+ * Each mode sits at a fixed frequency and belongs to the cluster covering
+ * that frequency in the analysis, so its decay and level follow that
+ * cluster's reverb parameters exactly. The decay matches what the cluster's
+ * reverb would have, including its damping, and the levels are scaled so the
+ * bank carries the same energy as the reverbs' combs. The modes are stored
+ * one array per field and run by Kernels::Table::resonate, so the cost grows
+ * with the number of modes rather than the number of clusters.
+ *
+ * Everything is allocated by the constructor; the other calls never allocate
+ * and are meant for the audio thread.
+ */
+class ModalReverb {
+public:
+    /** Modes per channel are padded to a multiple of this, the widest
+     * vector of any kernel variant */
+    static constexpr int modeAlignment = 16;
+
+    /** Lowest mode frequency, in Hz */
+    static constexpr double minModeFrequency = 30.0;
+
+    /** Highest mode frequency, in Hz, further limited to below Nyquist */
+    static constexpr double maxModeFrequency = 16000.0;
+
+    /**
+     * @brief Constructor for the ModalReverb. Builds the modes.
+     * @param sampleRateIn The sample rate.
+     * @param numChannelsIn The number of channels, each with its own modes.
+     * @param modesPerChannel The number of modes of each channel.
+     * @param numClustersIn The number of clusters the modes belong to.
+     * @param blockCapacity The largest number of samples processed at once.
+     * @param damping The damping of the reverbs, as in
+     * juce::Reverb::Parameters.
+     */
+    ModalReverb(double sampleRateIn, int numChannelsIn, int modesPerChannel,
+                int numClustersIn, int blockCapacity, float damping);
+
+    /**
+     * @brief Assign each mode to the cluster of the bin covering its
+     * frequency.
+     * @param assignments The cluster of each bin, over the analysis FFT of
+     * the same sample rate; if empty, the modes are spread over the clusters
+     * in order of frequency instead.
+     * @param numActiveClusters The number of clusters in use.
+     */
+    void setAssignments(const std::vector<uint8_t> &assignments,
+                        int numActiveClusters);
+
+    /**
+     * @brief Set the weight and reverb parameters of one cluster, applied by
+     * the next prepareBlock().
+     * @param cluster The cluster.
+     * @param weight The cluster's weight in the mix.
+     * @param parameters The parameters of the cluster's reverb.
+     */
+    void setCluster(int cluster, float weight,
+                    const juce::Reverb::Parameters &parameters);
+
+    /**
+     * @brief Take the input for a block and update the modes from the
+     * clusters. Call before renderChannel().
+     * @param input The dry signal; its channels are summed.
+     */
+    void prepareBlock(const juce::AudioBuffer<float> &input);
+
+    /**
+     * @brief Render one channel's modes over the block taken by
+     * prepareBlock(). Channels may be rendered concurrently.
+     * @param channel The channel.
+     * @param output The output, overwritten with the wet signal.
+     * @param numSamples The number of samples, as given to prepareBlock().
+     * @param kernels The kernels to run the resonators with.
+     */
+    void renderChannel(int channel, float *output, int numSamples,
+                       const Kernels::Table &kernels);
+
+    /**
+     * @brief Get the gain of the reverbs' direct path, which the modes leave
+     * out, for the block taken by prepareBlock().
+     * @return The gain.
+     */
+    [[nodiscard]] float getDirectGain() const { return directGain; }
+
+    /**
+     * @brief Silence every mode.
+     */
+    void reset();
+
+    /**
+     * @brief Get the number of modes over all channels, without padding.
+     * @return The number of modes.
+     */
+    [[nodiscard]] int getNumModes() const { return numChannels * numModes; }
+
+    /**
+     * @brief Get the number of bytes held by the bank.
+     * @return The number of bytes.
+     */
+    [[nodiscard]] size_t getMemoryBytes() const;
+
+    /**
+     * @brief Get the number of bytes a bank holds for a configuration.
+     * @param numChannels The number of channels.
+     * @param modesPerChannel The number of modes of each channel.
+     * @param numClusters The number of clusters.
+     * @param blockCapacity The largest number of samples processed at once.
+     * @return The number of bytes.
+     */
+    static size_t getMemoryBytes(int numChannels, int modesPerChannel,
+                                 int numClusters, int blockCapacity);
+
+private:
+    double sampleRate;
+    int numChannels;
+    int numClusters;
+
+    /** Modes of each channel */
+    int numModes;
+
+    /** Distance between the channels in the mode arrays: numModes, padded
+     * with silent modes */
+    int stride;
+
+    /** Number of float arrays held per mode */
+    static constexpr size_t floatsPerMode = 9;
+
+    /** Mean delay of the reverbs' combs, whose decay the modes match */
+    double combSamples;
+
+    /** Gain of one mode at full weight and wet level */
+    float modeGain;
+
+    /** State of each mode */
+    std::vector<float> re, im;
+
+    /** Pole of each mode, from its frequency and its cluster's decay */
+    std::vector<float> poleRe, poleIm;
+
+    /** Input gain of each mode, from its cluster's level */
+    std::vector<float> inputGains;
+
+    /** Output gain of each mode, a random sign to diffuse the tail */
+    std::vector<float> outputGains;
+
+    /** Pole of each mode with only the damping's decay applied */
+    std::vector<float> dampedCos, dampedSin;
+
+    /** Frequency of each mode, in Hz */
+    std::vector<float> frequencies;
+
+    /** Cluster of each mode */
+    std::vector<uint8_t> clusters;
+
+    /** Pole radius each cluster's reverb decays with */
+    std::vector<float> clusterRadii;
+
+    /** Input gain of each cluster's modes */
+    std::vector<float> clusterGains;
+
+    /** Direct gain of each cluster's reverb, weighted */
+    std::vector<float> clusterDirectGains;
+
+    /** Sum of the input channels for the current block */
+    std::vector<float> input;
+
+    /** Direct gain for the current block */
+    float directGain = 0.0f;
+};
+
+#endif // MODAL_REVERB_H
@@ -0,0 +1,257 @@
+#include "ModalReverb.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * @brief Constants of juce::Reverb, whose sound the modes follow.
+ */
+namespace {
+    /** Comb feedback is roomSize * roomScale + roomOffset */
+    constexpr double roomScale = 0.28;
+    constexpr double roomOffset = 0.7;
+
+    /** The damping filter's coefficient is damping * dampScale */
+    constexpr double dampScale = 0.4;
+
+    /** Gain of the summed input into the combs, and the number of combs */
+    constexpr double combInputGain = 0.015;
+    constexpr int numCombs = 8;
+
+    /** Mean comb length at 44.1 kHz, in samples */
+    constexpr double meanCombTuning = 1378.0;
+
+    /** Scale of the wet and dry levels */
+    constexpr float wetScale = 3.0f;
+    constexpr float dryScale = 2.0f;
+
+    /** Seed of the mode jitter and signs, so every instance sounds alike */
+    constexpr juce::int64 modeSeed = 0x6d6f646573;
+
+    /**
+     * @brief Convert a frequency to the mel scale.
+     * @param frequency The frequency, in Hz.
+     * @return The pitch, in mels.
+     */
+    double toMel(const double frequency) {
+        return 2595.0 * std::log10(1.0 + frequency / 700.0);
+    }
+
+    /**
+     * @brief Convert a pitch on the mel scale to a frequency.
+     * @param mel The pitch, in mels.
+     * @return The frequency, in Hz.
+     */
+    double fromMel(const double mel) {
+        return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+    }
+} // namespace
+
+/**
+ * @brief Constructor for the ModalReverb. Builds the modes.
+ *
+ * The modes are spread evenly on the mel scale, each jittered within its own
+ * slot, and dealt out to the channels in turn, so neighbouring modes of one
+ * channel never line up with the other's. A mode keeps its frequency for
+ * life; only its pole radius and input gain follow its cluster.
+ *
+ * @param sampleRateIn The sample rate.
+ * @param numChannelsIn The number of channels, each with its own modes.
+ * @param modesPerChannel The number of modes of each channel.
+ * @param numClustersIn The number of clusters the modes belong to.
+ * @param blockCapacity The largest number of samples processed at once.
+ * @param damping The damping of the reverbs.
+ */
+ModalReverb::ModalReverb(const double sampleRateIn, const int numChannelsIn,
+                         const int modesPerChannel, const int numClustersIn,
+                         const int blockCapacity, const float damping) :
+    sampleRate(sampleRateIn), numChannels(numChannelsIn),
+    numClusters(juce::jlimit(1, 256, numClustersIn)),
+    numModes(modesPerChannel),
+    stride((modesPerChannel + modeAlignment - 1) / modeAlignment *
+           modeAlignment),
+    combSamples(meanCombTuning * sampleRateIn / 44100.0),
+    /// A mode's impulse response carries about half as much energy as a
+    /// comb with the same decay over its length, so this matches the energy
+    /// of the combs summed
+    modeGain(static_cast<float>(
+            combInputGain *
+            std::sqrt(2.0 * numCombs / (modesPerChannel * combSamples)))),
+    clusterRadii(static_cast<size_t>(numClusters), 0.0f),
+    clusterGains(static_cast<size_t>(numClusters), 0.0f),
+    clusterDirectGains(static_cast<size_t>(numClusters), 0.0f),
+    input(static_cast<size_t>(blockCapacity), 0.0f) {
+    const auto size = static_cast<size_t>(numChannels * stride);
+    for (auto *field: {&re, &im, &poleRe, &poleIm, &inputGains, &outputGains,
+                       &dampedCos, &dampedSin, &frequencies})
+        field->assign(size, 0.0f);
+    clusters.assign(size, 0);
+
+    const double lowMel = toMel(minModeFrequency);
+    const double highMel =
+            toMel(juce::jmin(maxModeFrequency, 0.45 * sampleRate));
+    const double dampingCoefficient = damping * dampScale;
+    const int totalModes = numChannels * numModes;
+    juce::Random random(modeSeed);
+    for (int i = 0; i < totalModes; ++i) {
+        const double frequency = fromMel(
+                lowMel + (highMel - lowMel) * (i + random.nextDouble()) /
+                                 totalModes);
+        const double omega =
+                juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        /// The combs' one-pole damping filter takes its loss once per comb
+        /// length; spread it over the samples
+        const double loss =
+                (1.0 - dampingCoefficient) /
+                std::sqrt(1.0 - 2.0 * dampingCoefficient * std::cos(omega) +
+                          dampingCoefficient * dampingCoefficient);
+        const double radius = std::pow(loss, 1.0 / combSamples);
+        const auto index = static_cast<size_t>((i % numChannels) * stride +
+                                               i / numChannels);
+        frequencies[index] = static_cast<float>(frequency);
+        dampedCos[index] = static_cast<float>(radius * std::cos(omega));
+        dampedSin[index] = static_cast<float>(radius * std::sin(omega));
+        outputGains[index] = random.nextBool() ? 1.0f : -1.0f;
+    }
+    setAssignments({}, numClusters);
+}
+
+/**
+ * @brief Assign each mode to the cluster of the bin covering its frequency.
+ * @param assignments The cluster of each bin, or empty to spread the modes
+ * over the clusters in order of frequency.
+ * @param numActiveClusters The number of clusters in use.
+ */
+void ModalReverb::setAssignments(const std::vector<uint8_t> &assignments,
+                                 const int numActiveClusters) {
+    const int numBins = static_cast<int>(assignments.size());
+    const int numActive = juce::jlimit(1, numClusters, numActiveClusters);
+    /// The bins of an FFT of 2 * numBins samples
+    const double binsPerHz = 2.0 * numBins / sampleRate;
+    for (int ch = 0; ch < numChannels; ++ch) {
+        for (int m = 0; m < numModes; ++m) {
+            const auto index = static_cast<size_t>(ch * stride + m);
+            int cluster = m * numActive / numModes;
+            if (numBins > 0) {
+                const int bin = juce::jmin(
+                        numBins - 1,
+                        juce::roundToInt(frequencies[index] * binsPerHz));
+                cluster = juce::jmin(
+                        static_cast<int>(assignments[static_cast<size_t>(bin)]),
+                        numClusters - 1);
+            }
+            clusters[index] = static_cast<uint8_t>(cluster);
+        }
+    }
+}
+
+/**
+ * @brief Set the weight and reverb parameters of one cluster.
+ *
+ * The pole radius gives the modes the decay of the reverb's combs, and the
+ * input gain its wet level, as juce::Reverb derives them.
+ *
+ * @param cluster The cluster.
+ * @param weight The cluster's weight in the mix.
+ * @param parameters The parameters of the cluster's reverb.
+ */
+void ModalReverb::setCluster(const int cluster, const float weight,
+                             const juce::Reverb::Parameters &parameters) {
+    if (cluster < 0 || cluster >= numClusters)
+        return;
+    const auto index = static_cast<size_t>(cluster);
+    const double feedback = parameters.roomSize * roomScale + roomOffset;
+    clusterRadii[index] =
+            static_cast<float>(std::exp(std::log(feedback) / combSamples));
+    /// The reverb's own output channel; the width only mixes in the other
+    clusterGains[index] = weight * parameters.wetLevel * wetScale * 0.5f *
+                          (1.0f + parameters.width) * modeGain;
+    clusterDirectGains[index] = weight * parameters.dryLevel * dryScale;
+}
+
+/**
+ * @brief Take the input for a block and update the modes from the clusters.
+ *
+ * Only new input is weighted by the clusters' levels, so a level change never
+ * steps a ringing tail.
+ *
+ * @param inputIn The dry signal; its channels are summed.
+ */
+void ModalReverb::prepareBlock(const juce::AudioBuffer<float> &inputIn) {
+    const int numSamples = inputIn.getNumSamples();
+    /// As in the reverbs, every channel's modes hear the sum of the channels
+    juce::FloatVectorOperations::copy(input.data(), inputIn.getReadPointer(0),
+                                      numSamples);
+    for (int ch = 1; ch < inputIn.getNumChannels(); ++ch)
+        juce::FloatVectorOperations::add(input.data(),
+                                         inputIn.getReadPointer(ch),
+                                         numSamples);
+    directGain = 0.0f;
+    for (const float gain: clusterDirectGains)
+        directGain += gain;
+    for (int ch = 0; ch < numChannels; ++ch) {
+        for (int m = 0; m < numModes; ++m) {
+            const auto index = static_cast<size_t>(ch * stride + m);
+            const auto cluster = static_cast<size_t>(clusters[index]);
+            poleRe[index] = clusterRadii[cluster] * dampedCos[index];
+            poleIm[index] = clusterRadii[cluster] * dampedSin[index];
+            inputGains[index] = clusterGains[cluster];
+        }
+    }
+}
+
+/**
+ * @brief Render one channel's modes over the block taken by prepareBlock().
+ * @param channel The channel.
+ * @param output The output, overwritten with the wet signal.
+ * @param numSamples The number of samples.
+ * @param kernels The kernels to run the resonators with.
+ */
+void ModalReverb::renderChannel(const int channel, float *output,
+                                const int numSamples,
+                                const Kernels::Table &kernels) {
+    const auto offset = static_cast<size_t>(channel * stride);
+    kernels.resonate(
+            {re.data() + offset, im.data() + offset, poleRe.data() + offset,
+             poleIm.data() + offset, inputGains.data() + offset,
+             outputGains.data() + offset, stride},
+            input.data(), output, numSamples);
+}
+
+/**
+ * @brief Silence every mode.
+ */
+void ModalReverb::reset() {
+    std::fill(re.begin(), re.end(), 0.0f);
+    std::fill(im.begin(), im.end(), 0.0f);
+}
+
+/**
+ * @brief Get the number of bytes held by the bank.
+ * @return The number of bytes.
+ */
+size_t ModalReverb::getMemoryBytes() const {
+    return getMemoryBytes(numChannels, numModes, numClusters,
+                          static_cast<int>(input.size()));
+}
+
+/**
+ * @brief Get the number of bytes a bank holds for a configuration.
+ * @param numChannels The number of channels.
+ * @param modesPerChannel The number of modes of each channel.
+ * @param numClusters The number of clusters.
+ * @param blockCapacity The largest number of samples processed at once.
+ * @return The number of bytes.
+ */
+size_t ModalReverb::getMemoryBytes(const int numChannels,
+                                   const int modesPerChannel,
+                                   const int numClusters,
+                                   const int blockCapacity) {
+    const auto modes = static_cast<size_t>(
+            numChannels * ((modesPerChannel + modeAlignment - 1) /
+                           modeAlignment * modeAlignment));
+    const size_t floats = floatsPerMode * modes +
+                          3 * static_cast<size_t>(numClusters) +
+                          static_cast<size_t>(blockCapacity);
+    return sizeof(ModalReverb) + floats * sizeof(float) + modes;
+}
@@ -0,0 +1,105 @@
+#ifndef SHARED_TABLES_H
+#define SHARED_TABLES_H
+
+#include <compare>
+#include <functional>
+#include <juce_dsp/juce_dsp.h>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Process-wide cache of immutable tables shared between instances.
+ *
+ * FFT plans and window tables depend only on their size (and, for some
+ * tables, the sample rate), so every instance of the plugin would otherwise
+ * build identical copies. The cache hands out shared pointers to const
+ * tables; a table is built by the first instance that asks for it and freed
+ * when the last instance holding it lets go.
+ *
+ * The tables are immutable, so they can be read from any thread without
+ * locking. FFT plans are the exception: the juce::dsp::FFT perform functions
+ * are const, but JUCE's fallback engine serialises concurrent transforms on
+ * one plan internally, so a shared plan is only for users that all run on
+ * one thread, such as the scopes on the message thread. The analysis threads
+ * each own their plan.
+ */
+class SharedTables {
+public:
+    /**
+     * @brief The kinds of table in the cache.
+     */
+    enum class Type { fft, hannWindowFloat, hannWindowDouble };
+
+    /**
+     * @brief Identifies a table in the cache.
+     */
+    struct Key {
+        Type type;
+        /** log2 of the table size */
+        int order;
+        /** Sample rate the table was built for, or 0 if it does not depend
+         * on it */
+        double sampleRate;
+
+        auto operator<=>(const Key &) const = default;
+    };
+
+    /**
+     * @brief Get the shared FFT plan of an order. Only for users on a single
+     * thread; see the class description.
+     * @param order log2 of the FFT size.
+     * @return The FFT.
+     */
+    static std::shared_ptr<const juce::dsp::FFT> getFft(int order);
+
+    /**
+     * @brief Get the shared normalised Hann window of an order.
+     * @tparam FloatType The sample type, float or double.
+     * @param order log2 of the window size.
+     * @return The window table.
+     */
+    template<typename FloatType>
+    static std::shared_ptr<const std::vector<FloatType>>
+    getHannWindow(const int order) {
+        static_assert(std::is_same_v<FloatType, float> ||
+                      std::is_same_v<FloatType, double>);
+        const Key key{std::is_same_v<FloatType, float> ? Type::hannWindowFloat
+                                                       : Type::hannWindowDouble,
+                      order, 0.0};
+        const size_t size = size_t{1} << order;
+        return std::static_pointer_cast<const std::vector<FloatType>>(
+                getOrCreate(key, size * sizeof(FloatType), [size] {
+                    auto window = std::make_shared<std::vector<FloatType>>(size);
+                    juce::dsp::WindowingFunction<FloatType>::fillWindowingTables(
+                            window->data(), size,
+                            juce::dsp::WindowingFunction<FloatType>::hann);
+                    return std::shared_ptr<const void>(std::move(window));
+                }));
+    }
+
+    /**
+     * @brief Get the approximate number of bytes held by live tables.
+     * @return The number of bytes.
+     */
+    static size_t getMemoryBytes();
+
+    /**
+     * @brief Get the number of live tables.
+     * @return The number of tables.
+     */
+    static size_t getNumTables();
+
+private:
+    /**
+     * @brief Look a table up, building it if no instance holds it.
+     * @param key The table's key.
+     * @param bytes The approximate size of the table, for accounting.
+     * @param create Builds the table.
+     * @return The table.
+     */
+    static std::shared_ptr<const void>
+    getOrCreate(const Key &key, size_t bytes,
+                const std::function<std::shared_ptr<const void>()> &create);
+};
+
+#endif // SHARED_TABLES_H
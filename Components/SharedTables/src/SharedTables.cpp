@@ -0,0 +1,90 @@
+#include "SharedTables.h"
+
+#include <complex>
+#include <map>
+#include <mutex>
+
+namespace {
+    /**
+     * @brief A table in the cache.
+     */
+    struct Entry {
+        std::weak_ptr<const void> table;
+        size_t bytes = 0;
+    };
+
+    /** Guards the cache; held while a table is built so it is built once */
+    std::mutex cacheMutex;
+
+    /** The cache. Expired entries are pruned on the next lookup */
+    std::map<SharedTables::Key, Entry> cache;
+
+    /**
+     * @brief Remove entries whose tables have been freed. The cache mutex
+     * must be held.
+     */
+    void pruneLocked() {
+        std::erase_if(cache, [](const auto &item) {
+            return item.second.table.expired();
+        });
+    }
+} // namespace
+
+/**
+ * @brief Get the shared FFT plan of an order.
+ * @param order log2 of the FFT size.
+ * @return The FFT.
+ */
+std::shared_ptr<const juce::dsp::FFT> SharedTables::getFft(const int order) {
+    /// The plan's twiddles, one complex table per direction
+    const size_t bytes = sizeof(juce::dsp::FFT) +
+                         2 * (size_t{1} << order) * sizeof(std::complex<float>);
+    return std::static_pointer_cast<const juce::dsp::FFT>(
+            getOrCreate({Type::fft, order, 0.0}, bytes, [order] {
+                return std::shared_ptr<const void>(
+                        std::make_shared<const juce::dsp::FFT>(order));
+            }));
+}
+
+/**
+ * @brief Get the approximate number of bytes held by live tables.
+ * @return The number of bytes.
+ */
+size_t SharedTables::getMemoryBytes() {
+    std::lock_guard lock(cacheMutex);
+    pruneLocked();
+    size_t bytes = 0;
+    for (const auto &[key, entry]: cache)
+        bytes += entry.bytes;
+    return bytes;
+}
+
+/**
+ * @brief Get the number of live tables.
+ * @return The number of tables.
+ */
+size_t SharedTables::getNumTables() {
+    std::lock_guard lock(cacheMutex);
+    pruneLocked();
+    return cache.size();
+}
+
+/**
+ * @brief Look a table up, building it if no instance holds it.
+ * @param key The table's key.
+ * @param bytes The approximate size of the table, for accounting.
+ * @param create Builds the table.
+ * @return The table.
+ */
+std::shared_ptr<const void> SharedTables::getOrCreate(
+        const Key &key, const size_t bytes,
+        const std::function<std::shared_ptr<const void>()> &create) {
+    std::lock_guard lock(cacheMutex);
+    auto &entry = cache[key];
+    if (auto table = entry.table.lock())
+        return table;
+    auto table = create();
+    entry = {table, bytes};
+    pruneLocked();
+    return table;
+}
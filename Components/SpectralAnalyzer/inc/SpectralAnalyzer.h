@@ -3,7 +3,9 @@
 
 #include <algorithm>
 #include <juce_dsp/juce_dsp.h>
+#include <memory>
 #include <vector>
+#include "Kernels.h"
 
 class SpectralAnalyzer {
 public:
@@ -24,8 +26,10 @@ public:
      *
      * @param input Pointer to incoming audio samples.
      * @param numSamples Number of samples in the input buffer.
+     * @param kernels The kernels to window and take magnitudes with.
      */
-    void pushSamples(const float *input, int numSamples);
+    void pushSamples(const float *input, int numSamples,
+                     const Kernels::Table &kernels = Kernels::get());
 
     /**
      * @brief Retrieve the magnitudes of the latest FFT frame.
@@ -42,6 +46,16 @@ public:
      */
     void reset();
 
+    /**
+     * @brief Get the number of bytes held by the analyzer's buffers.
+     *
+     * The window is shared between instances and accounted by SharedTables,
+     * so it is not included.
+     *
+     * @return The approximate number of bytes.
+     */
+    [[nodiscard]] size_t getMemoryBytes() const;
+
 private:
     /** FFT order (e.g., 10 for 1024 samples). */
     int fftOrder;
@@ -55,11 +69,14 @@ private:
     /** FIFO buffer for incoming audio samples. */
     int fifoFill;
 
-    /** FFT object for performing the FFT. */
+    /** FFT object for performing the FFT. Each analyzer has its own plan:
+     * JUCE's fallback engine serialises concurrent transforms on one, and
+     * every instance's analysis thread transforms once per hop. */
     juce::dsp::FFT fft;
 
-    /** Window function to reduce spectral leakage. */
-    std::vector<float> window;
+    /** Window function to reduce spectral leakage, shared between
+     * instances. */
+    std::shared_ptr<const std::vector<float>> window;
 
     /** Time-domain samples buffer. */
     std::vector<float> fifoBuffer;
@@ -75,15 +92,19 @@ private:
      *
      * This method applies the window function, performs the FFT, and computes
      * the magnitude for each frequency bin.
+     *
+     * @param kernels The kernels to use.
      */
-    void processFrame();
+    void processFrame(const Kernels::Table &kernels);
 
     /**
      * @brief Compute the magnitude spectrum from the FFT result.
      *
+     * @param kernels The kernels to use.
      * @return A vector containing the magnitude for each frequency bin.
      */
-    [[nodiscard]] std::vector<float> computeMagnitudes() const;
+    [[nodiscard]] std::vector<float>
+    computeMagnitudes(const Kernels::Table &kernels) const;
 };
 
 #endif // SPECTRAL_ANALYZER_H
@@ -1,6 +1,7 @@
 #include "SpectralAnalyzer.h"
 
 #include <cmath>
+#include "SharedTables.h"
 
 /**
  * @brief Constructor for the SpectralAnalyzer.
@@ -12,11 +13,8 @@
 SpectralAnalyzer::SpectralAnalyzer(const int fftOrder, const int hopSizeIn) :
     fftOrder(fftOrder), fftSize(1 << fftOrder),
     hopSize(hopSizeIn > 0 ? hopSizeIn : (1 << fftOrder) / 2), fifoFill(0),
-    fft(fftOrder) {
-    /// Initialize the Hann window to reduce spectral leakage.
-    window.resize(fftSize);
-    juce::dsp::WindowingFunction<float>::fillWindowingTables(
-            window.data(), fftSize, juce::dsp::WindowingFunction<float>::hann);
+    fft(fftOrder),
+    window(SharedTables::getHannWindow<float>(fftOrder)) {
     /// Allocate FIFO buffer for the incoming time-domain samples.
     fifoBuffer.resize(fftSize, 0.0f);
     /// Allocate buffer for the FFT result (frequency domain).
@@ -31,8 +29,10 @@ SpectralAnalyzer::SpectralAnalyzer(const int fftOrder, const int hopSizeIn) :
  *
  * @param input Pointer to incoming audio samples.
  * @param numSamples Number of samples in the input buffer.
+ * @param kernels The kernels to window and take magnitudes with.
  */
-void SpectralAnalyzer::pushSamples(const float *input, const int numSamples) {
+void SpectralAnalyzer::pushSamples(const float *input, const int numSamples,
+                                   const Kernels::Table &kernels) {
     int index = 0;
     while (index < numSamples) {
         /// Determine how many samples can be copied into the FIFO buffer.
@@ -45,7 +45,7 @@ void SpectralAnalyzer::pushSamples(const float *input, const int numSamples) {
         /// If we have filled the FIFO buffer with fftSize samples, process
         /// the frame.
         if (fifoFill == fftSize) {
-            processFrame();
+            processFrame(kernels);
             /// Shift the buffer left by hopSize samples to prepare for the
             /// next frame.
             std::copy(fifoBuffer.begin() + hopSize, fifoBuffer.end(),
@@ -65,38 +65,49 @@ void SpectralAnalyzer::reset() {
     latestMagnitudes.clear();
 }
 
+/**
+ * @brief Get the number of bytes held by the analyzer's buffers.
+ * @return The approximate number of bytes.
+ */
+size_t SpectralAnalyzer::getMemoryBytes() const {
+    /// The FFT plan's twiddles, one complex table per direction
+    const size_t floats = fifoBuffer.capacity() +
+                          frequencyDomainBuffer.capacity() +
+                          latestMagnitudes.capacity() +
+                          4 * static_cast<size_t>(fftSize);
+    return sizeof(SpectralAnalyzer) + floats * sizeof(float);
+}
+
 /**
  * @brief Process a full FFT frame using the data in the FIFO buffer.
  *
  * This method applies the window function, performs the FFT, and computes
  * the magnitude for each frequency bin.
+ *
+ * @param kernels The kernels to use.
  */
-void SpectralAnalyzer::processFrame() {
-    /// Create a temporary frame and apply the window.
-    std::vector<float> frame(fifoBuffer.begin(), fifoBuffer.begin() + fftSize);
-    for (int i = 0; i < fftSize; ++i)
-        frame[i] *= window[i];
-    /// Copy windowed data to the frequency domain buffer.
-    std::copy_n(frame.begin(), fftSize, frequencyDomainBuffer.begin());
+void SpectralAnalyzer::processFrame(const Kernels::Table &kernels) {
+    /// Window the frame straight into the frequency domain buffer.
+    kernels.multiply(frequencyDomainBuffer.data(), fifoBuffer.data(),
+                     window->data(), fftSize);
     /// Perform an in-place FFT. This uses a real-only FFT transform.
     fft.performRealOnlyForwardTransform(frequencyDomainBuffer.data(), true);
     /// Compute magnitudes for the FFT bins.
-    latestMagnitudes = computeMagnitudes();
+    latestMagnitudes = computeMagnitudes(kernels);
 }
 
 /**
  * @brief Compute the magnitude spectrum from the FFT result.
  *
+ * @param kernels The kernels to use.
  * @return A vector containing the magnitude for each frequency bin.
  */
-std::vector<float> SpectralAnalyzer::computeMagnitudes() const {
+std::vector<float>
+SpectralAnalyzer::computeMagnitudes(const Kernels::Table &kernels) const {
     std::vector<float> magnitudes(fftSize / 2);
     /// DC component
     magnitudes[0] = std::abs(frequencyDomainBuffer[0]);
-    for (int i = 1; i < fftSize / 2; ++i) {
-        const float real = frequencyDomainBuffer[2 * i];
-        const float imag = frequencyDomainBuffer[2 * i + 1];
-        magnitudes[i] = std::sqrt(real * real + imag * imag);
-    }
+    kernels.magnitudes(magnitudes.data() + 1, frequencyDomainBuffer.data() + 2,
+                       fftSize / 2 - 1);
     return magnitudes;
 }
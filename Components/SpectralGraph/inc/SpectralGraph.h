@@ -25,6 +25,15 @@ public:
      */
     void buildGraph(const std::vector<float> &magnitudes, float sampleRate,
                     int fftSize);
+
+    /**
+     * @brief Get the number of bytes held by the node and edge storage.
+     * @return The number of bytes.
+     */
+    [[nodiscard]] size_t getMemoryBytes() const {
+        return nodes.capacity() * sizeof(GraphNode) +
+               edges.capacity() * sizeof(GraphEdge);
+    }
 };
 
 #endif // SPECTRAL_GRAPH_H
@@ -0,0 +1,198 @@
+#ifndef TEST_SIGNAL_GENERATOR_H
+#define TEST_SIGNAL_GENERATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Seeded, streamable generator of synthetic test signals.
+ *
+ * Produces signals with controlled spectral content for benchmarks and tools
+ * without checking audio files into the tree. The generator uses its own
+ * random number generator and noise filters rather than the standard library
+ * distributions, so a given seed produces the same signal on every platform
+ * (up to the last bit of the platform's sin/exp). Calls to generate() continue
+ * where the previous call stopped, so a signal can be streamed in blocks of
+ * any size and is identical to generating it in one go.
+ */
+class TestSignalGenerator {
+public:
+    /**
+     * @brief The kinds of signal the generator can produce.
+     */
+    enum class Type {
+        silence,
+        whiteNoise,
+        pinkNoise,
+        harmonicTone,
+        chord,
+        drums,
+        sweep,
+        burstWithTail
+    };
+
+    /**
+     * @brief Settings describing a signal.
+     */
+    struct Settings {
+        /** The kind of signal. */
+        Type type = Type::whiteNoise;
+        /** The sample rate in Hz. */
+        double sampleRate = 48000.0;
+        /** The seed for the noise sources. */
+        uint64_t seed = 1;
+        /** The peak amplitude of the signal. */
+        float amplitude = 0.25f;
+        /** The fundamental of the harmonic tone in Hz. */
+        double fundamental = 220.0;
+        /** The fundamentals of the chord notes in Hz. */
+        std::vector<double> chordFundamentals{220.0, 277.18, 329.63};
+        /** The number of partials of each tone, including the fundamental. */
+        int numPartials = 8;
+        /** Partial k has amplitude 1/k^rolloff. */
+        double partialRolloff = 1.0;
+        /** The tempo of the drum pattern in beats per minute. */
+        double tempo = 120.0;
+        /** The start frequency of the sweep in Hz. */
+        double sweepStart = 20.0;
+        /** The end frequency of the sweep in Hz. */
+        double sweepEnd = 20000.0;
+        /** The length of one sweep in seconds. */
+        double sweepSeconds = 10.0;
+        /** The length of the noise burst in seconds. */
+        double burstSeconds = 0.25;
+        /** The length of the silence after each burst in seconds. */
+        double tailSeconds = 4.0;
+    };
+
+    /**
+     * @brief Constructor for the TestSignalGenerator.
+     * @param settingsIn The settings describing the signal.
+     */
+    explicit TestSignalGenerator(const Settings &settingsIn);
+
+    /**
+     * @brief Generate the next block of the signal.
+     * @param output Pointer to the output samples.
+     * @param numSamples Number of samples to generate.
+     */
+    void generate(float *output, int numSamples);
+
+    /**
+     * @brief Restart the signal from its first sample.
+     */
+    void reset();
+
+    /**
+     * @brief Get the settings describing the signal.
+     * @return The settings.
+     */
+    [[nodiscard]] const Settings &getSettings() const { return settings; }
+
+    /**
+     * @brief Get the number of samples generated since the last reset.
+     * @return The sample position.
+     */
+    [[nodiscard]] int64_t getPosition() const { return position; }
+
+    /**
+     * @brief Get the names of the standard test corpus.
+     * @return The signal names, in a fixed order.
+     */
+    static std::vector<std::string> getCorpusNames();
+
+    /**
+     * @brief Get the settings of a signal in the standard test corpus.
+     *
+     * Benchmarks that use the corpus signals can be compared across machines.
+     *
+     * @param name The corpus signal name.
+     * @param sampleRate The sample rate in Hz.
+     * @param seed The seed for the noise sources.
+     * @return The settings, or white noise if the name is unknown.
+     */
+    static Settings getCorpusSettings(const std::string &name,
+                                      double sampleRate, uint64_t seed = 1);
+
+private:
+    /** The settings describing the signal. */
+    Settings settings;
+
+    /** The number of samples generated since the last reset. */
+    int64_t position = 0;
+
+    /** State of the random number generator. */
+    uint64_t rngState = 0;
+
+    /** State of the pink noise filter. */
+    double pink[7]{};
+
+    /** Phase of each oscillator, in cycles. */
+    std::vector<double> phases;
+
+    /** Phase increment of each oscillator, in cycles per sample. */
+    std::vector<double> increments;
+
+    /** Gain of each oscillator, including the normalisation. */
+    std::vector<float> gains;
+
+    /** Number of samples in one drum pattern step. */
+    int64_t samplesPerStep = 1;
+
+    /** Samples since the kick, snare and hi-hat were last triggered. */
+    int64_t kickAge = 0, snareAge = 0, hatAge = 0;
+
+    /** Sweep phase, in cycles. */
+    double sweepPhase = 0.0;
+
+    /** Phase of the kick drum oscillator, in cycles. */
+    double kickPhase = 0.0;
+
+    /** Previous white noise sample, used to high-pass the hi-hat. */
+    float previousNoise = 0.0f;
+
+    /**
+     * @brief Get the next white noise sample.
+     * @return A sample uniformly distributed in [-1, 1).
+     */
+    float nextWhite();
+
+    /**
+     * @brief Get the next pink noise sample.
+     * @return A sample with a 1/f spectrum and roughly unit peak.
+     */
+    float nextPink();
+
+    /**
+     * @brief Set up the oscillators for a sum of harmonic tones.
+     * @param fundamentals The fundamental of each tone in Hz.
+     */
+    void prepareHarmonics(const std::vector<double> &fundamentals);
+
+    /**
+     * @brief Get the next sample of the harmonic oscillators.
+     * @return The next sample, normalised to unit peak.
+     */
+    float nextHarmonics();
+
+    /**
+     * @brief Get the next sample of the drum pattern.
+     * @return The next sample.
+     */
+    float nextDrums();
+
+    /**
+     * @brief Get the next sample of the exponential sine sweep.
+     * @return The next sample.
+     */
+    float nextSweep();
+
+    /**
+     * @brief Get the next sample of the repeating burst and silent tail.
+     * @return The next sample.
+     */
+    float nextBurstWithTail();
+};
+
+#endif // TEST_SIGNAL_GENERATOR_H
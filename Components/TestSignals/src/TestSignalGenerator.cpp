@@ -0,0 +1,296 @@
+#include "TestSignalGenerator.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    /** Two pi, for converting phases in cycles to radians. */
+    constexpr double twoPi = 6.283185307179586476925286766559;
+
+    /** Number of steps in the drum pattern (one bar of sixteenth notes). */
+    constexpr int64_t stepsPerPattern = 16;
+
+    /** Samples since a voice was last triggered, before its first trigger. */
+    constexpr int64_t neverTriggered = INT64_MAX / 2;
+} // namespace
+
+/**
+ * @brief Constructor for the TestSignalGenerator.
+ * @param settingsIn The settings describing the signal.
+ */
+TestSignalGenerator::TestSignalGenerator(const Settings &settingsIn) :
+    settings(settingsIn) {
+    if (settings.type == Type::harmonicTone)
+        prepareHarmonics({settings.fundamental});
+    else if (settings.type == Type::chord)
+        prepareHarmonics(settings.chordFundamentals);
+    samplesPerStep = std::max<int64_t>(
+            1, std::llround(settings.sampleRate * 60.0 /
+                            (settings.tempo * 4.0)));
+    reset();
+}
+
+/**
+ * @brief Generate the next block of the signal.
+ * @param output Pointer to the output samples.
+ * @param numSamples Number of samples to generate.
+ */
+void TestSignalGenerator::generate(float *output, const int numSamples) {
+    for (int i = 0; i < numSamples; ++i) {
+        float sample = 0.0f;
+        switch (settings.type) {
+            case Type::silence:
+                break;
+            case Type::whiteNoise:
+                sample = nextWhite();
+                break;
+            case Type::pinkNoise:
+                sample = nextPink();
+                break;
+            case Type::harmonicTone:
+            case Type::chord:
+                sample = nextHarmonics();
+                break;
+            case Type::drums:
+                sample = nextDrums();
+                break;
+            case Type::sweep:
+                sample = nextSweep();
+                break;
+            case Type::burstWithTail:
+                sample = nextBurstWithTail();
+                break;
+        }
+        output[i] = settings.amplitude * sample;
+        ++position;
+    }
+}
+
+/**
+ * @brief Restart the signal from its first sample.
+ */
+void TestSignalGenerator::reset() {
+    position = 0;
+    rngState = settings.seed;
+    std::fill(std::begin(pink), std::end(pink), 0.0);
+    std::fill(phases.begin(), phases.end(), 0.0);
+    sweepPhase = 0.0;
+    kickPhase = 0.0;
+    previousNoise = 0.0f;
+    kickAge = snareAge = hatAge = neverTriggered;
+}
+
+/**
+ * @brief Get the names of the standard test corpus.
+ * @return The signal names, in a fixed order.
+ */
+std::vector<std::string> TestSignalGenerator::getCorpusNames() {
+    return {"silence",      "white-noise",   "pink-noise",
+            "harmonic-a3",  "chord-a-major", "drums-120bpm",
+            "sweep-20-20k", "burst-tail"};
+}
+
+/**
+ * @brief Get the settings of a signal in the standard test corpus.
+ * @param name The corpus signal name.
+ * @param sampleRate The sample rate in Hz.
+ * @param seed The seed for the noise sources.
+ * @return The settings, or white noise if the name is unknown.
+ */
+TestSignalGenerator::Settings
+TestSignalGenerator::getCorpusSettings(const std::string &name,
+                                       const double sampleRate,
+                                       const uint64_t seed) {
+    Settings corpus;
+    corpus.sampleRate = sampleRate;
+    corpus.seed = seed;
+    if (name == "silence") {
+        corpus.type = Type::silence;
+    } else if (name == "pink-noise") {
+        corpus.type = Type::pinkNoise;
+    } else if (name == "harmonic-a3") {
+        corpus.type = Type::harmonicTone;
+        corpus.fundamental = 220.0;
+        corpus.numPartials = 12;
+    } else if (name == "chord-a-major") {
+        corpus.type = Type::chord;
+        corpus.chordFundamentals = {220.0, 277.18, 329.63, 440.0};
+        corpus.numPartials = 8;
+    } else if (name == "drums-120bpm") {
+        corpus.type = Type::drums;
+        corpus.tempo = 120.0;
+        corpus.amplitude = 0.5f;
+    } else if (name == "sweep-20-20k") {
+        corpus.type = Type::sweep;
+        corpus.sweepStart = 20.0;
+        corpus.sweepEnd = std::min(20000.0, 0.45 * sampleRate);
+        corpus.sweepSeconds = 10.0;
+    } else if (name == "burst-tail") {
+        corpus.type = Type::burstWithTail;
+        corpus.amplitude = 0.5f;
+    }
+    return corpus;
+}
+
+/**
+ * @brief Get the next white noise sample.
+ * @return A sample uniformly distributed in [-1, 1).
+ */
+float TestSignalGenerator::nextWhite() {
+    /// SplitMix64, which is fully specified and so identical everywhere
+    uint64_t z = (rngState += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    /// Top 24 bits give an exactly representable float in [0, 1)
+    const float unit = static_cast<float>(z >> 40) * (1.0f / 16777216.0f);
+    return 2.0f * unit - 1.0f;
+}
+
+/**
+ * @brief Get the next pink noise sample.
+ * @return A sample with a 1/f spectrum and roughly unit peak.
+ */
+float TestSignalGenerator::nextPink() {
+    /// Paul Kellet's refined pink noise filter
+    const double white = nextWhite();
+    pink[0] = 0.99886 * pink[0] + white * 0.0555179;
+    pink[1] = 0.99332 * pink[1] + white * 0.0750759;
+    pink[2] = 0.96900 * pink[2] + white * 0.1538520;
+    pink[3] = 0.86650 * pink[3] + white * 0.3104856;
+    pink[4] = 0.55000 * pink[4] + white * 0.5329522;
+    pink[5] = -0.7616 * pink[5] - white * 0.0168980;
+    const double out = pink[0] + pink[1] + pink[2] + pink[3] + pink[4] +
+                       pink[5] + pink[6] + white * 0.5362;
+    pink[6] = white * 0.115926;
+    return static_cast<float>(out * 0.11);
+}
+
+/**
+ * @brief Set up the oscillators for a sum of harmonic tones.
+ * @param fundamentals The fundamental of each tone in Hz.
+ */
+void TestSignalGenerator::prepareHarmonics(
+        const std::vector<double> &fundamentals) {
+    increments.clear();
+    gains.clear();
+    const double nyquist = 0.5 * settings.sampleRate;
+    double totalGain = 0.0;
+    for (const double f0: fundamentals) {
+        for (int k = 1; k <= settings.numPartials; ++k) {
+            /// Skip partials that would alias
+            if (f0 * k >= nyquist)
+                break;
+            const double gain =
+                    1.0 / std::pow(static_cast<double>(k),
+                                   settings.partialRolloff);
+            increments.push_back(f0 * k / settings.sampleRate);
+            gains.push_back(static_cast<float>(gain));
+            totalGain += gain;
+        }
+    }
+    if (totalGain > 0.0)
+        for (float &gain: gains)
+            gain = static_cast<float>(gain / totalGain);
+    phases.assign(increments.size(), 0.0);
+}
+
+/**
+ * @brief Get the next sample of the harmonic oscillators.
+ * @return The next sample, normalised to unit peak.
+ */
+float TestSignalGenerator::nextHarmonics() {
+    double out = 0.0;
+    for (size_t i = 0; i < phases.size(); ++i) {
+        out += gains[i] * std::sin(twoPi * phases[i]);
+        phases[i] += increments[i];
+        if (phases[i] >= 1.0)
+            phases[i] -= 1.0;
+    }
+    return static_cast<float>(out);
+}
+
+/**
+ * @brief Get the next sample of the drum pattern.
+ * @return The next sample.
+ */
+float TestSignalGenerator::nextDrums() {
+    /// Kick on 1, 3 and the "and" of 3, snare on 2 and 4, hi-hat on eighths
+    if (position % samplesPerStep == 0) {
+        const int64_t step = (position / samplesPerStep) % stepsPerPattern;
+        if (step == 0 || step == 8 || step == 10) {
+            kickAge = 0;
+            kickPhase = 0.0;
+        }
+        if (step == 4 || step == 12)
+            snareAge = 0;
+        if (step % 2 == 0)
+            hatAge = 0;
+    }
+    const double sr = settings.sampleRate;
+    double out = 0.0;
+    if (kickAge < neverTriggered) {
+        const double t = static_cast<double>(kickAge) / sr;
+        const double frequency = 50.0 + 100.0 * std::exp(-30.0 * t);
+        out += std::exp(-8.0 * t) * std::sin(twoPi * kickPhase);
+        kickPhase += frequency / sr;
+        ++kickAge;
+    }
+    const float white = nextWhite();
+    if (snareAge < neverTriggered) {
+        const double t = static_cast<double>(snareAge) / sr;
+        out += 0.6 * std::exp(-20.0 * t) * white +
+               0.4 * std::exp(-15.0 * t) * std::sin(twoPi * 180.0 * t);
+        ++snareAge;
+    }
+    if (hatAge < neverTriggered) {
+        const double t = static_cast<double>(hatAge) / sr;
+        out += 0.3 * std::exp(-60.0 * t) * (white - previousNoise);
+        ++hatAge;
+    }
+    previousNoise = white;
+    return static_cast<float>(std::clamp(out, -1.0, 1.0));
+}
+
+/**
+ * @brief Get the next sample of the exponential sine sweep.
+ * @return The next sample.
+ */
+float TestSignalGenerator::nextSweep() {
+    const double sr = settings.sampleRate;
+    const auto sweepSamples =
+            std::max<int64_t>(1, std::llround(settings.sweepSeconds * sr));
+    const double t = static_cast<double>(position % sweepSamples) / sr;
+    const double frequency =
+            settings.sweepStart *
+            std::exp(t / settings.sweepSeconds *
+                     std::log(settings.sweepEnd / settings.sweepStart));
+    const auto out = static_cast<float>(std::sin(twoPi * sweepPhase));
+    sweepPhase += frequency / sr;
+    if (sweepPhase >= 1.0)
+        sweepPhase -= 1.0;
+    return out;
+}
+
+/**
+ * @brief Get the next sample of the repeating burst and silent tail.
+ * @return The next sample.
+ */
+float TestSignalGenerator::nextBurstWithTail() {
+    const double sr = settings.sampleRate;
+    const auto burstSamples =
+            std::max<int64_t>(1, std::llround(settings.burstSeconds * sr));
+    const auto periodSamples =
+            burstSamples + std::llround(settings.tailSeconds * sr);
+    const int64_t offset = position % periodSamples;
+    if (offset >= burstSamples)
+        return 0.0f;
+    /// Short linear ramps so the burst edges do not click
+    const auto rampSamples = std::max<int64_t>(1, std::llround(0.002 * sr));
+    const int64_t edge = std::min(offset, burstSamples - 1 - offset);
+    const float ramp =
+            edge < rampSamples
+                    ? static_cast<float>(edge) / static_cast<float>(rampSamples)
+                    : 1.0f;
+    return ramp * nextWhite();
+}
@@ -102,5 +102,11 @@ bool ButtonComponent::isBypassed() const {
  * @brief Called when the parameter value changes.
  */
 void ButtonComponent::parameterChanged(const juce::String &, float) {
-    juce::MessageManager::callAsync([this]() { repaint(); });
+    /// The parameter may change on any thread, and the button may be deleted
+    /// before the message thread gets to the repaint.
+    juce::MessageManager::callAsync(
+            [safeThis = juce::Component::SafePointer<ButtonComponent>(this)] {
+                if (safeThis != nullptr)
+                    safeThis->repaint();
+            });
 }
@@ -2,10 +2,20 @@
 #define AUDIO_BUFFER_QUEUE_H
 
 #include <array>
+#include <atomic>
 #include <juce_audio_basics/juce_audio_basics.h>
+#include <span>
 
 /**
  * @brief AudioBufferQueue class
+ *
+ * A lock-free ring of fixed-size windows between one writer on the audio
+ * thread and one reader on the message thread. The writer fills a window in
+ * place and publishes it once it is complete; the reader looks at the newest
+ * published window in place and releases it. No window is ever copied in or
+ * out, and neither side ever waits: a writer finding every window taken
+ * simply skips one.
+ *
  * @tparam T Type of the audio samples (e.g., float, double)
  */
 template<typename T>
@@ -21,41 +31,86 @@ public:
     static constexpr size_t numBuffers = 10;
 
     /**
-     * @brief Push data into the queue.
-     * @param dataToPush Pointer to the data to be pushed into the queue.
-     * @param numSamples Number of samples to push into the queue.
+     * @brief Get the window to write next. Writer only.
+     *
+     * The same window is returned until it is published with finishWrite().
+     *
+     * @return The window, bufferSize samples long, or null if every window
+     * is waiting to be read.
      */
-    void push(const T *dataToPush, const size_t numSamples) {
-        jassert(numSamples <= bufferSize);
+    T *beginWrite() {
         int start1, size1, start2, size2;
         abstractFifo.prepareToWrite(1, start1, size1, start2, size2);
-        jassert(size1 <= 1);
         jassert(size2 == 0);
-        if (size1 > 0)
-            juce::FloatVectorOperations::copy(
-                    buffers[static_cast<size_t>(start1)].data(), dataToPush,
-                    static_cast<int>(juce::jmin(bufferSize, numSamples)));
-        abstractFifo.finishedWrite(size1);
+        return size1 > 0 ? buffers[static_cast<size_t>(start1)].data()
+                         : nullptr;
     }
 
     /**
-     * @brief Pop data from the queue.
-     * @param outputBuffer Pointer to the buffer where the popped data will be
-     * stored.
+     * @brief Publish the window returned by beginWrite(). Writer only.
      */
-    void pop(T *outputBuffer) {
+    void finishWrite() {
+        abstractFifo.finishedWrite(1);
+        if (const int ready = abstractFifo.getNumReady();
+            ready > highWaterMark.load(std::memory_order_relaxed))
+            highWaterMark.store(ready, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the newest published window, dropping any older ones.
+     * Reader only. The window stays valid until release().
+     * @return The window, or an empty span if nothing new was published.
+     */
+    std::span<const T> acquireLatest() {
+        if (const int ready = abstractFifo.getNumReady(); ready > 1)
+            abstractFifo.finishedRead(ready - 1);
         int start1, size1, start2, size2;
         abstractFifo.prepareToRead(1, start1, size1, start2, size2);
-        jassert(size1 <= 1);
         jassert(size2 == 0);
-        if (size1 > 0)
-            juce::FloatVectorOperations::copy(
-                    outputBuffer, buffers[static_cast<size_t>(start1)].data(),
-                    static_cast<int>(bufferSize));
-        abstractFifo.finishedRead(size1);
+        if (size1 == 0)
+            return {};
+        return {buffers[static_cast<size_t>(start1)].data(), bufferSize};
+    }
+
+    /**
+     * @brief Hand the window from acquireLatest() back to the writer.
+     * Reader only.
+     */
+    void release() { abstractFifo.finishedRead(1); }
+
+    /**
+     * @brief Register or unregister a reader. The writer does nothing while
+     * there is none.
+     * @param attached True when a reader starts reading, false when it stops.
+     */
+    void setReaderAttached(const bool attached) {
+        readers.fetch_add(attached ? 1 : -1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Check if anyone reads the windows.
+     * @return True if a reader is attached.
+     */
+    bool hasReader() const {
+        return readers.load(std::memory_order_relaxed) > 0;
+    }
+
+    /**
+     * @brief Get the largest number of buffers that have been waiting to be
+     * read at once.
+     * @return The high-water mark in buffers.
+     */
+    int getHighWaterMark() const {
+        return highWaterMark.load(std::memory_order_relaxed);
     }
 
 private:
+    /** Largest number of buffers waiting to be read at once */
+    std::atomic<int> highWaterMark{0};
+
+    /** Number of attached readers */
+    std::atomic<int> readers{0};
+
     /** FIFO implementation to manage the buffers */
     juce::AbstractFifo abstractFifo{numBuffers};
 
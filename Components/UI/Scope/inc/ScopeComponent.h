@@ -2,11 +2,13 @@
 #define SCOPE_COMPONENT_H
 
 #include <array>
+#include <span>
 #include <juce_audio_utils/juce_audio_utils.h>
 #include <juce_core/juce_core.h>
 #include <juce_dsp/juce_dsp.h>
 #include <juce_graphics/juce_graphics.h>
 #include "AudioBufferQueue.h"
+#include "SharedTables.h"
 
 /**
  * @brief ScopeComponent class that displays an oscilloscope and spectrum
@@ -25,10 +27,17 @@ public:
      * @param queueToUse The audio buffer queue to use for displaying samples.
      */
     explicit ScopeComponent(Queue &queueToUse) : audioBufferQueue(queueToUse) {
-        sampleData.fill(SampleType(0));
+        spectrumData.fill(SampleType(0));
+        smoothedSpectrum.fill(SampleType(0));
+        audioBufferQueue.setReaderAttached(true);
         setFramesPerSecond(30);
     }
 
+    /**
+     * @brief Destructor for the ScopeComponent. Stops the collection.
+     */
+    ~ScopeComponent() override { audioBufferQueue.setReaderAttached(false); }
+
     /**
      * @brief Set the frames per second for the timer.
      * @param framesPerSecond The number of frames per second to set for the
@@ -73,18 +82,14 @@ private:
      * stored. */
     Queue &audioBufferQueue;
 
-    /** Buffer to hold the collected samples. The size of the buffer is
-     * determined by the buffer size of the audio buffer queue. */
-    std::array<SampleType, Queue::bufferSize> sampleData;
-
-    /** FFT object for performing the Fast Fourier Transform. */
-    juce::dsp::FFT fft{Queue::order};
-
-    /** Windowing function for the FFT. */
-    using WindowFun = juce::dsp::WindowingFunction<SampleType>;
+    /** FFT object for performing the Fast Fourier Transform, shared with
+     * every other scope; they all transform on the message thread. */
+    std::shared_ptr<const juce::dsp::FFT> fft =
+            SharedTables::getFft(Queue::order);
 
-    /** Windowing function instance. */
-    WindowFun windowFun{static_cast<size_t>(fft.getSize()), WindowFun::hann};
+    /** Hann window for the FFT, shared with every other scope. */
+    std::shared_ptr<const std::vector<SampleType>> window =
+            SharedTables::getHannWindow<SampleType>(Queue::order);
 
     /** Buffer to hold the spectrum data. The size is twice the FFT size
      * because the FFT returns complex numbers (real and imaginary parts). */
@@ -98,14 +103,19 @@ private:
      * updates the spectrum data for display.
      */
     void timerCallback() override {
-        audioBufferQueue.pop(sampleData.data());
-        juce::FloatVectorOperations::copy(spectrumData.data(),
-                                          sampleData.data(),
-                                          static_cast<int>(sampleData.size()));
-        auto fftSize = static_cast<size_t>(fft.getSize());
+        /// Read the newest window in place; the FFT works on its own copy
+        const std::span<const SampleType> samples =
+                audioBufferQueue.acquireLatest();
+        if (samples.empty())
+            return;
+        std::copy(samples.begin(), samples.end(), spectrumData.begin());
+        audioBufferQueue.release();
+        auto fftSize = static_cast<size_t>(fft->getSize());
         jassert(spectrumData.size() == 2 * fftSize);
-        windowFun.multiplyWithWindowingTable(spectrumData.data(), fftSize);
-        fft.performFrequencyOnlyForwardTransform(spectrumData.data());
+        juce::FloatVectorOperations::multiply(spectrumData.data(),
+                                              window->data(),
+                                              static_cast<int>(fftSize));
+        fft->performFrequencyOnlyForwardTransform(spectrumData.data());
         static constexpr auto mindB = SampleType(-160);
         static constexpr auto maxdB = SampleType(0);
         for (size_t i = 0; i < fftSize; ++i) {
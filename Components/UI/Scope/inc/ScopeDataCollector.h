@@ -5,12 +5,18 @@
 #ifndef SCOPE_DATA_COLLECTOR_H
 #define SCOPE_DATA_COLLECTOR_H
 
-#include <array>
+#include <algorithm>
 #include "AudioBufferQueue.h"
 
 /**
  * @brief ScopeDataCollector class that collects audio samples for a scope
  * component.
+ *
+ * Windows start on a rising edge through the trigger level, so successive
+ * windows line up, or after a window's worth of samples without one, so
+ * silence and DC still show. Samples are written straight into the queue's
+ * window. Nothing is done while no scope is reading the queue.
+ *
  * @tparam SampleType The type of audio samples to collect (e.g., float,
  * double).
  */
@@ -30,34 +36,66 @@ public:
      * @param data Pointer to the audio samples to process.
      * @param numSamples The number of samples to process.
      */
-    void process(const SampleType* data, size_t numSamples) {
-        while (numSamples > 0) {
-            const auto samplesToCopy = std::min(buffer.size() - numCollected, numSamples);
-            std::copy(data, data + samplesToCopy, buffer.begin() + numCollected);
-
-            numCollected += samplesToCopy;
-            data += samplesToCopy;
-            numSamples -= samplesToCopy;
-
-            if (numCollected == buffer.size()) {
-                audioBufferQueue.push(buffer.data(), buffer.size());
+    void process(const SampleType *data, const size_t numSamples) {
+        if (!audioBufferQueue.hasReader()) {
+            /// The unpublished window is simply handed out again later
+            state = State::waitingForTrigger;
+            return;
+        }
+        size_t index = 0;
+        while (index < numSamples) {
+            if (state == State::waitingForTrigger) {
+                for (; index < numSamples; ++index) {
+                    const SampleType sample = data[index];
+                    const bool rising =
+                            prevSample < triggerLevel && sample >= triggerLevel;
+                    prevSample = sample;
+                    if (rising || ++samplesWaited >= Queue::bufferSize)
+                        break;
+                }
+                if (index == numSamples)
+                    return;
+                samplesWaited = 0;
+                window = audioBufferQueue.beginWrite();
+                /// The scope is behind; wait for the next trigger
+                if (window == nullptr) {
+                    ++index;
+                    continue;
+                }
+                state = State::collecting;
                 numCollected = 0;
             }
+            const auto count =
+                    std::min(Queue::bufferSize - numCollected,
+                             numSamples - index);
+            std::copy_n(data + index, count, window + numCollected);
+            numCollected += count;
+            index += count;
+            prevSample = data[index - 1];
+            if (numCollected == Queue::bufferSize) {
+                audioBufferQueue.finishWrite();
+                state = State::waitingForTrigger;
+            }
         }
     }
 
 private:
+    /** Type alias for the audio buffer queue. */
+    using Queue = AudioBufferQueue<SampleType>;
+
     /** Reference to the audio buffer queue where collected samples are
      * stored. */
-    AudioBufferQueue<SampleType> &audioBufferQueue;
+    Queue &audioBufferQueue;
 
-    /** Buffer to hold the collected samples. The size of the buffer is
-     * determined by the bufferSize defined in the AudioBufferQueue. */
-    std::array<SampleType, AudioBufferQueue<SampleType>::bufferSize> buffer;
+    /** Queue window being filled while collecting. */
+    SampleType *window = nullptr;
 
-    /** Number of samples collected in the current buffer. */
+    /** Number of samples collected in the current window. */
     size_t numCollected{};
 
+    /** Number of samples scanned without a trigger. */
+    size_t samplesWaited{};
+
     /** Previous sample value to detect trigger level crossing. */
     SampleType prevSample = SampleType(100);
 
@@ -0,0 +1,54 @@
+#ifndef TELEMETRY_OVERLAY_H
+#define TELEMETRY_OVERLAY_H
+
+#include <juce_gui_basics/juce_gui_basics.h>
+#include "Graphverb.h"
+
+/**
+ * @brief A text overlay showing the processor's runtime telemetry.
+ *
+ * Hidden by default; the editor toggles it. It never intercepts the mouse, so
+ * the controls underneath stay usable while it is shown.
+ */
+class TelemetryOverlay final : public juce::Component, juce::Timer {
+public:
+    /**
+     * @brief Constructs a TelemetryOverlay object.
+     * @param p The GraphVerb processor to report on.
+     */
+    explicit TelemetryOverlay(Graphverb &p);
+
+    /**
+     * @brief Paints the component.
+     * @param g The graphics context to paint on.
+     */
+    void paint(juce::Graphics &g) override;
+
+    /**
+     * @brief Start or stop refreshing when the overlay is shown or hidden.
+     */
+    void visibilityChanged() override;
+
+    /**
+     * @brief Called when the timer expires.
+     */
+    void timerCallback() override;
+
+private:
+    /** Reference to the GraphVerb processor. */
+    Graphverb &processor;
+
+    /** The lines of text currently shown. */
+    juce::StringArray lines;
+
+    /**
+     * @brief Format a byte count for display.
+     * @param bytes The byte count.
+     * @return The formatted string, e.g. "1.3 MB".
+     */
+    static juce::String formatBytes(size_t bytes);
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TelemetryOverlay)
+};
+
+#endif // TELEMETRY_OVERLAY_H
@@ -0,0 +1,97 @@
+#include "TelemetryOverlay.h"
+#include "KernelAutotuner.h"
+#include "Kernels.h"
+#include "SharedTables.h"
+
+/**
+ * @brief Constructs a TelemetryOverlay object.
+ * @param p The GraphVerb processor to report on.
+ */
+TelemetryOverlay::TelemetryOverlay(Graphverb &p) : processor(p) {
+    setInterceptsMouseClicks(false, false);
+    setVisible(false);
+}
+
+/**
+ * @brief Paints the component.
+ * @param g The graphics context to paint on.
+ */
+void TelemetryOverlay::paint(juce::Graphics &g) {
+    g.fillAll(juce::Colours::black.withAlpha(0.7f));
+    g.setColour(juce::Colours::white);
+    g.setFont(juce::Font(juce::FontOptions(
+            juce::Font::getDefaultMonospacedFontName(), 11.0f,
+            juce::Font::plain)));
+    auto area = getLocalBounds().reduced(6);
+    for (const auto &line: lines)
+        g.drawText(line, area.removeFromTop(14),
+                   juce::Justification::centredLeft, true);
+}
+
+/**
+ * @brief Start or stop refreshing when the overlay is shown or hidden.
+ */
+void TelemetryOverlay::visibilityChanged() {
+    if (isVisible()) {
+        timerCallback();
+        startTimerHz(4);
+    } else {
+        stopTimer();
+    }
+}
+
+/**
+ * @brief Called when the timer expires.
+ */
+void TelemetryOverlay::timerCallback() {
+    const auto footprint = processor.getMemoryFootprint();
+    lines.clearQuick();
+    lines.add("memory " + formatBytes(footprint.totalCurrent) + " (peak " +
+              formatBytes(footprint.totalPeak) + ")");
+    for (size_t i = 0; i < MemoryTracker::numSubsystems; ++i) {
+        const auto subsystem = static_cast<MemoryTracker::Subsystem>(i);
+        lines.add(juce::String("  ") + MemoryTracker::getName(subsystem) +
+                  " " + formatBytes(footprint.current[i]) + " (peak " +
+                  formatBytes(footprint.peak[i]) + ")");
+    }
+    for (size_t i = 0; i < MemoryTracker::numQueues; ++i) {
+        const auto queue = static_cast<MemoryTracker::Queue>(i);
+        lines.add(juce::String("  ") + MemoryTracker::getName(queue) +
+                  " queue high-water " +
+                  formatBytes(footprint.queueHighWater[i]));
+    }
+    lines.add("non-finite input " +
+              juce::String(processor.getNonFiniteInputSamples()) +
+              " samples / " + juce::String(processor.getNonFiniteInputBlocks()) +
+              " blocks, frames dropped " +
+              juce::String(processor.getNonFiniteAnalysisFrames()));
+    if (const uint64_t failedCaptures =
+                processor.getNumFailedAnalysisCaptures();
+        failedCaptures > 0)
+        lines.add("analysis captures failed " + juce::String(failedCaptures));
+    lines.add("shared tables " + juce::String(SharedTables::getNumTables()) +
+              " (" + formatBytes(SharedTables::getMemoryBytes()) +
+              ", process-wide)");
+    lines.add(juce::String("kernels ") +
+              Kernels::getName(Kernels::getActiveIsa()) +
+              (Kernels::isForceRejected() ? " (GRAPHVERB_FORCE_ISA ignored)"
+                                          : "") +
+              (KernelAutotuner::getNumFailedSaves() > 0
+                       ? ", tuning not cached"
+                       : ""));
+    repaint();
+}
+
+/**
+ * @brief Format a byte count for display.
+ * @param bytes The byte count.
+ * @return The formatted string, e.g. "1.3 MB".
+ */
+juce::String TelemetryOverlay::formatBytes(const size_t bytes) {
+    const auto value = static_cast<double>(bytes);
+    if (value >= 1024.0 * 1024.0)
+        return juce::String(value / (1024.0 * 1024.0), 2) + " MB";
+    if (value >= 1024.0)
+        return juce::String(value / 1024.0, 1) + " KB";
+    return juce::String(static_cast<juce::int64>(bytes)) + " B";
+}
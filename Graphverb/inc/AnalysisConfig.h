@@ -0,0 +1,48 @@
+#ifndef ANALYSIS_CONFIG_H
+#define ANALYSIS_CONFIG_H
+
+/**
+ * @brief Settings of the analysis pipeline.
+ *
+ * A published configuration is never modified: changing a setting publishes a
+ * new object, which the analysis thread picks up between frames.
+ */
+struct AnalysisConfig {
+    /** FFT order of the spectral analyzer */
+    int fftOrder = 10;
+
+    /** Hop size of the spectral analyzer, in samples */
+    int hopSize = 512;
+
+    /** Number of clusters to form */
+    int numClusters = 12;
+
+    /** Largest number of k-means iterations per frame */
+    int maxIterations = 100;
+
+    /** Split each frame into harmonic and percussive components and cluster
+     * them separately, into the first and second half of the clusters */
+    bool separateHarmonicPercussive = false;
+
+    /** Re-cluster fully only on this many grid lines per beat of the host
+     * tempo, keeping the centroids and only reassigning the bins in between;
+     * 0 re-clusters every frame, as does a stopped or tempo-less host */
+    int beatSubdivisions = 0;
+
+    /** Largest FFT order Graphverb::setAnalysisConfig() allows */
+    static constexpr int maxFftOrder = 14;
+
+    /**
+     * @brief Get the FFT size.
+     * @return The FFT size in samples.
+     */
+    [[nodiscard]] int getFftSize() const { return 1 << fftOrder; }
+
+    /**
+     * @brief Compare two configurations.
+     * @return True if every setting is equal.
+     */
+    bool operator==(const AnalysisConfig &) const = default;
+};
+
+#endif // ANALYSIS_CONFIG_H
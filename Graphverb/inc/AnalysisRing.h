@@ -0,0 +1,185 @@
+#ifndef ANALYSIS_RING_H
+#define ANALYSIS_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Lock-free single-producer, single-consumer ring of samples feeding
+ * the analysis thread.
+ *
+ * The audio thread writes and the analysis thread reads; neither ever locks or
+ * allocates. The storage is allocated once, off the audio thread, and a block
+ * that does not fit is dropped whole, as the analysis tolerates gaps far better
+ * than the audio thread tolerates waiting. Multichannel input is downmixed as
+ * it is written, straight from the caller's channels into the ring.
+ */
+class AnalysisRing {
+public:
+    /**
+     * @brief Allocate the storage. Must not be called while the ring is in use.
+     * @param capacity The capacity in samples, rounded up to a power of two.
+     */
+    void allocate(const int capacity) {
+        size_t size = 1;
+        while (size < static_cast<size_t>(capacity))
+            size <<= 1;
+        buffer.assign(size, 0.0f);
+        mask = size - 1;
+        writePosition.store(0);
+        readPosition.store(0);
+    }
+
+    /**
+     * @brief Check if the storage has been allocated.
+     * @return True if allocate() has been called.
+     */
+    [[nodiscard]] bool isAllocated() const { return !buffer.empty(); }
+
+    /**
+     * @brief Write the average of some channels. Producer only.
+     *
+     * A single channel is copied as it is, without any downmix arithmetic.
+     *
+     * @param channels Pointers to the channels.
+     * @param numChannels Number of channels.
+     * @param startSample The first sample to read from each channel.
+     * @param numSamples Number of samples.
+     * @return True if the block was written, false if it was dropped.
+     */
+    bool write(const float *const *channels, const int numChannels,
+               const int startSample, const int numSamples) {
+        const uint64_t write = writePosition.load(std::memory_order_relaxed);
+        const uint64_t read = readPosition.load(std::memory_order_acquire);
+        const auto count = static_cast<uint64_t>(numSamples);
+        if (numChannels <= 0 || write - read + count > buffer.size())
+            return false;
+        const size_t start = write & mask;
+        const size_t first = std::min<size_t>(count, buffer.size() - start);
+        /// At most two contiguous runs: up to the end, then from the start
+        downmix(channels, numChannels, static_cast<size_t>(startSample),
+                buffer.data() + start, first);
+        downmix(channels, numChannels, static_cast<size_t>(startSample) + first,
+                buffer.data(), count - first);
+        writePosition.store(write + count, std::memory_order_release);
+        const size_t bytes = (write - read + count) * sizeof(float);
+        if (bytes > highWaterBytes.load(std::memory_order_relaxed))
+            highWaterBytes.store(bytes, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Read up to a number of samples. Consumer only.
+     * @param destination Pointer to where the samples are copied.
+     * @param maxSamples The largest number of samples to read.
+     * @return The number of samples read.
+     */
+    int read(float *destination, const int maxSamples) {
+        const uint64_t read = readPosition.load(std::memory_order_relaxed);
+        const uint64_t write = writePosition.load(std::memory_order_acquire);
+        const auto count =
+                std::min<uint64_t>(write - read,
+                                   static_cast<uint64_t>(maxSamples));
+        const size_t start = read & mask;
+        const size_t first = std::min<size_t>(count, buffer.size() - start);
+        std::copy_n(buffer.data() + start, first, destination);
+        std::copy_n(buffer.data(), count - first, destination + first);
+        readPosition.store(read + count, std::memory_order_release);
+        return static_cast<int>(count);
+    }
+
+    /**
+     * @brief Drop everything written so far. Consumer only, or while no
+     * consumer is running.
+     */
+    void discard() {
+        readPosition.store(writePosition.load(std::memory_order_acquire),
+                           std::memory_order_release);
+    }
+
+    /**
+     * @brief Get the total number of samples written. Producer only.
+     * @return The write position.
+     */
+    [[nodiscard]] uint64_t getWritePosition() const {
+        return writePosition.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the total number of samples read. Consumer only.
+     * @return The read position.
+     */
+    [[nodiscard]] uint64_t getReadPosition() const {
+        return readPosition.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of bytes waiting to be read.
+     * @return The queued bytes.
+     */
+    [[nodiscard]] size_t getQueuedBytes() const {
+        return static_cast<size_t>(writePosition.load() -
+                                   readPosition.load()) *
+               sizeof(float);
+    }
+
+    /**
+     * @brief Get the largest number of bytes the ring has held.
+     * @return The high-water mark in bytes.
+     */
+    [[nodiscard]] size_t getHighWaterBytes() const {
+        return highWaterBytes.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of bytes allocated for the storage.
+     * @return The allocated bytes.
+     */
+    [[nodiscard]] size_t getCapacityBytes() const {
+        return buffer.size() * sizeof(float);
+    }
+
+private:
+    /** Sample storage, a power of two long */
+    std::vector<float> buffer;
+
+    /** Mask wrapping a position into the storage */
+    size_t mask = 0;
+
+    /** Total number of samples written, advanced by the producer */
+    alignas(64) std::atomic<uint64_t> writePosition{0};
+
+    /** Total number of samples read, advanced by the consumer */
+    alignas(64) std::atomic<uint64_t> readPosition{0};
+
+    /** Largest number of bytes the ring has held */
+    alignas(64) std::atomic<size_t> highWaterBytes{0};
+
+    /**
+     * @brief Average some channels into a contiguous run of the ring.
+     * @param channels Pointers to the channels.
+     * @param numChannels Number of channels, at least one.
+     * @param offset The first sample to read from each channel.
+     * @param destination Where to write the run.
+     * @param count Number of samples.
+     */
+    static void downmix(const float *const *channels, const int numChannels,
+                        const size_t offset, float *destination,
+                        const size_t count) {
+        std::copy_n(channels[0] + offset, count, destination);
+        if (numChannels == 1)
+            return;
+        for (int ch = 1; ch < numChannels; ++ch) {
+            const float *source = channels[ch] + offset;
+            for (size_t i = 0; i < count; ++i)
+                destination[i] += source[i];
+        }
+        const float scale = 1.0f / static_cast<float>(numChannels);
+        for (size_t i = 0; i < count; ++i)
+            destination[i] *= scale;
+    }
+};
+
+#endif // ANALYSIS_RING_H
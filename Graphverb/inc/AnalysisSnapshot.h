@@ -0,0 +1,97 @@
+#ifndef ANALYSIS_SNAPSHOT_H
+#define ANALYSIS_SNAPSHOT_H
+
+#include <cmath>
+#include <cstdint>
+#include <juce_core/juce_core.h>
+#include <optional>
+#include <vector>
+#include "Centroid.h"
+
+/**
+ * @brief Compact copy of the converged analysis state, saved with the plugin
+ * state so a reopened session starts from converged clusters.
+ */
+struct AnalysisSnapshot {
+    /** Centroid of each cluster, in Hz and linear magnitude */
+    std::vector<Centroid> centroids;
+
+    /** Normalised energy of each cluster */
+    std::vector<float> energies;
+
+    /** Cluster of each frequency bin */
+    std::vector<uint8_t> assignments;
+
+    /**
+     * @brief Serialise the snapshot.
+     *
+     * Layout, little-endian: magic "GVAS", int32 version, int32 cluster count,
+     * the centroids as float pairs, the energies as floats, int32 bin count,
+     * then one byte per bin.
+     *
+     * @return The binary snapshot.
+     */
+    [[nodiscard]] juce::MemoryBlock toBinary() const {
+        juce::MemoryOutputStream stream;
+        stream.writeInt(magic);
+        stream.writeInt(version);
+        stream.writeInt(static_cast<int>(centroids.size()));
+        for (const auto &[frequency, magnitude]: centroids) {
+            stream.writeFloat(frequency);
+            stream.writeFloat(magnitude);
+        }
+        for (size_t i = 0; i < centroids.size(); ++i)
+            stream.writeFloat(i < energies.size() ? energies[i] : 0.0f);
+        stream.writeInt(static_cast<int>(assignments.size()));
+        stream.write(assignments.data(), assignments.size());
+        return stream.getMemoryBlock();
+    }
+
+    /**
+     * @brief Parse a snapshot written by toBinary().
+     * @param data Pointer to the binary snapshot.
+     * @param size Size of the binary snapshot in bytes.
+     * @return The snapshot, or nothing if the data is truncated, from another
+     * version or contains non-finite values.
+     */
+    static std::optional<AnalysisSnapshot> fromBinary(const void *data,
+                                                      const size_t size) {
+        juce::MemoryInputStream stream(data, size, false);
+        if (stream.readInt() != magic || stream.readInt() != version)
+            return std::nullopt;
+        const int numClusters = stream.readInt();
+        if (numClusters <= 0 || numClusters > 255 ||
+            stream.getNumBytesRemaining() < numClusters * 12 + 4)
+            return std::nullopt;
+        AnalysisSnapshot snapshot;
+        snapshot.centroids.resize(static_cast<size_t>(numClusters));
+        for (auto &[frequency, magnitude]: snapshot.centroids) {
+            frequency = stream.readFloat();
+            magnitude = stream.readFloat();
+            if (!std::isfinite(frequency) || !std::isfinite(magnitude))
+                return std::nullopt;
+        }
+        snapshot.energies.resize(static_cast<size_t>(numClusters));
+        for (float &energy: snapshot.energies)
+            if (energy = stream.readFloat(); !std::isfinite(energy))
+                return std::nullopt;
+        const int numBins = stream.readInt();
+        if (numBins < 0 || stream.getNumBytesRemaining() < numBins)
+            return std::nullopt;
+        snapshot.assignments.resize(static_cast<size_t>(numBins));
+        stream.read(snapshot.assignments.data(), numBins);
+        for (const uint8_t cluster: snapshot.assignments)
+            if (cluster >= numClusters)
+                return std::nullopt;
+        return snapshot;
+    }
+
+private:
+    /** "GVAS" */
+    static constexpr int magic = 0x53415647;
+
+    /** Layout version; bump when the layout changes */
+    static constexpr int version = 1;
+};
+
+#endif // ANALYSIS_SNAPSHOT_H
@@ -0,0 +1,626 @@
+#ifndef ANALYSIS_WORKER_H
+#define ANALYSIS_WORKER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "AnalysisCaptureWriter.h"
+#include "AnalysisConfig.h"
+#include "AnalysisRing.h"
+#include "AnalysisSnapshot.h"
+#include "FlightRecorder.h"
+#include "HarmonicPercussiveSeparator.h"
+#include "ImpulseCapture.h"
+#include "KernelAutotuner.h"
+#include "SpectralAnalyzer.h"
+#include "SpectralGraph.h"
+
+/**
+ * @brief Background worker that runs the spectral analysis, graph building and
+ * clustering pipeline and publishes the resulting cluster energies.
+ *
+ * The worker owns its thread for its whole lifetime: start() and stop() may be
+ * called any number of times and in any order, and the destructor always
+ * joins the thread. This makes repeated prepareToPlay/releaseResources calls
+ * from the host safe. Starting a worker that is already running only changes
+ * its sample rate, so a host reconfiguration neither respawns the thread nor
+ * throws away the analysis state.
+ *
+ * The analysis settings live in an immutable AnalysisConfig published by
+ * pointer swap, read-copy-update style. The analysing thread picks up the
+ * latest one between frames and marks the one it reads, and a replaced
+ * configuration is only freed once the thread has moved past it, so settings
+ * change live without locking or restarting anything.
+ */
+class AnalysisWorker {
+public:
+    /**
+     * @brief Constructor for the AnalysisWorker.
+     * @param config The initial analysis settings.
+     */
+    explicit AnalysisWorker(const AnalysisConfig &config);
+
+    /**
+     * @brief Destructor for the AnalysisWorker. Stops the thread if running.
+     */
+    ~AnalysisWorker();
+
+    /**
+     * @brief Start the analysis thread, or change its sample rate if it is
+     * already running.
+     * @param sampleRate The sample rate of the incoming audio.
+     */
+    void start(double sampleRate);
+
+    /**
+     * @brief Stop the analysis thread and drop any pending input.
+     */
+    void stop();
+
+    /**
+     * @brief Check if the analysis thread is running.
+     * @return True if the thread is running, false otherwise.
+     */
+    [[nodiscard]] bool isRunning() const { return running.load(); }
+
+    /**
+     * @brief Push a block for analysis, downmixing its channels to mono on
+     * the way into the queue. Lock-free and allocation-free, for the audio
+     * thread.
+     * @param channels Pointers to the channels.
+     * @param numChannels Number of channels.
+     * @param startSample The first sample to read from each channel.
+     * @param numSamples Number of samples.
+     * @return True if the block was queued, false if it was dropped.
+     */
+    bool push(const float *const *channels, int numChannels, int startSample,
+              int numSamples);
+
+    /**
+     * @brief Analyse only one frame in every few hops, e.g. while the plugin
+     * is bypassed, or every frame again. Lock-free, for the audio thread.
+     *
+     * At a reduced rate the worker gathers the hops in between and analyses
+     * only the newest full frame of them, so the energies keep tracking the
+     * input at a fraction of the cost.
+     *
+     * @param factor Number of hops per analysed frame; 1 analyses every hop.
+     */
+    void setFrameDecimation(const int factor) {
+        frameDecimation.store(factor, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Record every analysed frame in a flight recorder, and write its
+     * requested dumps between frames. Must be called before start().
+     * @param recorder The recorder, or null.
+     */
+    void setFlightRecorder(FlightRecorder *recorder) {
+        flightRecorder = recorder;
+    }
+
+    /**
+     * @brief Render an impulse capture's requests between frames, a slice at
+     * a time. Must be called before start().
+     * @param capture The capture, or null.
+     */
+    void setImpulseCapture(ImpulseCapture *capture) {
+        impulseCapture = capture;
+    }
+
+    /**
+     * @brief Pick this instance's kernels for a configuration: the cached
+     * choice if there is one, otherwise the current kernels until the
+     * analysis thread has tuned it. Reads the cache file, so not for the
+     * audio thread.
+     * @param config The configuration.
+     */
+    void prepareKernels(const KernelAutotuner::Config &config);
+
+    /**
+     * @brief Get this instance's kernels. Lock-free, for the audio thread.
+     * @return The kernel table.
+     */
+    [[nodiscard]] const Kernels::Table &getKernels() const {
+        return *kernels.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Get the grid lines per beat of the latest configuration.
+     * Lock-free, for the audio thread.
+     * @return The subdivisions, or 0 if re-clustering every frame.
+     */
+    [[nodiscard]] int getBeatSubdivisions() const {
+        return beatSubdivisions.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Re-cluster only on the marked grid lines, or every frame.
+     * Lock-free, for the audio thread.
+     * @param synced Whether a running transport with a tempo marks the grid.
+     */
+    void setGridSynced(const bool synced) {
+        gridSynced.store(synced, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Mark a grid line in the next block to be pushed; the first frame
+     * reaching it is re-clustered fully. Lock-free, for the audio thread.
+     *
+     * Lines must be marked in order. Up to maxPendingGridLines lines wait for
+     * the analysis; while that many are pending, further lines are dropped,
+     * so an analysis that falls behind skips lines rather than piling them
+     * up. Lines one frame passes in one go re-cluster it once.
+     *
+     * @param offset Offset of the line from the start of the block.
+     * @return False if the line was dropped.
+     */
+    bool markGridLine(const int offset) {
+        const uint64_t marked = gridLinesMarked.load(std::memory_order_relaxed);
+        if (marked - gridLinesReached.load(std::memory_order_acquire) >=
+            maxPendingGridLines)
+            return false;
+        gridLines[marked % maxPendingGridLines].store(
+                inputRing.getWritePosition() + static_cast<uint64_t>(offset),
+                std::memory_order_relaxed);
+        gridLinesMarked.store(marked + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Run one analysis step synchronously on the caller's thread.
+     *
+     * This is what the worker thread does for every queued block. It is public
+     * so benchmarks and offline tools can drive the pipeline directly; it must
+     * not be called while the worker thread is running.
+     *
+     * @param samples Pointer to the mono samples.
+     * @param numSamples Number of samples.
+     * @param sampleRate The sample rate of the samples.
+     */
+    void analyseBlock(const float *samples, int numSamples, double sampleRate);
+
+    /**
+     * @brief Get the number of analysis frames dropped because their
+     * magnitudes were not finite.
+     * @return The number of dropped frames.
+     */
+    [[nodiscard]] uint64_t getNonFiniteFrames() const {
+        return nonFiniteFrames.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of bytes held by the analysis state, as of the
+     * last analysed frame.
+     * @return The number of bytes.
+     */
+    [[nodiscard]] size_t getMemoryBytes() const {
+        return memoryBytes.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of bytes waiting in the input queue.
+     * @return The queued bytes.
+     */
+    [[nodiscard]] size_t getQueuedBytes() const {
+        return inputRing.getQueuedBytes();
+    }
+
+    /**
+     * @brief Get the number of bytes allocated for the input queue.
+     * @return The allocated bytes.
+     */
+    [[nodiscard]] size_t getQueueCapacityBytes() const {
+        return inputRing.getCapacityBytes();
+    }
+
+    /**
+     * @brief Get the largest number of bytes the input queue has held.
+     * @return The high-water mark in bytes.
+     */
+    [[nodiscard]] size_t getQueueHighWaterBytes() const {
+        return inputRing.getHighWaterBytes();
+    }
+
+    /**
+     * @brief Copy the latest published cluster energies. Lock-free, and never
+     * allocates if out has room for the clusters.
+     * @param out The vector to store the energies in.
+     * @param publication If not null, receives the number of the publication
+     * the energies were copied from.
+     * @return True if energies have been published and copied whole, false
+     * otherwise, leaving out untouched.
+     */
+    bool fetchEnergies(std::vector<float> &out,
+                       uint64_t *publication = nullptr) const;
+
+    /**
+     * @brief Copy the cluster of each frequency bin from the latest
+     * publication. Lock-free, and never allocates if out has room for the
+     * bins.
+     * @param out The vector to store the assignments in.
+     * @return True if assignments have been published and copied whole,
+     * false otherwise.
+     */
+    bool fetchAssignments(std::vector<uint8_t> &out) const;
+
+    /**
+     * @brief Get a copy of the latest published cluster energies.
+     * @return The latest cluster energies, or an empty vector.
+     */
+    [[nodiscard]] std::vector<float> getEnergies();
+
+    /**
+     * @brief Take a snapshot of the latest published analysis state.
+     * @return The snapshot; empty if no frame has been analysed or restored.
+     */
+    [[nodiscard]] AnalysisSnapshot getSnapshot();
+
+    /**
+     * @brief Restore the analysis state from a snapshot.
+     *
+     * The energies are published straight away and the clustering starts from
+     * the snapshot's centroids on the next frame. A snapshot with a different
+     * number of clusters is ignored. Safe to call while the worker runs.
+     *
+     * @param snapshot The snapshot to restore.
+     * @return True if the snapshot was restored.
+     */
+    bool restoreSnapshot(const AnalysisSnapshot &snapshot);
+
+    /**
+     * @brief Publish new analysis settings. Safe to call while the worker
+     * runs; the analysing thread switches between frames.
+     *
+     * A change of FFT order or hop size rebuilds the spectral analyzer, and a
+     * change of cluster count restarts the clustering cold.
+     *
+     * @param config The new analysis settings.
+     */
+    void setConfig(const AnalysisConfig &config);
+
+    /**
+     * @brief Get the latest published analysis settings.
+     * @return A copy of the settings.
+     */
+    [[nodiscard]] AnalysisConfig getConfig();
+
+    /**
+     * @brief Start capturing every analysed frame to a file, replacing any
+     * capture in progress.
+     *
+     * The file is sized here for the current FFT size, hop size, sample rate
+     * and cluster count; appending frames on the analysis thread never
+     * allocates or blocks.
+     *
+     * @param file The capture file, replaced if it exists.
+     * @param seconds Length of audio the file has room for.
+     * @return True if the capture started.
+     */
+    bool startCapture(const juce::File &file, double seconds);
+
+    /**
+     * @brief Ask the analysis thread to start a capture between frames, as
+     * startCapture() would, so the caller never waits for the file.
+     * @param file The capture file, replaced if it exists.
+     * @param seconds Length of audio the file has room for.
+     */
+    void requestCapture(const juce::File &file, double seconds);
+
+    /**
+     * @brief Stop capturing and close the capture file, or drop a requested
+     * capture.
+     */
+    void stopCapture();
+
+    /**
+     * @brief Get the number of captures asked for with requestCapture() that
+     * could not be started, e.g. because the file could not be created.
+     * @return The number of failed captures.
+     */
+    [[nodiscard]] uint64_t getNumFailedCaptures() const {
+        return failedCaptures.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Check if frames are being captured.
+     * @return True if a capture is in progress or requested.
+     */
+    [[nodiscard]] bool isCapturing() const {
+        return capture.load() != nullptr || captureRequested.load();
+    }
+
+    /**
+     * @brief Get the number of clusters formed by the worker.
+     * @return The number of clusters.
+     */
+    [[nodiscard]] int getNumClusters() { return getConfig().numClusters; }
+
+    /**
+     * @brief Get the FFT size used by the spectral analyzer.
+     * @return The FFT size in samples.
+     */
+    [[nodiscard]] int getFftSize() { return getConfig().getFftSize(); }
+
+private:
+    /** Capacity of the input ring in samples, about 0.7 s at 48 kHz */
+    static constexpr int inputRingCapacity = 1 << 15;
+
+    /** Every configuration that may still be read, guarded by configMutex */
+    std::vector<std::unique_ptr<const AnalysisConfig>> configs;
+
+    /** Mutex serialising publication and reclamation of configurations */
+    std::mutex configMutex;
+
+    /** The latest configuration, published by setConfig() */
+    std::atomic<const AnalysisConfig *> publishedConfig{nullptr};
+
+    /** The configuration the analysing thread reads; never freed while set */
+    std::atomic<const AnalysisConfig *> configInUse{nullptr};
+
+    /** The configuration being analysed with; analysing thread only */
+    const AnalysisConfig *activeConfig = nullptr;
+
+    /** Owner of the capture in progress, guarded by captureMutex */
+    std::unique_ptr<AnalysisCaptureWriter> captureWriter;
+
+    /** Mutex serialising the start and stop of captures */
+    std::mutex captureMutex;
+
+    /** The capture frames are appended to, or null */
+    std::atomic<AnalysisCaptureWriter *> capture{nullptr};
+
+    /** The capture being appended to right now; never closed while set */
+    std::atomic<AnalysisCaptureWriter *> captureInUse{nullptr};
+
+    /** Set by requestCapture() until the analysis thread starts it */
+    std::atomic<bool> captureRequested{false};
+
+    /** File of the requested capture, guarded by captureMutex */
+    juce::File requestedCaptureFile;
+
+    /** Length of the requested capture in seconds, guarded by captureMutex */
+    double requestedCaptureSeconds = 0.0;
+
+    /** Number of requested captures that could not be started */
+    std::atomic<uint64_t> failedCaptures{0};
+
+    /** Flight recorder the frames are recorded in, or null */
+    FlightRecorder *flightRecorder = nullptr;
+
+    /** Capture rendered between frames, or null */
+    ImpulseCapture *impulseCapture = nullptr;
+
+    /** This instance's kernels, never freed */
+    std::atomic<const Kernels::Table *> kernels{&Kernels::get()};
+
+    /** Whether pendingKernelConfig waits to be tuned, checked without the
+     * mutex */
+    std::atomic<bool> kernelsPending{false};
+
+    /** Mutex guarding pendingKernelConfig */
+    std::mutex kernelMutex;
+
+    /** Configuration whose kernels are being tuned */
+    KernelAutotuner::Config pendingKernelConfig;
+
+    /**
+     * @brief Switch to the pending configuration's kernels once they have
+     * been tuned.
+     */
+    void adoptTunedKernels();
+
+    /** Samples analysed since the thread started; analysing thread only */
+    uint64_t samplesAnalysed = 0;
+
+    /** Time spent in each stage of the latest frame, in microseconds */
+    float stageMicroseconds[AnalysisCapture::numStages]{};
+
+    /** Spectral analyzer for performing the STFT, built on first use */
+    std::unique_ptr<SpectralAnalyzer> spectralAnalyzer;
+
+    /** Spectral graph for storing the graph structure */
+    SpectralGraph spectralGraph;
+
+    /** Harmonic/percussive separator, built while the configuration asks
+     * for it */
+    std::unique_ptr<HarmonicPercussiveSeparator> separator;
+
+    /** Lock-free ring passing audio from the audio thread, allocated on the
+     * first start() */
+    AnalysisRing inputRing;
+
+    /** Sample rate of the incoming audio, changed by start() while running */
+    std::atomic<double> currentSampleRate{0.0};
+
+    /** Thread for performing spectral analysis */
+    std::thread thread;
+
+    /** Most grid lines waiting for the analysis to reach them */
+    static constexpr uint64_t maxPendingGridLines = 16;
+
+    /** Grid lines per beat of the latest configuration */
+    std::atomic<int> beatSubdivisions{0};
+
+    /** Whether re-clustering follows the grid lines, set by the audio thread */
+    std::atomic<bool> gridSynced{false};
+
+    /** Input positions of the pending grid lines, indexed by line number */
+    std::array<std::atomic<uint64_t>, maxPendingGridLines> gridLines{};
+
+    /** Number of grid lines marked, written by the audio thread */
+    std::atomic<uint64_t> gridLinesMarked{0};
+
+    /** Number of grid lines the analysis reached, written by the worker */
+    std::atomic<uint64_t> gridLinesReached{0};
+
+    /** Number of hops per analysed frame, set by setFrameDecimation() */
+    std::atomic<int> frameDecimation{1};
+
+    /** Flag to indicate if the analysis thread should exit */
+    std::atomic<bool> threadShouldExit{false};
+
+    /** Flag to indicate if the analysis thread is running */
+    std::atomic<bool> running{false};
+
+    /** Number of times the state was published; written under energyMutex */
+    std::atomic<uint64_t> publications{0};
+
+    /** Most clusters a publication holds, one per value of an assignment */
+    static constexpr size_t maxPublishedClusters = 256;
+
+    /** Largest number of bins an assignment publication holds */
+    static constexpr size_t maxAssignmentBins =
+            size_t{1} << (AnalysisConfig::maxFftOrder - 1);
+
+    /**
+     * @brief One buffer of a published frame's energies and assignments: a
+     * seqlock over atomic values, the assignments eight bins to a word.
+     */
+    struct PublicationSlot {
+        /** Odd while being written */
+        std::atomic<uint64_t> sequence{0};
+        /** Number of the publication held */
+        std::atomic<uint64_t> publication{0};
+        /** Number of clusters held */
+        std::atomic<uint32_t> numClusters{0};
+        /** The clusters' energies */
+        std::array<std::atomic<float>, maxPublishedClusters> energies{};
+        /** Number of bins held */
+        std::atomic<uint32_t> numBins{0};
+        /** The bins' clusters, packed */
+        std::array<std::atomic<uint64_t>, maxAssignmentBins / 8> words{};
+    };
+
+    /** Published energies and assignments, double-buffered by the parity of
+     * publications so the audio thread can copy them without locking */
+    std::array<PublicationSlot, 2> publicationSlots;
+
+    /** Serialises the publications and guards publishedState */
+    std::mutex energyMutex;
+
+    /** Centroids the clustering starts from, owned by the analysing thread */
+    std::vector<Centroid> centroids;
+
+    /** Latest published state, guarded by energyMutex */
+    AnalysisSnapshot publishedState;
+
+    /** State of the next publication, built by the analysing thread outside
+     * the lock and swapped with publishedState */
+    AnalysisSnapshot nextState;
+
+    /**
+     * @brief Publish publishedState's energies and assignments with the next
+     * publication number. energyMutex must be held.
+     */
+    void publishLocked();
+
+    /** Set when publishedState holds restored centroids to start from */
+    std::atomic<bool> restorePending{false};
+
+    /** Number of frames dropped because of non-finite magnitudes */
+    std::atomic<uint64_t> nonFiniteFrames{0};
+
+    /** Bytes held by the analysis state, updated after every frame */
+    std::atomic<size_t> memoryBytes{0};
+
+    /** Mutex serialising start() and stop() */
+    std::mutex lifecycleMutex;
+
+    /**
+     * @brief Main loop of the analysis thread.
+     */
+    void run();
+
+    /**
+     * @brief Run the graph and clustering stages on the latest magnitudes.
+     * @param sampleRate The sample rate of the incoming audio.
+     */
+    void analyseLatestFrame(double sampleRate);
+
+    /**
+     * @brief Check if the frame being analysed should be re-clustered fully,
+     * consuming the grid lines it reached.
+     * @return False if the frame should only reassign the bins.
+     */
+    bool isReclusterDue();
+
+    /**
+     * @brief Build the graph of a spectrum and cluster it into a range of the
+     * clusters, starting from the previous frame's centroids for that range.
+     * @param magnitudes The spectrum, one magnitude per bin.
+     * @param sampleRate The sample rate of the incoming audio.
+     * @param firstCluster The first cluster of the range.
+     * @param count Number of clusters in the range.
+     * @param energySums Receives the sum of the magnitudes in each cluster.
+     * @param counts Receives the number of bins in each cluster.
+     * @param nextCentroids Receives the range's centroids, appended.
+     * @param iterations Receives the k-means iterations run, added.
+     * @param recluster False to keep the previous centroids and only
+     * reassign the bins to them.
+     * @return The cluster of each bin within the range, or empty if the
+     * range is empty.
+     */
+    std::vector<int> clusterSpectrum(const std::vector<float> &magnitudes,
+                                     double sampleRate, int firstCluster,
+                                     int count, std::vector<float> &energySums,
+                                     std::vector<int> &counts,
+                                     std::vector<Centroid> &nextCentroids,
+                                     int &iterations, bool recluster);
+
+    /**
+     * @brief Append a frame to the capture in progress, if any.
+     * @param frame The frame.
+     */
+    void captureFrame(const AnalysisCaptureWriter::Frame &frame);
+
+    /**
+     * @brief Stop capturing. The capture mutex must be held.
+     */
+    void stopCaptureLocked();
+
+    /**
+     * @brief Start a capture. The capture mutex must be held.
+     * @param file The capture file, replaced if it exists.
+     * @param seconds Length of audio the file has room for.
+     * @return True if the capture started.
+     */
+    bool startCaptureLocked(const juce::File &file, double seconds);
+
+    /**
+     * @brief Start the capture asked for with requestCapture(), if any.
+     * Analysis thread only.
+     */
+    void startRequestedCapture();
+
+    /**
+     * @brief Switch to the latest published configuration, if it changed.
+     * Only called by whichever thread is analysing.
+     */
+    void acquireConfig();
+
+    /**
+     * @brief Build the spectral analyzer if it has not been built yet.
+     *
+     * Construction only records the settings, so hosts scanning or loading
+     * many instances do not pay for the analyzer until it is used.
+     */
+    void ensureAnalyzer();
+
+    /**
+     * @brief Recompute the bytes held by the analysis state.
+     */
+    void updateMemoryBytes();
+
+    /**
+     * @brief Stop the analysis thread. The lifecycle mutex must be held.
+     */
+    void stopLocked();
+};
+
+#endif // ANALYSIS_WORKER_H
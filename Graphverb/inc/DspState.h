@@ -0,0 +1,198 @@
+#ifndef DSP_STATE_H
+#define DSP_STATE_H
+
+#include <cstdint>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <memory>
+#include <vector>
+
+#include "AnalysisConfig.h"
+#include "CommunityReverb.h"
+#include "ImpulseCapture.h"
+#include "ModalReverb.h"
+
+/**
+ * @brief Everything the audio thread needs for one sample rate, channel count
+ * and block size capacity: the community reverbs and every buffer processBlock
+ * uses.
+ *
+ * A state is built and prepared entirely off the audio thread, then handed
+ * over by swapping a pointer, so a host reconfiguration never allocates or
+ * blocks on the audio thread. Once built, a state is only touched by the audio
+ * thread.
+ */
+struct DspState {
+    /** Sample rate the reverbs are prepared for */
+    double sampleRate;
+
+    /** Number of channels the buffers hold */
+    int numChannels;
+
+    /** Largest number of samples processed in one go */
+    int blockCapacity;
+
+    /** Community reverb instances for each cluster */
+    std::vector<std::unique_ptr<CommunityReverb>> reverbs;
+
+    /** Copy of the sanitised input */
+    juce::AudioBuffer<float> dryBuffer;
+
+    /** Sum of the weighted reverb outputs */
+    juce::AudioBuffer<float> wetBuffer;
+
+    /** Output of each reverb, so the reverbs can run in parallel */
+    std::vector<juce::AudioBuffer<float>> voiceBuffers;
+
+    /** Latest cluster energies, reserved so fetching them never allocates */
+    std::vector<float> clusterEnergies;
+
+    /** Modal bank standing in for the community reverbs when selected */
+    ModalReverb modalReverb;
+
+    /** Output of the modal bank, so it can crossfade with the reverbs */
+    juce::AudioBuffer<float> modalBuffer;
+
+    /** Latest cluster of each bin, reserved for the largest FFT so fetching
+     * them never allocates */
+    std::vector<uint8_t> clusterAssignments;
+
+    /** Whether the modal bank rendered the last chunk; audio thread only */
+    bool modalActive = false;
+
+    /**
+     * @brief What stands in for the reverbs while their weights hold still.
+     */
+    enum class StaticMode {
+        /** The reverbs alone */
+        live,
+        /** The reverbs, while their impulse response is rendered */
+        capturing,
+        /** The reverbs, with the convolution running alongside to fill up */
+        warming,
+        /** Crossfading from the reverbs to the convolution */
+        crossfading,
+        /** The convolution alone */
+        convolving,
+        /** The reverbs, restarted, over the convolution's ringing tail */
+        ringingOut
+    };
+
+    /** Convolution with the captured impulse response of the reverbs;
+     * prepared for mono and stereo states only */
+    juce::dsp::Convolution convolution;
+
+    /** Input and output of the convolution */
+    juce::AudioBuffer<float> convolutionBuffer;
+
+    /** Current static mode; audio thread only */
+    StaticMode staticMode = StaticMode::live;
+
+    /** Samples left in the current static mode's transition */
+    int staticCountdown = 0;
+
+    /** The reverb bank when its weights last moved, captured once they
+     * have held still for long enough */
+    ImpulseCapture::Request steadyBank;
+
+    /** Samples the weights have held still for */
+    int steadySamples = 0;
+
+    /** Gain of the reverbs' direct path, applied beside the convolution */
+    float directGain = 0.0f;
+
+    /** Length of the impulse response loaded into the convolution */
+    int impulseLength = 0;
+
+    /**
+     * @brief Constructor for the DspState. Builds and prepares everything.
+     * @param sampleRateIn The sample rate.
+     * @param numChannelsIn The number of channels.
+     * @param blockCapacityIn The largest number of samples processed at once.
+     * @param numClusters The number of clusters, and therefore reverbs.
+     * @param modesPerChannel The number of modes of each channel of the
+     * modal bank.
+     * @param convolutionQueue Background queue loading impulse responses.
+     */
+    DspState(const double sampleRateIn, const int numChannelsIn,
+             const int blockCapacityIn, const int numClusters,
+             const int modesPerChannel,
+             juce::dsp::ConvolutionMessageQueue &convolutionQueue) :
+        sampleRate(sampleRateIn), numChannels(numChannelsIn),
+        blockCapacity(blockCapacityIn),
+        dryBuffer(numChannelsIn, blockCapacityIn),
+        wetBuffer(numChannelsIn, blockCapacityIn),
+        modalReverb(sampleRateIn, numChannelsIn, modesPerChannel, numClusters,
+                    blockCapacityIn, CommunityReverb::defaultDamping),
+        modalBuffer(numChannelsIn, blockCapacityIn),
+        convolution(juce::dsp::Convolution::NonUniform{convolutionHeadSize},
+                    convolutionQueue),
+        convolutionBuffer(numChannelsIn, blockCapacityIn) {
+        const juce::dsp::ProcessSpec spec{
+                sampleRate, static_cast<juce::uint32>(blockCapacity),
+                static_cast<juce::uint32>(numChannels)};
+        for (int i = 0; i < numClusters; ++i) {
+            reverbs.push_back(std::make_unique<CommunityReverb>());
+            reverbs.back()->reverb.prepare(spec);
+            voiceBuffers.emplace_back(numChannelsIn, blockCapacityIn);
+        }
+        clusterEnergies.reserve(static_cast<size_t>(numClusters));
+        clusterAssignments.reserve(
+                static_cast<size_t>(1 << (AnalysisConfig::maxFftOrder - 1)));
+        if (numChannels <= 2)
+            convolution.prepare(spec);
+    }
+
+    /**
+     * @brief Check if the reverbs can be replaced by the convolution.
+     * @return True for mono and stereo states.
+     */
+    [[nodiscard]] bool canConvolve() const { return numChannels <= 2; }
+
+    /**
+     * @brief Check if the state can serve a configuration as it is.
+     * @param sampleRateIn The sample rate.
+     * @param numChannelsIn The number of channels.
+     * @param blockSize The largest block size the host will send.
+     * @return True if nothing needs to be rebuilt.
+     */
+    [[nodiscard]] bool fits(const double sampleRateIn, const int numChannelsIn,
+                            const int blockSize) const {
+        return sampleRate == sampleRateIn && numChannels == numChannelsIn &&
+               blockCapacity >= blockSize;
+    }
+
+    /** Samples convolved directly, without latency, before the longer FFT
+     * partitions take over */
+    static constexpr int convolutionHeadSize = 512;
+
+    /**
+     * @brief Get the number of bytes held by the buffers.
+     * @return The number of bytes.
+     */
+    [[nodiscard]] size_t getBufferBytes() const {
+        return getBufferBytes(numChannels, blockCapacity,
+                              static_cast<int>(voiceBuffers.size()));
+    }
+
+    /**
+     * @brief Get the number of bytes the buffers of a state hold for a
+     * configuration.
+     * @param numChannelsIn The number of channels.
+     * @param blockCapacityIn The largest number of samples processed at once.
+     * @param numClusters The number of clusters, and therefore reverbs.
+     * @return The number of bytes.
+     */
+    static size_t getBufferBytes(const int numChannelsIn,
+                                 const int blockCapacityIn,
+                                 const int numClusters) {
+        /// Dry, wet, convolution and modal buffers, plus one per voice
+        const auto buffers = static_cast<size_t>(4 + numClusters);
+        return (buffers * static_cast<size_t>(numChannelsIn) *
+                        static_cast<size_t>(blockCapacityIn) +
+                static_cast<size_t>(numClusters)) *
+                       sizeof(float) +
+               (size_t{1} << (AnalysisConfig::maxFftOrder - 1));
+    }
+};
+
+#endif // DSP_STATE_H
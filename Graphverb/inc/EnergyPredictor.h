@@ -0,0 +1,141 @@
+#ifndef ENERGY_PREDICTOR_H
+#define ENERGY_PREDICTOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Extrapolates the cluster energies between analysis frames from their
+ * recent trend, so the reverbs follow the input without waiting a hop.
+ *
+ * Each cluster runs an alpha-beta filter (a steady-state Kalman filter with a
+ * level and a trend) over the frames as they arrive on the audio thread. The
+ * energies are extrapolated from the latest frame along the trend, at most a
+ * couple of frame intervals ahead, and the extrapolation is scaled by a
+ * confidence that falls as the trend stops predicting the frames. The result
+ * is clamped to [0, 1] and renormalised to the frame's total. Nothing is
+ * allocated after construction, so it runs on the audio thread.
+ */
+class EnergyPredictor {
+public:
+    /**
+     * @brief Constructor for the EnergyPredictor.
+     * @param maxClusters The largest number of clusters it will be fed.
+     */
+    explicit EnergyPredictor(const int maxClusters) {
+        const auto capacity = static_cast<size_t>(maxClusters);
+        latest.reserve(capacity);
+        level.reserve(capacity);
+        trend.reserve(capacity);
+        error.reserve(capacity);
+    }
+
+    /**
+     * @brief Forget every frame.
+     */
+    void reset() {
+        latest.clear();
+        frames = 0;
+    }
+
+    /**
+     * @brief Feed a new analysis frame.
+     * @param energies The frame's energies, at most maxClusters of them.
+     * @param position The sample position the frame arrived at.
+     */
+    void update(const std::vector<float> &energies, const uint64_t position) {
+        const size_t numClusters = std::min(energies.size(), latest.capacity());
+        if (numClusters != latest.size() || frames == 0) {
+            /// First frame, or the cluster count changed: start over
+            latest.assign(energies.begin(), energies.begin() + numClusters);
+            level.assign(latest.begin(), latest.end());
+            trend.assign(numClusters, 0.0f);
+            error.assign(numClusters, 0.0f);
+            lastPosition = position;
+            frames = 1;
+            return;
+        }
+        const auto dt = static_cast<float>(
+                std::max<uint64_t>(1, position - lastPosition));
+        interval = frames == 1 ? dt : interval + 0.1f * (dt - interval);
+        for (size_t i = 0; i < numClusters; ++i) {
+            const float predicted = level[i] + trend[i] * dt;
+            const float residual = energies[i] - predicted;
+            level[i] = predicted + alpha * residual;
+            trend[i] += beta * residual / dt;
+            error[i] += 0.2f * (std::abs(residual) - error[i]);
+            latest[i] = energies[i];
+        }
+        lastPosition = position;
+        ++frames;
+    }
+
+    /**
+     * @brief Get the extrapolated energies at a position. Never allocates if
+     * the destination has room for maxClusters values.
+     * @param position The sample position, at or after the latest frame.
+     * @param destination Receives the energies; untouched before the first
+     * frame.
+     */
+    void predict(const uint64_t position,
+                 std::vector<float> &destination) const {
+        if (frames == 0)
+            return;
+        destination.assign(latest.begin(), latest.end());
+        if (frames < 2)
+            return;
+        /// The frame describes audio about one interval old, so lead by one,
+        /// and never run further ahead than maxLead intervals
+        const float horizon = std::min(
+                static_cast<float>(position - lastPosition) + interval,
+                maxLead * interval);
+        float total = 0.0f, predictedTotal = 0.0f;
+        for (size_t i = 0; i < latest.size(); ++i) {
+            const float step = std::abs(trend[i]) * interval;
+            const float confidence =
+                    step + error[i] > 0.0f ? step / (step + error[i]) : 0.0f;
+            destination[i] = std::clamp(
+                    latest[i] + confidence * trend[i] * horizon, 0.0f, 1.0f);
+            total += latest[i];
+            predictedTotal += destination[i];
+        }
+        if (predictedTotal > 0.0f)
+            for (float &energy: destination)
+                energy *= total / predictedTotal;
+    }
+
+private:
+    /** Gain of the level correction */
+    static constexpr float alpha = 0.5f;
+
+    /** Gain of the trend correction */
+    static constexpr float beta = 0.1f;
+
+    /** Furthest extrapolation, in frame intervals */
+    static constexpr float maxLead = 2.0f;
+
+    /** Energies of the latest frame */
+    std::vector<float> latest;
+
+    /** Filtered energy of each cluster */
+    std::vector<float> level;
+
+    /** Filtered change of each cluster's energy, per sample */
+    std::vector<float> trend;
+
+    /** Average size of each cluster's prediction error */
+    std::vector<float> error;
+
+    /** Sample position the latest frame arrived at */
+    uint64_t lastPosition = 0;
+
+    /** Average number of samples between frames */
+    float interval = 0.0f;
+
+    /** Number of frames since the last reset */
+    uint64_t frames = 0;
+};
+
+#endif // ENERGY_PREDICTOR_H
@@ -0,0 +1,407 @@
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <juce_core/juce_core.h>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "AnalysisCaptureFormat.h"
+
+/**
+ * @brief Always-on record of the last few seconds of processing, dumped to a
+ * file when something goes wrong.
+ *
+ * The audio thread appends a compact record per block and the analysis thread
+ * one per frame, each into its own overwriting ring; neither ever locks or
+ * allocates. A block that overruns its deadline, or leaves the analysis too
+ * far behind, requests a dump, and the next non-real-time caller of
+ * dumpIfRequested() (the analysis thread, between frames) writes both rings to
+ * a text file, so every dropout comes with its own trace. Dumps are at least
+ * ten seconds apart, only the newest few are kept, and triggers are ignored
+ * for a few blocks after arm(), as the first blocks after a prepare are
+ * expected to be slow. Nothing is written unless a directory is set, by
+ * GRAPHVERB_TRACE_DIR or setDirectory(); the rings record either way.
+ */
+class FlightRecorder {
+public:
+    /**
+     * @brief What happened in one processed block.
+     */
+    struct BlockRecord {
+        /** Steady clock at the start of the block, in nanoseconds */
+        uint64_t timeNs;
+        /** Time spent processing the block */
+        float durationUs;
+        /** Real time the block represents */
+        float budgetUs;
+        uint32_t numSamples;
+        /** Samples waiting for the analysis after the block */
+        uint32_t queuedSamples;
+        /** Reverbs with a non-zero weight */
+        uint16_t activeVoices;
+        /** Combination of BlockFlags */
+        uint16_t flags;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(BlockRecord) == 32);
+
+    /**
+     * @brief What happened in one analysed frame.
+     */
+    struct FrameRecord {
+        /** Steady clock at the end of the frame, in nanoseconds */
+        uint64_t timeNs;
+        /** Number of samples analysed since the worker started */
+        uint64_t samplePosition;
+        /** Time spent in each AnalysisCapture::Stage */
+        float stageMicroseconds[AnalysisCapture::numStages];
+        /** Number of k-means iterations the clustering ran */
+        uint32_t iterations;
+        /** Samples still waiting for the analysis after the frame */
+        uint32_t queuedSamples;
+        uint16_t numClusters;
+        /** Combination of AnalysisCapture::Flags */
+        uint16_t flags;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(FrameRecord) == 48);
+
+    /**
+     * @brief Flags describing a block.
+     */
+    enum BlockFlags : uint16_t {
+        bypassed = 1u << 0,
+        replaying = 1u << 1,
+        /** The sidechain keyed the analysis */
+        keyed = 1u << 2,
+        /** Non-finite input samples were replaced */
+        nonFiniteInput = 1u << 3,
+        /** The reverb voices were handed to a task runner */
+        parallelVoices = 1u << 4,
+        /** A convolution stood in for the reverb voices */
+        staticReverb = 1u << 5,
+        /** The modal bank stood in for the reverb voices */
+        modalReverb = 1u << 6
+    };
+
+    /**
+     * @brief Why a dump was written.
+     */
+    enum class Trigger { none, deadline, backlog, manual };
+
+    /**
+     * @brief Allocate the rings. Must be called before recording, and not
+     * while recording; later calls do nothing.
+     * @param numBlocks Number of block records kept, rounded up to a power
+     * of two.
+     * @param numFrames Number of frame records kept, likewise.
+     */
+    void allocate(size_t numBlocks, size_t numFrames);
+
+    /**
+     * @brief Get the number of bytes held by the rings.
+     * @return The number of bytes.
+     */
+    [[nodiscard]] size_t getMemoryBytes() const {
+        return blocks.getMemoryBytes() + frames.getMemoryBytes();
+    }
+
+    /**
+     * @brief Get the number of bytes the rings hold once allocated.
+     * @param numBlocks Number of block records kept, as for allocate().
+     * @param numFrames Number of frame records kept, likewise.
+     * @return The number of bytes.
+     */
+    static size_t getMemoryBytes(const size_t numBlocks,
+                                 const size_t numFrames) {
+        return Ring<BlockRecord>::getMemoryBytes(numBlocks) +
+               Ring<FrameRecord>::getMemoryBytes(numFrames);
+    }
+
+    /**
+     * @brief Ignore triggers for a number of blocks from now. Safe to call
+     * while recording.
+     * @param warmupBlocks Number of blocks to ignore.
+     */
+    void arm(const uint64_t warmupBlocks) {
+        armedFrom.store(blocks.getNumWritten() + warmupBlocks,
+                        std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Set what triggers a dump.
+     * @param deadlineFraction Fraction of a block's real time its processing
+     * may take.
+     * @param backlogSamples Number of samples the analysis may fall behind.
+     */
+    void setThresholds(const float deadlineFraction,
+                       const uint32_t backlogSamples) {
+        deadlineThreshold.store(deadlineFraction, std::memory_order_relaxed);
+        backlogThreshold.store(backlogSamples, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Append a block record and check it against the thresholds.
+     * Audio thread only; lock-free and allocation-free.
+     * @param record The record.
+     */
+    void recordBlock(const BlockRecord &record);
+
+    /**
+     * @brief Append a frame record. Analysis thread only; lock-free and
+     * allocation-free.
+     * @param record The record.
+     */
+    void recordFrame(const FrameRecord &record) { frames.write(record); }
+
+    /**
+     * @brief Ask for a dump. Lock-free; the first request stands until the
+     * dump is written.
+     * @param reason Why.
+     */
+    void requestDump(Trigger reason);
+
+    /**
+     * @brief Set where dumps are written.
+     * @param directoryIn The directory, created when needed, or a default
+     * File to keep recording without ever dumping.
+     */
+    void setDirectory(const juce::File &directoryIn);
+
+    /**
+     * @brief Write the requested dump, if any and if the last one was long
+     * enough ago. Not for the audio thread.
+     * @return The file written, or a default File.
+     */
+    juce::File dumpIfRequested();
+
+    /**
+     * @brief Write a dump now. Not for the audio thread.
+     * @param reason Why, recorded in the file.
+     * @return The file written, or a default File if it could not be.
+     */
+    juce::File dump(Trigger reason);
+
+    /**
+     * @brief Get the number of dumps written.
+     * @return The number of dumps.
+     */
+    [[nodiscard]] uint64_t getNumDumps() const {
+        return numDumps.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of requests dropped because the last dump was
+     * too recent.
+     * @return The number of requests.
+     */
+    [[nodiscard]] uint64_t getNumSuppressed() const {
+        return numSuppressed.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the steady clock, as stored in the records.
+     * @return The time in nanoseconds.
+     */
+    static uint64_t now();
+
+    /**
+     * @brief Get the directory dumps go to by default: GRAPHVERB_TRACE_DIR if
+     * set, otherwise none.
+     * @return The directory, or a default File.
+     */
+    static juce::File getDefaultDirectory();
+
+    /** Shortest time between two dumps */
+    static constexpr juce::int64 minDumpIntervalMs = 10000;
+
+    /** Number of dumps kept in the directory; older ones are deleted */
+    static constexpr int maxDumps = 16;
+
+private:
+    /**
+     * @brief Single-producer ring of records that overwrites the oldest.
+     *
+     * Each slot is a seqlock over atomic words, so a reader can copy the ring
+     * while the producer keeps writing, and skips any slot it catches
+     * half-written or overwritten.
+     */
+    template<typename Record>
+    class Ring {
+    public:
+        static_assert(std::is_trivially_copyable_v<Record> &&
+                      sizeof(Record) % sizeof(uint64_t) == 0);
+
+        /**
+         * @brief Allocate the slots.
+         * @param capacity Number of records, rounded up to a power of two.
+         */
+        void allocate(const size_t capacity) {
+            const size_t size = getNumSlots(capacity);
+            slots = std::make_unique<Slot[]>(size);
+            mask = size - 1;
+        }
+
+        /**
+         * @brief Check if the slots have been allocated.
+         * @return True if allocate() has been called.
+         */
+        [[nodiscard]] bool isAllocated() const { return slots != nullptr; }
+
+        /**
+         * @brief Append a record, overwriting the oldest. Producer only.
+         * @param record The record.
+         */
+        void write(const Record &record) {
+            if (slots == nullptr)
+                return;
+            const uint64_t index = written.load(std::memory_order_relaxed);
+            Slot &slot = slots[index & mask];
+            slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            uint64_t data[numWords];
+            std::memcpy(data, &record, sizeof(Record));
+            for (size_t w = 0; w < numWords; ++w)
+                slot.words[w].store(data[w], std::memory_order_relaxed);
+            slot.sequence.store(2 * index + 2, std::memory_order_release);
+            written.store(index + 1, std::memory_order_release);
+        }
+
+        /**
+         * @brief Copy the records still held, oldest first. Any thread.
+         * @return The records.
+         */
+        [[nodiscard]] std::vector<Record> read() const {
+            std::vector<Record> records;
+            if (slots == nullptr)
+                return records;
+            const uint64_t end = written.load(std::memory_order_acquire);
+            const uint64_t size = mask + 1;
+            records.reserve(static_cast<size_t>(std::min(end, size)));
+            for (uint64_t index = end > size ? end - size : 0; index < end;
+                 ++index) {
+                const Slot &slot = slots[index & mask];
+                const uint64_t before =
+                        slot.sequence.load(std::memory_order_acquire);
+                if (before != 2 * index + 2)
+                    continue;
+                uint64_t data[numWords];
+                for (size_t w = 0; w < numWords; ++w)
+                    data[w] = slot.words[w].load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (slot.sequence.load(std::memory_order_relaxed) != before)
+                    continue;
+                std::memcpy(&records.emplace_back(), data, sizeof(Record));
+            }
+            return records;
+        }
+
+        /**
+         * @brief Get the number of records ever written.
+         * @return The number of records.
+         */
+        [[nodiscard]] uint64_t getNumWritten() const {
+            return written.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Get the number of bytes held by the slots.
+         * @return The number of bytes.
+         */
+        [[nodiscard]] size_t getMemoryBytes() const {
+            return slots != nullptr ? (mask + 1) * sizeof(Slot) : 0;
+        }
+
+        /**
+         * @brief Get the number of bytes the slots hold once allocated.
+         * @param capacity Number of records, as for allocate().
+         * @return The number of bytes.
+         */
+        static size_t getMemoryBytes(const size_t capacity) {
+            return getNumSlots(capacity) * sizeof(Slot);
+        }
+
+    private:
+        static constexpr size_t numWords = sizeof(Record) / sizeof(uint64_t);
+
+        /**
+         * @brief Round a capacity up to the number of slots allocated.
+         * @param capacity Number of records.
+         * @return The number of slots, a power of two.
+         */
+        static size_t getNumSlots(const size_t capacity) {
+            size_t size = 1;
+            while (size < capacity)
+                size <<= 1;
+            return size;
+        }
+
+        /**
+         * @brief One record and the sequence guarding it: odd while being
+         * written, 2 * (index + 1) once record index is complete.
+         */
+        struct Slot {
+            std::atomic<uint64_t> sequence{0};
+            std::array<std::atomic<uint64_t>, numWords> words{};
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        size_t mask = 0;
+        std::atomic<uint64_t> written{0};
+    };
+
+    /** Block records, written by the audio thread */
+    Ring<BlockRecord> blocks;
+
+    /** Frame records, written by the analysis thread */
+    Ring<FrameRecord> frames;
+
+    /** Number of blocks written before which triggers are ignored */
+    std::atomic<uint64_t> armedFrom{0};
+
+    /** Fraction of a block's real time its processing may take */
+    std::atomic<float> deadlineThreshold{1.0f};
+
+    /** Number of samples the analysis may fall behind */
+    std::atomic<uint32_t> backlogThreshold{16384};
+
+    /** The requested dump's Trigger, or none */
+    std::atomic<int> pendingTrigger{0};
+
+    /** Steady clock when the pending dump was requested */
+    std::atomic<uint64_t> triggerTimeNs{0};
+
+    std::atomic<uint64_t> numDumps{0};
+    std::atomic<uint64_t> numSuppressed{0};
+
+    /** Mutex guarding the directory and the dump timing */
+    std::mutex dumpMutex;
+
+    /** Where dumps are written, or a default File for nowhere */
+    juce::File directory = getDefaultDirectory();
+
+    /** Wall clock of the last dump, in milliseconds */
+    juce::int64 lastDumpMs = 0;
+
+    /**
+     * @brief Write a dump. dumpMutex must be held.
+     * @param reason Why.
+     * @param requestedNs Steady clock when the dump was requested.
+     * @return The file written, or a default File.
+     */
+    juce::File dumpLocked(Trigger reason, uint64_t requestedNs);
+
+    /**
+     * @brief Delete all but the newest maxDumps dumps in the directory.
+     * dumpMutex must be held.
+     */
+    void pruneLocked() const;
+};
+
+#endif // FLIGHT_RECORDER_H
@@ -4,13 +4,16 @@
 #include <juce_audio_devices/juce_audio_devices.h>
 #include <juce_audio_processors/juce_audio_processors.h>
 
+#include "AnalysisReplay.h"
+#include "AnalysisWorker.h"
 #include "AudioBufferQueue.h"
-#include "CommunityClustering.h"
-#include "CommunityReverb.h"
+#include "DspState.h"
+#include "EnergyPredictor.h"
+#include "FlightRecorder.h"
+#include "ImpulseCapture.h"
+#include "MemoryTracker.h"
 #include "ScopeDataCollector.h"
-#include "SpectralAnalyzer.h"
-#include "SpectralGraph.h"
-#include "ThreadSafeQueue.h"
+#include "TaskRunner.h"
 
 /**
  * @brief Audio processor for the Graphverb plugin.
@@ -25,15 +28,32 @@ public:
     /**
      * @brief Destructor for the Graphverb processor.
      */
-    ~Graphverb() override = default;
+    ~Graphverb() override;
 
     /**
      * @brief Prepare the processor for playback.
+     *
+     * Reuses the current processing state when it fits the new configuration;
+     * otherwise builds a new one here and hands it to the audio thread, which
+     * crossfades to it on its next callback. Safe to call while audio runs.
+     *
      * @param sampleRate The sample rate of the audio stream.
      * @param samplesPerBlock The number of samples per block to process.
      */
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
 
+    /**
+     * @brief Declare the largest block size the host may ever use.
+     *
+     * prepareToPlay() then sizes the buffers for it once, and later block size
+     * changes up to it reuse them instead of rebuilding.
+     *
+     * @param maxBlockSize The largest block size, in samples.
+     */
+    void setMaximumBlockSize(const int maxBlockSize) {
+        declaredMaxBlockSize.store(maxBlockSize);
+    }
+
     /**
      * @brief Release any resources used by the processor.
      */
@@ -52,6 +72,34 @@ public:
     void processBlock(juce::AudioBuffer<float> &buffer,
                       juce::MidiBuffer &midiMessages) override;
 
+    /**
+     * @brief Process a block while the host bypasses the plugin. Takes the
+     * same cheap path as the bypass parameter.
+     */
+    void processBlockBypassed(juce::AudioBuffer<float> &buffer,
+                              juce::MidiBuffer &midiMessages) override;
+
+    /**
+     * @brief Get the parameter hosts should use to bypass the plugin.
+     * @return The bypass parameter.
+     */
+    juce::AudioProcessorParameter *getBypassParameter() const override;
+
+    /**
+     * @brief Choose what keeps running while bypassed. The audio itself
+     * always passes through untouched.
+     * @param ringOutTails Whether the reverb tails ring out over the dry
+     * signal, rather than stopping at once.
+     * @param analysisDecimation Hops per analysed frame while bypassed, so
+     * the energies are current when the bypass ends; 0 stops feeding the
+     * analysis.
+     */
+    void setBypassBehaviour(const bool ringOutTails,
+                            const int analysisDecimation) {
+        bypassRingsOutTails.store(ringOutTails);
+        bypassAnalysisDecimation.store(analysisDecimation);
+    }
+
     /**
      * @brief Create an editor for the processor.
      * @return A pointer to the created editor.
@@ -84,9 +132,9 @@ public:
 
     /**
      * @brief Get the tail length in seconds.
-     * @return The tail length in seconds. For this processor, it is 0.0
+     * @return The time the longest reverb tail takes to ring out.
      */
-    double getTailLengthSeconds() const override { return 0.0; }
+    double getTailLengthSeconds() const override;
 
     /**
      * @brief Get the number of programs supported by the processor.
@@ -118,13 +166,164 @@ public:
 
     /**
      * @brief Get the state information of the processor.
+     *
+     * Saves the parameters and a snapshot of the analysis state, so that a
+     * reopened session starts from converged clusters.
+     *
+     * @param destData The block to write the state to.
      */
-    void getStateInformation(juce::MemoryBlock &) override {}
+    void getStateInformation(juce::MemoryBlock &destData) override;
 
     /**
      * @brief Set the state information of the processor.
+     * @param data Pointer to the state written by getStateInformation().
+     * @param sizeInBytes Size of the state in bytes.
+     */
+    void setStateInformation(const void *data, int sizeInBytes) override;
+
+    /**
+     * @brief Change the analysis settings while running. Neither the audio
+     * thread nor the analysis thread is blocked or restarted.
+     *
+     * The cluster count is limited to the number of reverbs, and the FFT
+     * order and hop size to sensible ranges.
+     *
+     * @param config The new analysis settings.
+     */
+    void setAnalysisConfig(const AnalysisConfig &config);
+
+    /**
+     * @brief Get the latest analysis settings.
+     * @return A copy of the settings.
+     */
+    AnalysisConfig getAnalysisConfig() { return analysisWorker.getConfig(); }
+
+    /**
+     * @brief Start capturing every analysed frame to a file, replacing any
+     * capture in progress. Call off the audio thread.
+     * @param file The capture file, replaced if it exists.
+     * @param seconds Length of audio the file has room for.
+     * @return True if the capture started.
+     */
+    bool startAnalysisCapture(const juce::File &file,
+                              const double seconds = defaultCaptureSeconds) {
+        return analysisWorker.startCapture(file, seconds);
+    }
+
+    /**
+     * @brief Stop capturing analysed frames and close the capture file.
      */
-    void setStateInformation(const void *, int) override {}
+    void stopAnalysisCapture() { analysisWorker.stopCapture(); }
+
+    /**
+     * @brief Check if analysed frames are being captured.
+     * @return True if a capture is in progress.
+     */
+    bool isCapturingAnalysis() const { return analysisWorker.isCapturing(); }
+
+    /**
+     * @brief Get the number of GRAPHVERB_CAPTURE_DIR captures that could not
+     * be started.
+     * @return The number of failed captures since construction.
+     */
+    uint64_t getNumFailedAnalysisCaptures() const {
+        return analysisWorker.getNumFailedCaptures();
+    }
+
+    /**
+     * @brief Drive the reverbs from the energies recorded in an analysis
+     * capture instead of the live analysis, which is stopped. Call off the
+     * audio thread.
+     *
+     * The capture is followed by sample position from the next block, and
+     * again from its start after every prepareToPlay(), so rendering the same
+     * input twice gives the same output.
+     *
+     * @param file The capture file.
+     * @return True if the capture was loaded.
+     */
+    bool startAnalysisReplay(const juce::File &file);
+
+    /**
+     * @brief Return to the live analysis. Call off the audio thread.
+     */
+    void stopAnalysisReplay();
+
+    /**
+     * @brief Check if the reverbs are driven by a replayed capture.
+     * @return True if a replay is active.
+     */
+    bool isReplayingAnalysis() const { return currentReplay.load() != nullptr; }
+
+    /**
+     * @brief Extrapolate the cluster energies between analysis frames, or
+     * hold each frame's energies until the next.
+     * @param shouldPredict Whether to extrapolate.
+     */
+    void setEnergyPrediction(const bool shouldPredict) {
+        predictEnergies.store(shouldPredict);
+    }
+
+    /**
+     * @brief Replace the reverbs with one convolution while their weights
+     * hold still.
+     *
+     * Once the weights and reverb parameters have stayed within a small
+     * tolerance for half a second, the impulse response of the weighted bank
+     * is rendered in the background and, after the convolution has filled
+     * up, crossfaded in. When the weights move again the reverbs restart
+     * while the convolution's tail rings out. Mono and stereo only.
+     *
+     * @param shouldConvolve Whether to convolve while the weights hold still.
+     */
+    void setStaticReverb(const bool shouldConvolve) {
+        staticReverbEnabled.store(shouldConvolve);
+    }
+
+    /**
+     * @brief Check if the convolution has replaced the reverbs.
+     * @return True while the reverbs are not running.
+     */
+    bool isStaticReverbActive() const {
+        return staticReverbActive.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Replace the reverbs with a bank of modal resonators.
+     *
+     * Each mode follows the reverb of the cluster covering its frequency in
+     * the latest analysis, with the same decay, damping and level, so the
+     * control per cluster is exact while the cost grows with the number of
+     * modes rather than clusters. Switching crossfades over one block. The
+     * static reverb stays off while the modes run.
+     *
+     * @param useModes Whether to render the modal bank instead of the
+     * reverbs.
+     */
+    void setModalReverb(const bool useModes) {
+        modalReverbEnabled.store(useModes);
+    }
+
+    /**
+     * @brief Run the reverb voices on threads lent by a host, or serially.
+     *
+     * The runner is only used from the audio thread, and must stay alive
+     * until it is replaced or the processor is destroyed.
+     *
+     * @param runner The runner, or null to render the voices serially.
+     */
+    void setTaskRunner(TaskRunner *runner) {
+        taskRunner.store(runner, std::memory_order_release);
+    }
+
+    /**
+     * @brief Turn the scope capture on or off entirely, e.g. for headless
+     * rendering. It only runs while an editor shows the scope anyway.
+     * @param shouldCapture Whether to capture.
+     */
+    void setScopeEnabled(const bool shouldCapture) {
+        scopeEnabled.store(shouldCapture);
+    }
 
     /**
      * @brief Get the audio buffer queue.
@@ -141,31 +340,260 @@ public:
     juce::AudioProcessorValueTreeState &getParameters() { return parameters; }
 
     /**
-     * @brief Get the cluster energies.
-     * @return A reference to the vector of cluster energies.
+     * @brief Get the cluster energies. Safe to call from any thread.
+     * @return A copy of the latest cluster energies.
+     */
+    std::vector<float> getClusterEnergies() {
+        return analysisWorker.getEnergies();
+    }
+
+    /**
+     * @brief Check if the analysis thread is running.
+     * @return True if the analysis thread is running, false otherwise.
+     */
+    bool isAnalysisRunning() const { return analysisWorker.isRunning(); }
+
+    /**
+     * @brief Get the number of non-finite input samples replaced with silence.
+     * @return The number of replaced samples since construction.
      */
-    const std::vector<float> &getClusterEnergies() const {
-        return clusterEnergies;
+    uint64_t getNonFiniteInputSamples() const {
+        return nonFiniteInputSamples.load(std::memory_order_relaxed);
     }
 
+    /**
+     * @brief Get the number of input blocks that contained non-finite samples.
+     * @return The number of affected blocks since construction.
+     */
+    uint64_t getNonFiniteInputBlocks() const {
+        return nonFiniteInputBlocks.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of analysis frames dropped as non-finite.
+     * @return The number of dropped frames since construction.
+     */
+    uint64_t getNonFiniteAnalysisFrames() const {
+        return analysisWorker.getNonFiniteFrames();
+    }
+
+    /**
+     * @brief Get the memory tracker, so the editor can report its own bytes.
+     * @return A reference to the memory tracker.
+     */
+    MemoryTracker &getMemoryTracker() { return memoryTracker; }
+
+    /**
+     * @brief Get the flight recorder, e.g. to change where it dumps or what
+     * triggers a dump, or to dump on demand.
+     * @return A reference to the flight recorder.
+     */
+    FlightRecorder &getFlightRecorder() { return flightRecorder; }
+
+    /**
+     * @brief Refresh the dynamic memory counters and take a snapshot.
+     * @return The per-subsystem memory footprint of this instance.
+     */
+    MemoryTracker::Snapshot getMemoryFootprint();
+
+    /**
+     * @brief Get the number of bytes an instance holds in what it sizes for
+     * its configuration: the reverbs, the modal bank, the processing buffers
+     * and the flight recorder. Not counted: the analysis, its input queue and
+     * the scope, which do not depend on the configuration, and the static
+     * mode's impulse capture. For reporting; it grows with the subsystems, so
+     * it is no budget.
+     * @param sampleRate The sample rate.
+     * @param numChannels The number of channels processed.
+     * @param blockSize The largest block size.
+     * @param hopSize The analysis hop size.
+     * @return The number of bytes.
+     */
+    static size_t getSizedMemoryBytes(double sampleRate, int numChannels,
+                                      int blockSize, int hopSize);
+
+    /**
+     * @brief Check if the analysis was keyed by the sidechain in the last
+     * processed block.
+     * @return True if the sidechain bus drove the analysis.
+     */
+    bool isKeyedBySidechain() const {
+        return keyedBySidechain.load(std::memory_order_relaxed);
+    }
+
+    /** Number of clusters, and therefore reverbs, used by the processor. */
+    static constexpr int numClusters = 12;
+
+    /** Modes of each channel of the modal bank. */
+    static constexpr int modalModesPerChannel = 1024;
+
+    /** Index of the sidechain input bus keying the analysis. */
+    static constexpr int sidechainBus = 1;
+
+    /** Length of audio a capture has room for by default, in seconds */
+    static constexpr double defaultCaptureSeconds = 300.0;
+
 private:
     /** Audio processor value tree state for managing parameters. */
     juce::AudioProcessorValueTreeState parameters;
 
-    /** Spectral analyzer for performing the STFT */
-    SpectralAnalyzer spectralAnalyzer;
+    /** Property of the saved state holding the analysis snapshot */
+    static constexpr const char *analysisStateId = "analysisSnapshot";
+
+    /** Per-subsystem memory accounting for this instance */
+    MemoryTracker memoryTracker;
+
+    /** Trace of the last few seconds of blocks and frames, dumped on
+     * overruns; outlives the analysis worker recording into it */
+    FlightRecorder flightRecorder;
+
+    /** Seconds of blocks and frames the flight recorder keeps */
+    static constexpr int flightRecorderSeconds = 10;
+
+    /** Blocks after a prepare whose overruns do not trigger a dump */
+    static constexpr int flightRecorderWarmupBlocks = 64;
+
+    /**
+     * @brief Get the number of block records the flight recorder keeps.
+     * @param sampleRate The sample rate.
+     * @param blockSize The block size.
+     * @return The number of records.
+     */
+    static size_t getFlightRecorderBlocks(const double sampleRate,
+                                          const int blockSize) {
+        return static_cast<size_t>(flightRecorderSeconds * sampleRate /
+                                   juce::jmax(1, blockSize));
+    }
+
+    /**
+     * @brief Get the number of frame records the flight recorder keeps.
+     * @param sampleRate The sample rate.
+     * @param hopSize The analysis hop size.
+     * @return The number of records.
+     */
+    static size_t getFlightRecorderFrames(const double sampleRate,
+                                          const int hopSize) {
+        return static_cast<size_t>(flightRecorderSeconds * sampleRate /
+                                   juce::jmax(1, hopSize));
+    }
+
+    /** Renders the reverbs' impulse response for the static mode, on the
+     * analysis thread; outlives the analysis worker */
+    ImpulseCapture impulseCapture;
+
+    /** Background worker running the analysis and clustering */
+    AnalysisWorker analysisWorker;
+
+    /** Thread loading impulse responses into the convolutions, shared by
+     * every instance; outlives the states using it */
+    juce::SharedResourcePointer<juce::dsp::ConvolutionMessageQueue>
+            convolutionQueue;
+
+    /** Every processing state that may still be in use, owned off the audio
+     * thread and guarded by dspStateMutex */
+    std::vector<std::unique_ptr<DspState>> dspStates;
+
+    /** Mutex serialising prepare, release and collection of dspStates */
+    std::mutex dspStateMutex;
+
+    /** The state the audio thread should use, published by prepareToPlay() */
+    std::atomic<DspState *> currentDspState{nullptr};
+
+    /** States the audio thread is using: the active one and, for one
+     * crossfade, the outgoing one. Nothing listed here is freed. */
+    std::array<std::atomic<DspState *>, 2> dspStatesInUse{};
+
+    /** State the audio thread is processing with; audio thread only */
+    DspState *activeDspState = nullptr;
+
+    /** Outgoing state to crossfade from, or null; audio thread only */
+    DspState *fadingDspState = nullptr;
+
+    /** Owner of the replay being played, guarded by replayMutex */
+    std::unique_ptr<AnalysisReplay> replay;
 
-    /** Spectral graph for storing the graph structure */
-    SpectralGraph spectralGraph;
+    /** Mutex serialising the start and stop of replays with prepare */
+    std::mutex replayMutex;
 
-    /** Community clustering algorithm for clustering nodes */
-    CommunityClustering clustering;
+    /** The replay the audio thread should use, or null for live analysis */
+    std::atomic<const AnalysisReplay *> currentReplay{nullptr};
 
-    /** Vector to store the average energy of each cluster */
-    std::vector<float> clusterEnergies;
+    /** The replay the audio thread is using; never freed while set */
+    std::atomic<const AnalysisReplay *> replayInUse{nullptr};
 
-    /** Community reverb instances for each cluster */
-    std::vector<std::unique_ptr<CommunityReverb>> communityReverbs;
+    /** Set to play the replay from its start on the next block */
+    std::atomic<bool> replayRewind{false};
+
+    /** Samples played since the replay started; audio thread only */
+    uint64_t replayPosition = 0;
+
+    /** Whether the processor is prepared, so stopping a replay restarts the
+     * analysis; guarded by replayMutex */
+    bool prepared = false;
+
+    /** Whether the reverb tails ring out while bypassed */
+    std::atomic<bool> bypassRingsOutTails{true};
+
+    /** Hops per analysed frame while bypassed, or 0 for no analysis */
+    std::atomic<int> bypassAnalysisDecimation{4};
+
+    /** Whether the energies are extrapolated between analysis frames */
+    std::atomic<bool> predictEnergies{true};
+
+    /** Whether a convolution replaces the reverbs while the weights hold
+     * still */
+    std::atomic<bool> staticReverbEnabled{false};
+
+    /** Whether the convolution has replaced the reverbs */
+    std::atomic<bool> staticReverbActive{false};
+
+    /** Whether the modal bank replaces the reverbs */
+    std::atomic<bool> modalReverbEnabled{false};
+
+    /** Seconds the weights must hold still before they are captured */
+    static constexpr double staticSettleSeconds = 0.5;
+
+    /** Seconds the convolution runs alongside the reverbs before taking
+     * over, so the earlier input has mostly passed through it */
+    static constexpr double staticWarmupSeconds = 1.0;
+
+    /** Seconds of the crossfade from the reverbs to the convolution */
+    static constexpr double staticCrossfadeSeconds = 0.05;
+
+    /** Largest change of a weight or reverb parameter counted as still */
+    static constexpr float staticTolerance = 0.02f;
+
+    /** Extrapolates the live energies; audio thread only */
+    EnergyPredictor energyPredictor{numClusters};
+
+    /** Publication of the energies last fed to the predictor; audio thread
+     * only */
+    uint64_t lastPublication = 0;
+
+    /** Samples processed with live analysis; audio thread only */
+    uint64_t processedSamples = 0;
+
+    /** Whether the last block was bypassed; audio thread only */
+    bool wasBypassed = false;
+
+    /** Whether a tail is still ringing out while bypassed; audio thread
+     * only */
+    bool tailRinging = false;
+
+    /** Peak below which a ringing tail counts as silent, -100 dB */
+    static constexpr float tailSilenceLevel = 1.0e-5f;
+
+    /** Whether the sidechain drove the analysis in the last block */
+    std::atomic<bool> keyedBySidechain{false};
+
+    /** Largest block size declared by setMaximumBlockSize(), or 0 */
+    std::atomic<int> declaredMaxBlockSize{0};
+
+    /** Runs the reverb voices in parallel, or null to run them serially */
+    std::atomic<TaskRunner *> taskRunner{nullptr};
+
+    /** Whether the scope capture runs at all */
+    std::atomic<bool> scopeEnabled{true};
 
     /** Buffer for visualizing audio data. */
     AudioBufferQueue<float> audioBufferQueue{};
@@ -173,20 +601,190 @@ private:
     /** Scope collector for visualizing audio data. */
     ScopeDataCollector<float> scopeDataCollector{audioBufferQueue};
 
-    /** Thread-safe queue for passing audio data to the analysis thread. */
-    ThreadSafeQueue<float> analysisInputQueue;
+    /** Number of non-finite input samples replaced with silence */
+    std::atomic<uint64_t> nonFiniteInputSamples{0};
+
+    /** Number of input blocks that contained non-finite samples */
+    std::atomic<uint64_t> nonFiniteInputBlocks{0};
+
+    /**
+     * @brief Process a block, bypassed or not.
+     * @param buffer The host buffer.
+     * @param hostBypassed Whether the host bypasses the plugin.
+     */
+    void process(juce::AudioBuffer<float> &buffer, bool hostBypassed);
 
-    /** Thread for performing spectral analysis */
-    std::thread analysisThread;
+    /**
+     * @brief Append a block to the flight recorder. Audio thread only.
+     * @param state The processing state.
+     * @param startNs Steady clock when the block started.
+     * @param numSamples The number of samples in the block.
+     * @param flags Combination of FlightRecorder::BlockFlags.
+     */
+    void recordBlock(const DspState &state, uint64_t startNs, int numSamples,
+                     uint16_t flags);
 
-    /** Flag to indicate if the analysis thread should exit */
-    std::atomic<bool> threadShouldExit;
+    /**
+     * @brief Tell the analysis where the host's beat grid falls in a block,
+     * from the play head. Audio thread only.
+     * @param numSamples The number of samples in the block.
+     * @param sampleRate The sample rate.
+     */
+    void followBeatGrid(int numSamples, double sampleRate);
 
-    /** The latest cluster energies from the analysis thread */
-    std::vector<float> latestClusterEnergies;
+    /**
+     * @brief Pick up the latest published processing state. Audio thread only.
+     *
+     * Marks the state as in use before touching it, re-checking that it is
+     * still the published one, so prepareToPlay() can never free it
+     * underneath. The previous state is kept for one crossfade.
+     *
+     * @return The state to process with, or null before the first prepare.
+     */
+    DspState *acquireDspState();
+
+    /**
+     * @brief Pick up the latest published replay. Audio thread only.
+     *
+     * The replay stays marked as in use until replayInUse is cleared at the
+     * end of the block.
+     *
+     * @return The replay to take energies from, or null for live analysis.
+     */
+    const AnalysisReplay *acquireReplay();
 
-    /** Mutex for synchronizing access to the cluster energies */
-    std::mutex energyMutex;
+    /**
+     * @brief Process part of a block with a state.
+     * @param state The processing state.
+     * @param mainBus The main bus channels of the host buffer.
+     * @param keyBus The channels driving the analysis, either the sidechain
+     * or the main input.
+     * @param activeReplay The replay supplying the energies, or null to use
+     * the live analysis.
+     * @param startSample The first sample to process.
+     * @param numSamples The number of samples, at most the state's capacity.
+     */
+    void processChunk(DspState &state, juce::AudioBuffer<float> &mainBus,
+                      const juce::AudioBuffer<float> &keyBus,
+                      const AnalysisReplay *activeReplay, int startSample,
+                      int numSamples);
+
+    /**
+     * @brief Crossfade a wet signal in from the outgoing state's tail, if the
+     * state was replaced since the last chunk, and release the outgoing
+     * state. Audio thread only.
+     * @param wet The wet signal of the current state, faded in.
+     * @param energies The cluster energies weighting the reverbs.
+     * @param dry The dry signal.
+     */
+    void crossfadeFromFadingState(juce::AudioBuffer<float> &wet,
+                                  const std::vector<float> &energies,
+                                  const juce::AudioBuffer<float> &dry);
+
+    /**
+     * @brief Release the outgoing state without rendering it. Audio thread
+     * only.
+     */
+    void releaseFadingDspState();
+
+    /**
+     * @brief Process part of a bypassed block: the audio passes through, a
+     * ringing tail is added and the analysis is fed if enabled.
+     * @param state The processing state.
+     * @param mainBus The main bus channels of the host buffer.
+     * @param keyBus The channels driving the analysis.
+     * @param activeReplay The replay supplying the energies, or null.
+     * @param startSample The first sample to process.
+     * @param numSamples The number of samples, at most the state's capacity.
+     */
+    void processBypassedChunk(DspState &state,
+                              juce::AudioBuffer<float> &mainBus,
+                              const juce::AudioBuffer<float> &keyBus,
+                              const AnalysisReplay *activeReplay,
+                              int startSample, int numSamples);
+
+    /**
+     * @brief Get the output gain set by the gain parameter.
+     * @return The linear gain.
+     */
+    float getOutputGain() const;
+
+    /**
+     * @brief Render the wet signal with the selected engine, the reverbs or
+     * the modal bank, crossfading over the chunk when the selection changes.
+     * @param state The processing state.
+     * @param energies The cluster energies weighting the reverbs.
+     * @param dry The dry signal.
+     * @return A view of the wet signal, the same size as the dry signal.
+     */
+    juce::AudioBuffer<float> renderWet(DspState &state,
+                                       const std::vector<float> &energies,
+                                       const juce::AudioBuffer<float> &dry);
+
+    /**
+     * @brief Run the dry signal through a state's reverbs into its wet buffer.
+     * @param state The processing state.
+     * @param energies The cluster energies weighting the reverbs.
+     * @param dry The dry signal.
+     * @return A view of the wet signal, the same size as the dry signal.
+     */
+    juce::AudioBuffer<float> renderReverbs(DspState &state,
+                                           const std::vector<float> &energies,
+                                           const juce::AudioBuffer<float> &dry);
+
+    /**
+     * @brief Run the dry signal through a state's modal bank into its modal
+     * buffer.
+     * @param state The processing state.
+     * @param energies The cluster energies weighting the modes.
+     * @param dry The dry signal.
+     * @return A view of the wet signal, the same size as the dry signal.
+     */
+    juce::AudioBuffer<float> renderModes(DspState &state,
+                                         const std::vector<float> &energies,
+                                         const juce::AudioBuffer<float> &dry);
+
+    /**
+     * @brief Set each reverb's parameters from its cluster energy.
+     * @param state The processing state.
+     * @param energies The cluster energies.
+     */
+    void updateReverbParameters(DspState &state,
+                                const std::vector<float> &energies);
+
+    /**
+     * @brief Render the wet signal with the reverbs, the convolution standing
+     * in for them, or both, moving through the static modes.
+     * @param state The processing state.
+     * @param energies The cluster energies weighting the reverbs.
+     * @param dry The dry signal.
+     * @return A view of the wet signal, the same size as the dry signal.
+     */
+    juce::AudioBuffer<float> renderWetStatic(
+            DspState &state, const std::vector<float> &energies,
+            const juce::AudioBuffer<float> &dry);
+
+    /**
+     * @brief Move a state to its next static mode, if the weights or the
+     * rendered capture call for it.
+     * @param state The processing state.
+     * @param energies The cluster energies.
+     * @param numSamples The number of samples about to be processed.
+     */
+    void updateStaticMode(DspState &state, const std::vector<float> &energies,
+                          int numSamples);
+
+    /**
+     * @brief Return a state to the reverbs alone at once, e.g. for a bypass.
+     * @param state The processing state.
+     */
+    void leaveStaticMode(DspState &state);
+
+    /**
+     * @brief Free the states the audio thread can no longer reach and update
+     * the memory accounting. dspStateMutex must be held.
+     */
+    void collectDspStatesLocked();
 
     /**
      * @brief Create the parameter layout for the processor.
@@ -8,6 +8,7 @@
 #include "KnobComponent.h"
 #include "ButtonComponent.h"
 #include "ScopeComponent.h"
+#include "TelemetryOverlay.h"
 
 /**
  * @brief Editor class for the GraphVerb processor.
@@ -22,7 +23,7 @@ public:
     /**
      * @brief Destructor for the GraphVerbEditor.
      */
-    ~GraphverbEditor() override = default;
+    ~GraphverbEditor() override;
 
     /**
      * @brief Paint the editor's background.
@@ -34,6 +35,13 @@ public:
      */
     void resized() override;
 
+    /**
+     * @brief Toggle the telemetry overlay on a double-click of the cluster
+     * visualizer.
+     * @param event The mouse event.
+     */
+    void mouseDoubleClick(const juce::MouseEvent &event) override;
+
 private:
     /** Reference to the GraphVerb processor */
     Graphverb &processor;
@@ -59,6 +67,9 @@ private:
     /** Cluster visualizer for displaying the graph structure */
     ClusterVisualizer clusterVisualizer;
 
+    /** Overlay with memory and robustness telemetry, hidden by default */
+    TelemetryOverlay telemetryOverlay;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(GraphverbEditor)
 
     /**
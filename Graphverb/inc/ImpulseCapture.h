@@ -0,0 +1,167 @@
+#ifndef IMPULSE_CAPTURE_H
+#define IMPULSE_CAPTURE_H
+
+#include <array>
+#include <atomic>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_dsp/juce_dsp.h>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Renders the impulse response of the weighted reverb bank in the
+ * background, so a single convolution can stand in for it while its weights
+ * hold still.
+ *
+ * With fixed weights and parameters the weighted sum of the reverbs is a
+ * linear time-invariant system whose wet part depends only on the sum of the
+ * input channels, so it is captured once by sending an impulse into the left
+ * channel of copies of the reverbs. The audio thread asks for a capture with
+ * request(), a non-real-time thread renders it a slice at a time with
+ * renderIfRequested(), and the audio thread hands the result to a
+ * convolution with loadInto(). Neither side ever waits for the other.
+ */
+class ImpulseCapture {
+public:
+    /** Most reverbs a capture can combine */
+    static constexpr int maxVoices = 16;
+
+    /** Longest impulse response rendered; longer tails are faded out */
+    static constexpr double maxSeconds = 4.0;
+
+    /** Samples rendered per call of renderIfRequested() */
+    static constexpr int sliceSamples = 4096;
+
+    /** Peak below which a rendered slice counts as silent, -120 dB */
+    static constexpr float silenceLevel = 1.0e-6f;
+
+    /**
+     * @brief The reverb bank to capture.
+     */
+    struct Request {
+        double sampleRate = 0.0;
+        /** One or two channels */
+        int numChannels = 0;
+        int numVoices = 0;
+        /** Parameters of each reverb */
+        std::array<juce::Reverb::Parameters, maxVoices> parameters{};
+        /** Weight of each reverb in the mix */
+        std::array<float, maxVoices> weights{};
+    };
+
+    /**
+     * @brief Ask for a capture. Audio thread only; never blocks.
+     * @param request The reverb bank.
+     * @return True if the capture was queued, false if another one is still
+     * being rendered.
+     */
+    bool request(const Request &request);
+
+    /**
+     * @brief Drop the capture being rendered or waiting. Audio thread only.
+     */
+    void cancel();
+
+    /**
+     * @brief Hand a finished capture to a convolution, if it was rendered
+     * for the given format. Audio thread only; never allocates.
+     * @param convolution The convolution, prepared for the format.
+     * @param sampleRate The sample rate the convolution runs at.
+     * @param numChannels The number of channels it runs with.
+     * @return True if an impulse response was loaded.
+     */
+    bool loadInto(juce::dsp::Convolution &convolution, double sampleRate,
+                  int numChannels);
+
+    /**
+     * @brief Get the gain of the direct path of the last loaded capture,
+     * applied to each channel on its own rather than convolved.
+     * @return The gain.
+     */
+    [[nodiscard]] float getDirectGain() const { return directGain; }
+
+    /**
+     * @brief Get the length of the last loaded impulse response.
+     * @return The length in samples.
+     */
+    [[nodiscard]] int getImpulseLength() const { return impulseLength; }
+
+    /**
+     * @brief Render the next slice of the requested capture, if any. Not for
+     * the audio thread.
+     */
+    void renderIfRequested();
+
+    /**
+     * @brief Get the number of bytes held for rendering.
+     * @return The number of bytes.
+     */
+    [[nodiscard]] size_t getMemoryBytes() const {
+        return memoryBytes.load(std::memory_order_relaxed);
+    }
+
+private:
+    /**
+     * @brief Where the capture is; each phase is left by one side only.
+     */
+    enum Phase : int {
+        /** Nothing to do; the audio thread may request */
+        idle,
+        /** Requested; the renderer starts it */
+        requested,
+        /** Being rendered; the renderer finishes or drops it */
+        rendering,
+        /** Rendered; the audio thread loads or drops it */
+        ready
+    };
+
+    std::atomic<int> phase{idle};
+
+    /** Set by the audio thread to drop the capture being rendered */
+    std::atomic<bool> cancelled{false};
+
+    /** The capture asked for; written by the audio thread while idle */
+    Request pending;
+
+    /** Copies of the reverbs, rendering the capture */
+    std::vector<std::unique_ptr<juce::Reverb>> voices;
+
+    /** The impulse response being rendered, then handed over */
+    juce::AudioBuffer<float> impulse;
+
+    /** One voice's output for the current slice */
+    juce::AudioBuffer<float> scratch;
+
+    /** Samples of the impulse response rendered so far */
+    int rendered = 0;
+
+    /** Gain of the direct path, measured by the renderer when it finishes */
+    float renderedDirectGain = 0.0f;
+
+    /** Direct gain of the last loaded capture; audio thread only */
+    float directGain = 0.0f;
+
+    /** Length of the last loaded capture; audio thread only */
+    int impulseLength = 0;
+
+    std::atomic<size_t> memoryBytes{0};
+
+    /**
+     * @brief Set up the copies of the reverbs and the buffers for the
+     * pending capture.
+     */
+    void beginRender();
+
+    /**
+     * @brief Render one slice of the capture.
+     * @return True if the impulse response is complete.
+     */
+    bool renderSlice();
+
+    /**
+     * @brief Split off the direct path and trim the impulse response.
+     */
+    void finishRender();
+};
+
+#endif // IMPULSE_CAPTURE_H
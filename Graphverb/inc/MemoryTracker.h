@@ -0,0 +1,147 @@
+#ifndef MEMORY_TRACKER_H
+#define MEMORY_TRACKER_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Per-instance memory footprint accounting.
+ *
+ * Each subsystem reports the bytes it currently holds; the tracker keeps the
+ * peak of each subsystem and of the total, plus high-water marks for the
+ * queues between threads. All members are atomics so any thread may report or
+ * read without locking.
+ */
+class MemoryTracker {
+public:
+    /**
+     * @brief The subsystems that are accounted separately.
+     */
+    enum class Subsystem {
+        reverbs,
+        analysis,
+        analysisQueue,
+        scope,
+        processBuffers,
+        editor,
+        flightRecorder,
+        count
+    };
+
+    /** Number of subsystems. */
+    static constexpr size_t numSubsystems =
+            static_cast<size_t>(Subsystem::count);
+
+    /**
+     * @brief The queues whose high-water marks are tracked.
+     */
+    enum class Queue { analysisInput, scope, count };
+
+    /** Number of tracked queues. */
+    static constexpr size_t numQueues = static_cast<size_t>(Queue::count);
+
+    /**
+     * @brief A consistent-enough copy of the tracker for reporting.
+     */
+    struct Snapshot {
+        std::array<size_t, numSubsystems> current{};
+        std::array<size_t, numSubsystems> peak{};
+        std::array<size_t, numQueues> queueHighWater{};
+        size_t totalCurrent = 0;
+        size_t totalPeak = 0;
+    };
+
+    /**
+     * @brief Set the number of bytes currently held by a subsystem.
+     * @param subsystem The subsystem.
+     * @param bytes The bytes it now holds.
+     */
+    void setBytes(const Subsystem subsystem, const size_t bytes) {
+        const auto index = static_cast<size_t>(subsystem);
+        const size_t previous = current[index].exchange(bytes);
+        updateMax(peak[index], bytes);
+        const size_t total = totalCurrent.fetch_add(bytes - previous) +
+                             (bytes - previous);
+        updateMax(totalPeak, total);
+    }
+
+    /**
+     * @brief Report the current depth of a queue, in bytes.
+     * @param queue The queue.
+     * @param bytes The bytes currently waiting in the queue.
+     */
+    void reportQueueDepth(const Queue queue, const size_t bytes) {
+        updateMax(queueHighWater[static_cast<size_t>(queue)], bytes);
+    }
+
+    /**
+     * @brief Get the name of a subsystem, for reports.
+     * @param subsystem The subsystem.
+     * @return The subsystem name.
+     */
+    static const char *getName(const Subsystem subsystem) {
+        static constexpr const char *names[] = {
+                "reverbs", "analysis",        "analysis_queue",
+                "scope",   "process_buffers", "editor",
+                "flight_recorder"};
+        return names[static_cast<size_t>(subsystem)];
+    }
+
+    /**
+     * @brief Get the name of a queue, for reports.
+     * @param queue The queue.
+     * @return The queue name.
+     */
+    static const char *getName(const Queue queue) {
+        static constexpr const char *names[] = {"analysis_input", "scope"};
+        return names[static_cast<size_t>(queue)];
+    }
+
+    /**
+     * @brief Take a snapshot of all counters.
+     * @return The snapshot.
+     */
+    [[nodiscard]] Snapshot getSnapshot() const {
+        Snapshot snapshot;
+        for (size_t i = 0; i < numSubsystems; ++i) {
+            snapshot.current[i] = current[i].load();
+            snapshot.peak[i] = peak[i].load();
+        }
+        for (size_t i = 0; i < numQueues; ++i)
+            snapshot.queueHighWater[i] = queueHighWater[i].load();
+        snapshot.totalCurrent = totalCurrent.load();
+        snapshot.totalPeak = totalPeak.load();
+        return snapshot;
+    }
+
+private:
+    /** Bytes currently held by each subsystem. */
+    std::array<std::atomic<size_t>, numSubsystems> current{};
+
+    /** Peak bytes held by each subsystem. */
+    std::array<std::atomic<size_t>, numSubsystems> peak{};
+
+    /** High-water mark of each queue, in bytes. */
+    std::array<std::atomic<size_t>, numQueues> queueHighWater{};
+
+    /** Bytes currently held by all subsystems. */
+    std::atomic<size_t> totalCurrent{0};
+
+    /** Peak bytes held by all subsystems together. */
+    std::atomic<size_t> totalPeak{0};
+
+    /**
+     * @brief Raise an atomic to a value if it is currently lower.
+     * @param target The atomic to raise.
+     * @param value The candidate value.
+     */
+    static void updateMax(std::atomic<size_t> &target, const size_t value) {
+        size_t previous = target.load();
+        while (previous < value &&
+               !target.compare_exchange_weak(previous, value)) {
+        }
+    }
+};
+
+#endif // MEMORY_TRACKER_H
@@ -0,0 +1,62 @@
+#ifndef SAMPLE_SANITISER_H
+#define SAMPLE_SANITISER_H
+
+#include <cmath>
+
+/**
+ * @brief Helpers for keeping non-finite values out of the engine.
+ *
+ * A single NaN or infinity that reaches a reverb feedback loop or the
+ * clustering stays there forever, so everything entering the engine is checked
+ * at the boundary.
+ */
+namespace SampleSanitiser {
+    /**
+     * @brief Check if a block contains any NaN or infinite values.
+     *
+     * Multiplying by zero turns every finite value into zero and every
+     * non-finite value into NaN, so the sum is only finite if every sample is.
+     * A single running sum is a strict floating-point reduction the compiler
+     * may not reorder, so the samples are summed into independent lanes that
+     * it can vectorise without reassociation.
+     *
+     * @param data Pointer to the samples.
+     * @param numSamples Number of samples.
+     * @return True if every sample is finite, false otherwise.
+     */
+    inline bool isBlockFinite(const float *data, const int numSamples) {
+        constexpr int numLanes = 8;
+        float lanes[numLanes] = {};
+        int i = 0;
+        for (; i + numLanes <= numSamples; i += numLanes)
+            for (int lane = 0; lane < numLanes; ++lane)
+                lanes[lane] += data[i + lane] * 0.0f;
+        float accumulator = 0.0f;
+        for (; i < numSamples; ++i)
+            accumulator += data[i] * 0.0f;
+        for (const float lane: lanes)
+            accumulator += lane;
+        return accumulator == 0.0f;
+    }
+
+    /**
+     * @brief Replace NaN and infinite values with silence.
+     * @param data Pointer to the samples.
+     * @param numSamples Number of samples.
+     * @return The number of samples that were replaced.
+     */
+    inline int sanitise(float *data, const int numSamples) {
+        if (isBlockFinite(data, numSamples))
+            return 0;
+        int replaced = 0;
+        for (int i = 0; i < numSamples; ++i) {
+            if (!std::isfinite(data[i])) {
+                data[i] = 0.0f;
+                ++replaced;
+            }
+        }
+        return replaced;
+    }
+} // namespace SampleSanitiser
+
+#endif // SAMPLE_SANITISER_H
@@ -0,0 +1,49 @@
+#ifndef TASK_RUNNER_H
+#define TASK_RUNNER_H
+
+/**
+ * @brief Runs a batch of independent tasks on threads the plugin does not own,
+ * such as a host's real-time thread pool.
+ *
+ * The audio thread hands over a plain function and context, so running a batch
+ * never allocates. A runner may decline a batch, e.g. when the host has no
+ * worker free; run() then runs the tasks in order on the calling thread, which
+ * is also what happens when no runner is set.
+ */
+class TaskRunner {
+public:
+    /** A task: called once for each index of the batch */
+    using Task = void (*)(void *context, int index);
+
+    virtual ~TaskRunner() = default;
+
+    /**
+     * @brief Run every task of a batch, possibly in parallel, and return once
+     * all of them have run.
+     * @param numTasks Number of tasks.
+     * @param task The task, called with indices 0 to numTasks - 1.
+     * @param context Passed to every call of the task.
+     * @return True if the batch ran, false if it was declined and none of the
+     * tasks ran.
+     */
+    virtual bool runParallel(int numTasks, Task task, void *context) = 0;
+
+    /**
+     * @brief Run a batch on a runner if there is one and it accepts the
+     * batch, otherwise in order on the calling thread.
+     * @param runner The runner, or null.
+     * @param numTasks Number of tasks.
+     * @param task The task, called with indices 0 to numTasks - 1.
+     * @param context Passed to every call of the task.
+     */
+    static void run(TaskRunner *runner, const int numTasks, const Task task,
+                    void *context) {
+        if (runner != nullptr && numTasks > 1 &&
+            runner->runParallel(numTasks, task, context))
+            return;
+        for (int i = 0; i < numTasks; ++i)
+            task(context, i);
+    }
+};
+
+#endif // TASK_RUNNER_H
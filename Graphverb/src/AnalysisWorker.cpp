@@ -0,0 +1,764 @@
+#include "AnalysisWorker.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include "CommunityClustering.h"
+#include "SampleSanitiser.h"
+
+namespace {
+    /**
+     * @brief Get the time elapsed since a point, in microseconds.
+     * @param start The point.
+     * @return The elapsed time.
+     */
+    float
+    elapsedMicroseconds(const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<float, std::micro>(
+                       std::chrono::steady_clock::now() - start)
+                .count();
+    }
+} // namespace
+
+/**
+ * @brief Constructor for the AnalysisWorker.
+ * @param config The initial analysis settings.
+ */
+AnalysisWorker::AnalysisWorker(const AnalysisConfig &config) {
+    setConfig(config);
+    updateMemoryBytes();
+}
+
+/**
+ * @brief Destructor for the AnalysisWorker. Stops the thread if running.
+ */
+AnalysisWorker::~AnalysisWorker() {
+    stop();
+    stopCapture();
+}
+
+/**
+ * @brief Start the analysis thread, or change its sample rate if it is
+ * already running.
+ * @param sampleRate The sample rate of the incoming audio.
+ */
+void AnalysisWorker::start(const double sampleRate) {
+    std::lock_guard lock(lifecycleMutex);
+    currentSampleRate.store(sampleRate);
+    /// Hot reconfiguration: keep the thread, the ring and the clusters
+    if (running.load())
+        return;
+    if (!inputRing.isAllocated())
+        inputRing.allocate(inputRingCapacity);
+    /// The thread is not running, so this thread may act as the analyser
+    acquireConfig();
+    ensureAnalyzer();
+    spectralAnalyzer->reset();
+    samplesAnalysed = 0;
+    threadShouldExit = false;
+    running = true;
+    thread = std::thread([this] { run(); });
+}
+
+/**
+ * @brief Stop the analysis thread and drop any pending input.
+ */
+void AnalysisWorker::stop() {
+    std::lock_guard lock(lifecycleMutex);
+    stopLocked();
+}
+
+/**
+ * @brief Stop the analysis thread. The lifecycle mutex must be held.
+ */
+void AnalysisWorker::stopLocked() {
+    threadShouldExit = true;
+    if (thread.joinable())
+        thread.join();
+    running = false;
+    inputRing.discard();
+}
+
+/**
+ * @brief Publish new analysis settings.
+ * @param config The new analysis settings.
+ */
+void AnalysisWorker::setConfig(const AnalysisConfig &config) {
+    std::lock_guard lock(configMutex);
+    auto published = std::make_unique<const AnalysisConfig>(config);
+    publishedConfig.store(published.get());
+    beatSubdivisions.store(config.beatSubdivisions, std::memory_order_relaxed);
+    configs.push_back(std::move(published));
+    /// Free whatever the analysing thread has moved past
+    const AnalysisConfig *latest = publishedConfig.load();
+    const AnalysisConfig *inUse = configInUse.load();
+    std::erase_if(configs, [&](const auto &candidate) {
+        return candidate.get() != latest && candidate.get() != inUse;
+    });
+}
+
+/**
+ * @brief Start capturing every analysed frame to a file, replacing any capture
+ * in progress.
+ * @param file The capture file, replaced if it exists.
+ * @param seconds Length of audio the file has room for.
+ * @return True if the capture started.
+ */
+bool AnalysisWorker::startCapture(const juce::File &file,
+                                  const double seconds) {
+    std::lock_guard lock(captureMutex);
+    captureRequested.store(false);
+    return startCaptureLocked(file, seconds);
+}
+
+/**
+ * @brief Ask the analysis thread to start a capture between frames.
+ * @param file The capture file, replaced if it exists.
+ * @param seconds Length of audio the file has room for.
+ */
+void AnalysisWorker::requestCapture(const juce::File &file,
+                                    const double seconds) {
+    std::lock_guard lock(captureMutex);
+    requestedCaptureFile = file;
+    requestedCaptureSeconds = seconds;
+    captureRequested.store(true);
+}
+
+/**
+ * @brief Stop capturing and close the capture file, or drop a requested
+ * capture.
+ */
+void AnalysisWorker::stopCapture() {
+    std::lock_guard lock(captureMutex);
+    captureRequested.store(false);
+    stopCaptureLocked();
+}
+
+/**
+ * @brief Start a capture. The capture mutex must be held.
+ *
+ * The file has room for one frame per hop over the given length; a reduced
+ * frame rate only leaves part of it unused.
+ *
+ * @param file The capture file, replaced if it exists.
+ * @param seconds Length of audio the file has room for.
+ * @return True if the capture started.
+ */
+bool AnalysisWorker::startCaptureLocked(const juce::File &file,
+                                        const double seconds) {
+    stopCaptureLocked();
+    const AnalysisConfig config = getConfig();
+    const double sampleRate = currentSampleRate.load();
+    const auto maxFrames = static_cast<uint64_t>(std::ceil(
+            seconds * (sampleRate > 0.0 ? sampleRate : 48000.0) /
+            config.hopSize));
+    captureWriter = AnalysisCaptureWriter::create(
+            file, config.getFftSize() / 2, config.numClusters, maxFrames);
+    capture.store(captureWriter.get());
+    return captureWriter != nullptr;
+}
+
+/**
+ * @brief Start the capture asked for with requestCapture(), if any.
+ */
+void AnalysisWorker::startRequestedCapture() {
+    if (!captureRequested.load(std::memory_order_relaxed))
+        return;
+    std::lock_guard lock(captureMutex);
+    /// Dropped by stopCapture() or replaced by startCapture() meanwhile
+    if (!captureRequested.exchange(false))
+        return;
+    /// Nobody waits on the result, so count it for getNumFailedCaptures()
+    if (!startCaptureLocked(requestedCaptureFile, requestedCaptureSeconds))
+        failedCaptures.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Stop capturing. The capture mutex must be held.
+ */
+void AnalysisWorker::stopCaptureLocked() {
+    /// Wait out an append in progress; it takes microseconds
+    if (const AnalysisCaptureWriter *writer = capture.exchange(nullptr))
+        while (captureInUse.load() == writer)
+            std::this_thread::yield();
+    captureWriter.reset();
+}
+
+/**
+ * @brief Append a frame to the capture in progress, if any.
+ * @param frame The frame.
+ */
+void AnalysisWorker::captureFrame(const AnalysisCaptureWriter::Frame &frame) {
+    AnalysisCaptureWriter *writer = capture.load();
+    if (writer == nullptr)
+        return;
+    /// Mark it, then check it was not stopped in between
+    captureInUse.store(writer);
+    if (writer == capture.load())
+        writer->append(frame);
+    captureInUse.store(nullptr);
+}
+
+/**
+ * @brief Get the latest published analysis settings.
+ * @return A copy of the settings.
+ */
+AnalysisConfig AnalysisWorker::getConfig() {
+    std::lock_guard lock(configMutex);
+    return *publishedConfig.load();
+}
+
+/**
+ * @brief Switch to the latest published configuration, if it changed.
+ */
+void AnalysisWorker::acquireConfig() {
+    if (publishedConfig.load() == activeConfig)
+        return;
+    /// Copy the outgoing settings while the in-use mark still protects them
+    const std::optional<AnalysisConfig> previous =
+            activeConfig != nullptr ? std::optional(*activeConfig)
+                                    : std::nullopt;
+    const AnalysisConfig *latest;
+    do {
+        latest = publishedConfig.load();
+        configInUse.store(latest);
+    } while (latest != publishedConfig.load());
+    activeConfig = latest;
+    if (!previous)
+        return;
+    if (previous->fftOrder != latest->fftOrder ||
+        previous->hopSize != latest->hopSize)
+        spectralAnalyzer.reset();
+    if (!latest->separateHarmonicPercussive)
+        separator.reset();
+    if (previous->numClusters != latest->numClusters ||
+        previous->separateHarmonicPercussive !=
+                latest->separateHarmonicPercussive)
+        centroids.clear();
+}
+
+/**
+ * @brief Push a block for analysis, downmixing its channels to mono on the
+ * way into the queue.
+ * @param channels Pointers to the channels.
+ * @param numChannels Number of channels.
+ * @param startSample The first sample to read from each channel.
+ * @param numSamples Number of samples.
+ * @return True if the block was queued, false if it was dropped.
+ */
+bool AnalysisWorker::push(const float *const *channels, const int numChannels,
+                          const int startSample, const int numSamples) {
+    if (!running.load())
+        return false;
+    return inputRing.write(channels, numChannels, startSample, numSamples);
+}
+
+/**
+ * @brief Copy the latest published cluster energies.
+ *
+ * Like fetchAssignments(), the copy is checked against the slot's sequence
+ * and retried from the newest slot if a writer overtook it. It is staged on
+ * the stack, so out is left untouched unless a whole publication was read.
+ *
+ * @param out The vector to store the energies in.
+ * @param publication If not null, receives the number of the publication the
+ * energies were copied from.
+ * @return True if energies have been published and copied whole, false
+ * otherwise.
+ */
+bool AnalysisWorker::fetchEnergies(std::vector<float> &out,
+                                   uint64_t *publication) const {
+    constexpr int maxAttempts = 4;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        const PublicationSlot &slot = publicationSlots[
+                publications.load(std::memory_order_acquire) & 1];
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before % 2 != 0)
+            continue;
+        const size_t numClusters =
+                slot.numClusters.load(std::memory_order_relaxed);
+        if (numClusters == 0)
+            return false;
+        std::array<float, maxPublishedClusters> energies;
+        for (size_t i = 0; i < numClusters; ++i)
+            energies[i] = slot.energies[i].load(std::memory_order_relaxed);
+        const uint64_t number =
+                slot.publication.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) != before)
+            continue;
+        out.assign(energies.begin(), energies.begin() + numClusters);
+        if (publication != nullptr)
+            *publication = number;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Copy the cluster of each frequency bin from the latest publication.
+ *
+ * The publications alternate between two slots, so the copy only races a
+ * writer if two more frames are published while it runs; the slot's
+ * sequence catches that, and the copy is retried from the newest slot.
+ *
+ * @param out The vector to store the assignments in.
+ * @return True if assignments have been published and copied whole, false
+ * otherwise.
+ */
+bool AnalysisWorker::fetchAssignments(std::vector<uint8_t> &out) const {
+    constexpr int maxAttempts = 4;
+    for (int attempt = 0; attempt < maxAttempts; ++attempt) {
+        const PublicationSlot &slot = publicationSlots[
+                publications.load(std::memory_order_acquire) & 1];
+        const uint64_t before = slot.sequence.load(std::memory_order_acquire);
+        if (before % 2 != 0)
+            continue;
+        const size_t numBins = slot.numBins.load(std::memory_order_relaxed);
+        if (numBins == 0)
+            return false;
+        out.resize(numBins);
+        for (size_t w = 0; w < (numBins + 7) / 8; ++w) {
+            const uint64_t word = slot.words[w].load(std::memory_order_relaxed);
+            std::memcpy(out.data() + 8 * w, &word,
+                        std::min<size_t>(8, numBins - 8 * w));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == before)
+            return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Publish publishedState's energies and assignments with the next
+ * publication number, into the slot the current one does not use.
+ */
+void AnalysisWorker::publishLocked() {
+    const uint64_t publication =
+            publications.load(std::memory_order_relaxed) + 1;
+    PublicationSlot &slot = publicationSlots[publication & 1];
+    const size_t numClusters =
+            std::min(publishedState.energies.size(), maxPublishedClusters);
+    const size_t numBins =
+            std::min(publishedState.assignments.size(), maxAssignmentBins);
+    const uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.publication.store(publication, std::memory_order_relaxed);
+    slot.numClusters.store(static_cast<uint32_t>(numClusters),
+                           std::memory_order_relaxed);
+    for (size_t i = 0; i < numClusters; ++i)
+        slot.energies[i].store(publishedState.energies[i],
+                               std::memory_order_relaxed);
+    slot.numBins.store(static_cast<uint32_t>(numBins),
+                       std::memory_order_relaxed);
+    for (size_t w = 0; w < (numBins + 7) / 8; ++w) {
+        uint64_t word = 0;
+        std::memcpy(&word, publishedState.assignments.data() + 8 * w,
+                    std::min<size_t>(8, numBins - 8 * w));
+        slot.words[w].store(word, std::memory_order_relaxed);
+    }
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    publications.store(publication, std::memory_order_release);
+}
+
+/**
+ * @brief Get a copy of the latest published cluster energies.
+ * @return The latest cluster energies, or an empty vector.
+ */
+std::vector<float> AnalysisWorker::getEnergies() {
+    std::lock_guard lock(energyMutex);
+    return publishedState.energies;
+}
+
+/**
+ * @brief Take a snapshot of the latest published analysis state.
+ * @return The snapshot; empty if no frame has been analysed or restored.
+ */
+AnalysisSnapshot AnalysisWorker::getSnapshot() {
+    std::lock_guard lock(energyMutex);
+    return publishedState;
+}
+
+/**
+ * @brief Restore the analysis state from a snapshot.
+ * @param snapshot The snapshot to restore.
+ * @return True if the snapshot was restored.
+ */
+bool AnalysisWorker::restoreSnapshot(const AnalysisSnapshot &snapshot) {
+    if (static_cast<int>(snapshot.centroids.size()) != getNumClusters())
+        return false;
+    AnalysisSnapshot restored = snapshot;
+    std::lock_guard lock(energyMutex);
+    std::swap(publishedState, restored);
+    publishLocked();
+    restorePending.store(true, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Main loop of the analysis thread.
+ */
+void AnalysisWorker::run() {
+    /// FTZ/DAZ for the whole thread: decaying inputs would otherwise hit the
+    /// denormal slow paths in the FFT, exp() and log10().
+    juce::ScopedNoDenormals noDenormals;
+    std::vector<float> inputBuffer;
+    /// Samples read towards the next frame
+    int gathered = 0;
+    while (!threadShouldExit.load()) {
+        /// Dumps are written here, where a file write only delays analysis
+        if (flightRecorder != nullptr)
+            flightRecorder->dumpIfRequested();
+        /// Captures asked for in prepareToPlay() are created here, off the
+        /// host's thread
+        startRequestedCapture();
+        /// Rendered a slice at a time, so the analysis falls behind by at
+        /// most a slice
+        if (impulseCapture != nullptr)
+            impulseCapture->renderIfRequested();
+        /// Kernels first prepared on this machine are tuned here, once per
+        /// process, rather than in prepareToPlay()
+        KernelAutotuner::tuneIfPending();
+        adoptTunedKernels();
+        /// One hop at a time, so the graph and clustering run once per new
+        /// frame; at a reduced rate, several hops and at least a whole frame
+        acquireConfig();
+        const int hopSize = activeConfig->hopSize;
+        const int fftSize = activeConfig->getFftSize();
+        const int decimation = frameDecimation.load(std::memory_order_relaxed);
+        const bool reduced = decimation > 1;
+        const int stride = reduced ? std::max(hopSize * decimation, fftSize)
+                                   : hopSize;
+        if (const auto needed = static_cast<size_t>(std::max(stride, gathered));
+            inputBuffer.size() < needed)
+            inputBuffer.resize(needed);
+        if (gathered < stride) {
+            const int numSamples = inputRing.read(inputBuffer.data() + gathered,
+                                                  stride - gathered);
+            if (numSamples == 0) {
+                /// avoid busy loop
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                continue;
+            }
+            gathered += numSamples;
+        }
+        const double sampleRate =
+                currentSampleRate.load(std::memory_order_relaxed);
+        if (!reduced) {
+            analyseBlock(inputBuffer.data(), gathered, sampleRate);
+            gathered = 0;
+        } else if (gathered >= stride) {
+            /// Analyse the newest frame from scratch and skip the rest; the
+            /// analyzer is left holding the samples the next hop follows on
+            const int skipped = gathered - fftSize;
+            samplesAnalysed += static_cast<uint64_t>(skipped);
+            ensureAnalyzer();
+            spectralAnalyzer->reset();
+            analyseBlock(inputBuffer.data() + skipped, fftSize, sampleRate);
+            gathered = 0;
+        }
+    }
+}
+
+/**
+ * @brief Run one analysis step synchronously on the caller's thread.
+ * @param samples Pointer to the mono samples.
+ * @param numSamples Number of samples.
+ * @param sampleRate The sample rate of the samples.
+ */
+void AnalysisWorker::analyseBlock(const float *samples, const int numSamples,
+                                  const double sampleRate) {
+    acquireConfig();
+    ensureAnalyzer();
+    const auto start = std::chrono::steady_clock::now();
+    spectralAnalyzer->pushSamples(samples, numSamples, getKernels());
+    samplesAnalysed += static_cast<uint64_t>(numSamples);
+    stageMicroseconds[AnalysisCapture::spectral] = elapsedMicroseconds(start);
+    analyseLatestFrame(sampleRate);
+}
+
+/**
+ * @brief Run the graph and clustering stages on the latest magnitudes.
+ * @param sampleRate The sample rate of the incoming audio.
+ */
+void AnalysisWorker::analyseLatestFrame(const double sampleRate) {
+    /// Run spectral + graph + clustering
+    const auto &magnitudes = spectralAnalyzer->getLatestMagnitudes();
+    /// No frame yet: keep whatever is published, e.g. a restored snapshot
+    if (magnitudes.empty())
+        return;
+    /// A non-finite frame would poison the clustering and, through the
+    /// energies, the reverb feedback loops, so drop it.
+    if (!SampleSanitiser::isBlockFinite(magnitudes.data(),
+                                        static_cast<int>(magnitudes.size()))) {
+        nonFiniteFrames.fetch_add(1, std::memory_order_relaxed);
+        spectralAnalyzer->reset();
+        if (separator != nullptr)
+            separator->reset();
+        return;
+    }
+    uint32_t flags = 0;
+    if (restorePending.exchange(false, std::memory_order_acquire)) {
+        std::lock_guard lock(energyMutex);
+        centroids = publishedState.centroids;
+        flags |= AnalysisCapture::restored;
+    }
+    const AnalysisConfig &config = *activeConfig;
+    const int numClusters = config.numClusters;
+    const bool recluster = isReclusterDue();
+    if (!recluster)
+        flags |= AnalysisCapture::incremental;
+    stageMicroseconds[AnalysisCapture::graph] = 0.0f;
+    stageMicroseconds[AnalysisCapture::clustering] = 0.0f;
+    int iterations = 0;
+    std::vector newEnergies(numClusters, 0.0f);
+    std::vector clusterCounts(numClusters, 0);
+    std::vector<Centroid> nextCentroids;
+    nextCentroids.reserve(static_cast<size_t>(numClusters));
+    std::vector<int> clusterAssignments;
+    if (config.separateHarmonicPercussive) {
+        const auto start = std::chrono::steady_clock::now();
+        const int numBins = static_cast<int>(magnitudes.size());
+        if (separator == nullptr || separator->getNumBins() != numBins)
+            separator = std::make_unique<HarmonicPercussiveSeparator>(numBins);
+        separator->process(magnitudes);
+        stageMicroseconds[AnalysisCapture::spectral] +=
+                elapsedMicroseconds(start);
+        /// Tonal partials and transients get clusters of their own, so a
+        /// drum hit does not pull a sustained note's cluster around
+        const int harmonicClusters = (numClusters + 1) / 2;
+        const auto &harmonic = separator->getHarmonic();
+        const auto &percussive = separator->getPercussive();
+        const std::vector<int> harmonicAssignments = clusterSpectrum(
+                harmonic, sampleRate, 0, harmonicClusters, newEnergies,
+                clusterCounts, nextCentroids, iterations, recluster);
+        const std::vector<int> percussiveAssignments = clusterSpectrum(
+                percussive, sampleRate, harmonicClusters,
+                numClusters - harmonicClusters, newEnergies, clusterCounts,
+                nextCentroids, iterations, recluster);
+        /// Report each bin in the cluster of its stronger component
+        clusterAssignments.resize(static_cast<size_t>(numBins));
+        for (int k = 0; k < numBins; ++k)
+            clusterAssignments[k] =
+                    percussiveAssignments.empty() ||
+                                    harmonic[k] >= percussive[k]
+                            ? harmonicAssignments[k]
+                            : harmonicClusters + percussiveAssignments[k];
+    } else {
+        clusterAssignments = clusterSpectrum(magnitudes, sampleRate, 0,
+                                             numClusters, newEnergies,
+                                             clusterCounts, nextCentroids,
+                                             iterations, recluster);
+    }
+    centroids = std::move(nextCentroids);
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numClusters; ++i)
+        newEnergies[i] = clusterCounts[i] > 0
+                                 ? (newEnergies[i] /
+                                    static_cast<float>(clusterCounts[i]))
+                                 : 0.0f;
+    /// Normalize
+    if (const float energySum =
+                std::accumulate(newEnergies.begin(), newEnergies.end(), 0.0f);
+        energySum > 0.0f) {
+        for (float &e: newEnergies)
+            e /= energySum;
+    }
+    /// Build the next state outside the lock, reusing the storage of the
+    /// one it replaces, and only swap it in and publish it under the lock
+    nextState.energies.assign(newEnergies.begin(), newEnergies.end());
+    nextState.centroids = centroids;
+    nextState.assignments.assign(clusterAssignments.begin(),
+                                 clusterAssignments.end());
+    {
+        std::lock_guard lock(energyMutex);
+        std::swap(publishedState, nextState);
+        publishLocked();
+    }
+    updateMemoryBytes();
+    stageMicroseconds[AnalysisCapture::publish] = elapsedMicroseconds(start);
+
+    AnalysisCaptureWriter::Frame frame;
+    frame.samplePosition = samplesAnalysed;
+    frame.sampleRate = sampleRate;
+    frame.fftSize = config.getFftSize();
+    frame.hopSize = config.hopSize;
+    frame.magnitudes = magnitudes.data();
+    frame.numBins = static_cast<int>(magnitudes.size());
+    frame.assignments = clusterAssignments.data();
+    frame.centroids = centroids.data();
+    frame.energies = newEnergies.data();
+    frame.numClusters = numClusters;
+    frame.iterations = iterations;
+    frame.flags = flags;
+    frame.stageMicroseconds = stageMicroseconds;
+    captureFrame(frame);
+
+    if (flightRecorder != nullptr) {
+        FlightRecorder::FrameRecord record{};
+        record.timeNs = FlightRecorder::now();
+        record.samplePosition = samplesAnalysed;
+        std::copy_n(stageMicroseconds, AnalysisCapture::numStages,
+                    record.stageMicroseconds);
+        record.iterations = static_cast<uint32_t>(iterations);
+        record.queuedSamples =
+                static_cast<uint32_t>(inputRing.getQueuedBytes() /
+                                      sizeof(float));
+        record.numClusters = static_cast<uint16_t>(numClusters);
+        record.flags = static_cast<uint16_t>(flags);
+        flightRecorder->recordFrame(record);
+    }
+}
+
+/**
+ * @brief Check if the frame being analysed should be re-clustered fully,
+ * consuming the grid lines it reached.
+ *
+ * Without a grid, or without centroids to keep, every frame is re-clustered.
+ * The lines reached are consumed either way, so none is left over for later.
+ *
+ * @return False if the frame should only reassign the bins.
+ */
+bool AnalysisWorker::isReclusterDue() {
+    const uint64_t position = inputRing.getReadPosition();
+    const uint64_t marked = gridLinesMarked.load(std::memory_order_acquire);
+    uint64_t reached = gridLinesReached.load(std::memory_order_relaxed);
+    const uint64_t firstPending = reached;
+    while (reached != marked &&
+           gridLines[reached % maxPendingGridLines].load(
+                   std::memory_order_relaxed) <= position)
+        ++reached;
+    /// Frees the slots for the audio thread to mark further lines in
+    gridLinesReached.store(reached, std::memory_order_release);
+    if (activeConfig->beatSubdivisions <= 0 ||
+        !gridSynced.load(std::memory_order_relaxed) ||
+        centroids.size() != static_cast<size_t>(activeConfig->numClusters))
+        return true;
+    return reached != firstPending;
+}
+
+/**
+ * @brief Build the graph of a spectrum and cluster it into a range of the
+ * clusters, starting from the previous frame's centroids for that range.
+ * @param magnitudes The spectrum, one magnitude per bin.
+ * @param sampleRate The sample rate of the incoming audio.
+ * @param firstCluster The first cluster of the range.
+ * @param count Number of clusters in the range.
+ * @param energySums Receives the sum of the magnitudes in each cluster.
+ * @param counts Receives the number of bins in each cluster.
+ * @param nextCentroids Receives the range's centroids, appended.
+ * @param iterations Receives the k-means iterations run, added.
+ * @param recluster False to keep the previous centroids and only reassign the
+ * bins to them.
+ * @return The cluster of each bin within the range, or empty if the range is
+ * empty.
+ */
+std::vector<int> AnalysisWorker::clusterSpectrum(
+        const std::vector<float> &magnitudes, const double sampleRate,
+        const int firstCluster, const int count,
+        std::vector<float> &energySums, std::vector<int> &counts,
+        std::vector<Centroid> &nextCentroids, int &iterations,
+        const bool recluster) {
+    if (count <= 0)
+        return {};
+    auto start = std::chrono::steady_clock::now();
+    spectralGraph.buildGraph(magnitudes, static_cast<float>(sampleRate),
+                             activeConfig->getFftSize());
+    stageMicroseconds[AnalysisCapture::graph] += elapsedMicroseconds(start);
+    /// Start from the previous frame's centroids, so the clustering
+    /// converges quickly and cluster indices stay stable
+    start = std::chrono::steady_clock::now();
+    std::vector<Centroid> rangeCentroids;
+    if (centroids.size() == static_cast<size_t>(activeConfig->numClusters))
+        rangeCentroids.assign(centroids.begin() + firstCluster,
+                              centroids.begin() + firstCluster + count);
+    int rangeIterations = 0;
+    std::vector<int> assignments =
+            recluster ? CommunityClustering::clusterNodes(
+                                spectralGraph.nodes, rangeCentroids, count,
+                                activeConfig->maxIterations, &rangeIterations,
+                                getKernels())
+                      : CommunityClustering::assignNodes(
+                                spectralGraph.nodes, rangeCentroids,
+                                getKernels());
+    stageMicroseconds[AnalysisCapture::clustering] +=
+            elapsedMicroseconds(start);
+    iterations += rangeIterations;
+    nextCentroids.insert(nextCentroids.end(), rangeCentroids.begin(),
+                         rangeCentroids.end());
+    for (size_t i = 0; i < spectralGraph.nodes.size(); ++i) {
+        const int cluster = firstCluster + assignments[i];
+        energySums[cluster] += spectralGraph.nodes[i].magnitude;
+        counts[cluster]++;
+    }
+    return assignments;
+}
+
+/**
+ * @brief Pick this instance's kernels for a configuration.
+ * @param config The configuration.
+ */
+void AnalysisWorker::prepareKernels(const KernelAutotuner::Config &config) {
+    const Kernels::Table *table = KernelAutotuner::prepare(config);
+    std::lock_guard lock(kernelMutex);
+    if (table != nullptr) {
+        kernels.store(table, std::memory_order_release);
+        kernelsPending.store(false, std::memory_order_release);
+    } else if (!Kernels::isForced()) {
+        /// Queued; the current kernels stay until adoptTunedKernels()
+        pendingKernelConfig = config;
+        kernelsPending.store(true, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Switch to the pending configuration's kernels once they have been
+ * tuned, by this instance's thread or another's.
+ */
+void AnalysisWorker::adoptTunedKernels() {
+    if (!kernelsPending.load(std::memory_order_acquire))
+        return;
+    std::lock_guard lock(kernelMutex);
+    if (const Kernels::Table *table =
+                KernelAutotuner::find(pendingKernelConfig)) {
+        kernels.store(table, std::memory_order_release);
+        kernelsPending.store(false, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Build the spectral analyzer if it has not been built yet.
+ */
+void AnalysisWorker::ensureAnalyzer() {
+    if (spectralAnalyzer == nullptr) {
+        spectralAnalyzer = std::make_unique<SpectralAnalyzer>(
+                activeConfig->fftOrder, activeConfig->hopSize);
+        updateMemoryBytes();
+    }
+}
+
+/**
+ * @brief Recompute the bytes held by the analysis state.
+ */
+void AnalysisWorker::updateMemoryBytes() {
+    const size_t bytes = sizeof(AnalysisWorker) +
+                         (spectralAnalyzer != nullptr
+                                  ? spectralAnalyzer->getMemoryBytes()
+                                  : 0) +
+                         spectralGraph.getMemoryBytes() +
+                         (separator != nullptr ? separator->getMemoryBytes()
+                                               : 0) +
+                         centroids.capacity() * sizeof(Centroid) +
+                         /// The published state mirrors the next one
+                         2 * (nextState.centroids.capacity() *
+                                      sizeof(Centroid) +
+                              nextState.energies.capacity() * sizeof(float) +
+                              nextState.assignments.capacity());
+    memoryBytes.store(bytes, std::memory_order_relaxed);
+}
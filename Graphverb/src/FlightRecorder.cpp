@@ -0,0 +1,221 @@
+#include "FlightRecorder.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace {
+    /**
+     * @brief Get the name of a trigger, as written in dumps.
+     * @param trigger The trigger.
+     * @return The name.
+     */
+    const char *getTriggerName(const FlightRecorder::Trigger trigger) {
+        switch (trigger) {
+            case FlightRecorder::Trigger::deadline:
+                return "deadline";
+            case FlightRecorder::Trigger::backlog:
+                return "backlog";
+            case FlightRecorder::Trigger::manual:
+                return "manual";
+            default:
+                return "none";
+        }
+    }
+} // namespace
+
+/**
+ * @brief Allocate the rings. Later calls do nothing.
+ * @param numBlocks Number of block records kept.
+ * @param numFrames Number of frame records kept.
+ */
+void FlightRecorder::allocate(const size_t numBlocks, const size_t numFrames) {
+    if (!blocks.isAllocated())
+        blocks.allocate(numBlocks);
+    if (!frames.isAllocated())
+        frames.allocate(numFrames);
+}
+
+/**
+ * @brief Append a block record and check it against the thresholds.
+ * @param record The record.
+ */
+void FlightRecorder::recordBlock(const BlockRecord &record) {
+    blocks.write(record);
+    if (blocks.getNumWritten() <= armedFrom.load(std::memory_order_relaxed))
+        return;
+    if (record.durationUs >
+        record.budgetUs * deadlineThreshold.load(std::memory_order_relaxed))
+        requestDump(Trigger::deadline);
+    else if (record.queuedSamples >
+             backlogThreshold.load(std::memory_order_relaxed))
+        requestDump(Trigger::backlog);
+}
+
+/**
+ * @brief Ask for a dump.
+ * @param reason Why.
+ */
+void FlightRecorder::requestDump(const Trigger reason) {
+    int expected = static_cast<int>(Trigger::none);
+    if (pendingTrigger.compare_exchange_strong(expected,
+                                               static_cast<int>(reason)))
+        triggerTimeNs.store(now(), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Set where dumps are written.
+ * @param directoryIn The directory, or a default File for nowhere.
+ */
+void FlightRecorder::setDirectory(const juce::File &directoryIn) {
+    std::lock_guard lock(dumpMutex);
+    directory = directoryIn;
+}
+
+/**
+ * @brief Write the requested dump, if any and if the last one was long enough
+ * ago.
+ * @return The file written, or a default File.
+ */
+juce::File FlightRecorder::dumpIfRequested() {
+    if (pendingTrigger.load(std::memory_order_relaxed) ==
+        static_cast<int>(Trigger::none))
+        return {};
+    std::lock_guard lock(dumpMutex);
+    const uint64_t requestedNs = triggerTimeNs.load(std::memory_order_relaxed);
+    const auto reason = static_cast<Trigger>(pendingTrigger.exchange(
+            static_cast<int>(Trigger::none)));
+    if (lastDumpMs != 0 &&
+        juce::Time::currentTimeMillis() - lastDumpMs < minDumpIntervalMs) {
+        numSuppressed.fetch_add(1, std::memory_order_relaxed);
+        return {};
+    }
+    return dumpLocked(reason, requestedNs);
+}
+
+/**
+ * @brief Write a dump now.
+ * @param reason Why, recorded in the file.
+ * @return The file written, or a default File if it could not be.
+ */
+juce::File FlightRecorder::dump(const Trigger reason) {
+    std::lock_guard lock(dumpMutex);
+    return dumpLocked(reason, now());
+}
+
+/**
+ * @brief Write a dump. dumpMutex must be held.
+ *
+ * The file is plain text: a few header lines, then the block and frame
+ * records as comma-separated sections, oldest first, with times relative to
+ * the request.
+ *
+ * @param reason Why.
+ * @param requestedNs Steady clock when the dump was requested.
+ * @return The file written, or a default File.
+ */
+juce::File FlightRecorder::dumpLocked(const Trigger reason,
+                                      const uint64_t requestedNs) {
+    if (directory == juce::File() || directory.createDirectory().failed())
+        return {};
+    const juce::File file = directory.getChildFile(
+            "graphverb-trace-" +
+            juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + "-" +
+            juce::String::toHexString(
+                    juce::Random::getSystemRandom().nextInt()) +
+            ".txt");
+    juce::FileOutputStream out(file);
+    if (out.failedToOpen())
+        return {};
+    lastDumpMs = juce::Time::currentTimeMillis();
+    const auto relative = [requestedNs](const uint64_t timeNs) {
+        return juce::String(static_cast<double>(static_cast<int64_t>(
+                                    timeNs - requestedNs)) *
+                                    1.0e-3,
+                            1);
+    };
+
+    const std::vector<BlockRecord> blockRecords = blocks.read();
+    const std::vector<FrameRecord> frameRecords = frames.read();
+    out << "# Graphverb flight recorder\n"
+        << "# reason: " << getTriggerName(reason) << "\n"
+        << "# written: " << juce::Time::getCurrentTime().toISO8601(true)
+        << "\n"
+        << "# times are in microseconds relative to the trigger\n"
+        << "[blocks]\n"
+        << "time_us,duration_us,budget_us,samples,queued_samples,"
+           "active_voices,flags\n";
+    for (const BlockRecord &record: blockRecords)
+        out << relative(record.timeNs) << ","
+            << juce::String(record.durationUs, 1) << ","
+            << juce::String(record.budgetUs, 1) << ","
+            << static_cast<int>(record.numSamples) << ","
+            << static_cast<int>(record.queuedSamples) << ","
+            << record.activeVoices << "," << record.flags << "\n";
+    out << "[frames]\n"
+        << "time_us,sample_position,spectral_us,graph_us,clustering_us,"
+           "publish_us,iterations,queued_samples,clusters,flags\n";
+    for (const FrameRecord &record: frameRecords) {
+        out << relative(record.timeNs) << ","
+            << static_cast<juce::int64>(record.samplePosition);
+        for (const float stage: record.stageMicroseconds)
+            out << "," << juce::String(stage, 1);
+        out << "," << static_cast<int>(record.iterations) << ","
+            << static_cast<int>(record.queuedSamples) << ","
+            << record.numClusters << "," << record.flags << "\n";
+    }
+    out.flush();
+    if (out.getStatus().failed())
+        return {};
+    numDumps.fetch_add(1, std::memory_order_relaxed);
+    pruneLocked();
+    return file;
+}
+
+/**
+ * @brief Delete all but the newest maxDumps dumps in the directory.
+ *
+ * Only files named like a dump are touched, whichever instance wrote them, so
+ * the directory stays bounded however many instances share it.
+ */
+void FlightRecorder::pruneLocked() const {
+    juce::Array<juce::File> dumps = directory.findChildFiles(
+            juce::File::findFiles, false, "graphverb-trace-*.txt");
+    if (dumps.size() <= maxDumps)
+        return;
+    std::sort(dumps.begin(), dumps.end(),
+              [](const juce::File &a, const juce::File &b) {
+                  return a.getLastModificationTime() >
+                         b.getLastModificationTime();
+              });
+    for (int i = maxDumps; i < dumps.size(); ++i)
+        dumps.getReference(i).deleteFile();
+}
+
+/**
+ * @brief Get the steady clock, as stored in the records.
+ * @return The time in nanoseconds.
+ */
+uint64_t FlightRecorder::now() {
+    return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                    .count());
+}
+
+/**
+ * @brief Get the directory dumps go to by default.
+ *
+ * Dumping is opt-in: a host machine should not fill up with traces nobody
+ * asked for.
+ *
+ * @return The directory, or a default File.
+ */
+juce::File FlightRecorder::getDefaultDirectory() {
+    const juce::String traceDirectory =
+            juce::SystemStats::getEnvironmentVariable("GRAPHVERB_TRACE_DIR",
+                                                      {});
+    if (traceDirectory.isEmpty() ||
+        !juce::File::isAbsolutePath(traceDirectory))
+        return {};
+    return juce::File(traceDirectory);
+}
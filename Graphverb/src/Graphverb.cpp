@@ -1,5 +1,64 @@
 #include "Graphverb.h"
 #include "GraphverbEditor.h"
+#include "Kernels.h"
+#include "SampleSanitiser.h"
+
+namespace {
+    /**
+     * @brief What the reverb voice tasks of one block share.
+     */
+    struct VoiceJob {
+        /** The processing state holding the reverbs and voice buffers */
+        DspState *state;
+        /** The dry signal */
+        const juce::AudioBuffer<float> *dry;
+    };
+
+    /**
+     * @brief Render one reverb voice into its own buffer. May run on any
+     * thread, concurrently with the other voices.
+     * @param context The VoiceJob.
+     * @param index Index of the reverb.
+     */
+    void renderVoice(void *context, const int index) {
+        juce::ScopedNoDenormals noDenormals;
+        const auto &job = *static_cast<const VoiceJob *>(context);
+        const auto voiceIndex = static_cast<size_t>(index);
+        const int numChannels = job.dry->getNumChannels();
+        const int numSamples = job.dry->getNumSamples();
+        juce::AudioBuffer<float> voice(
+                job.state->voiceBuffers[voiceIndex].getArrayOfWritePointers(),
+                numChannels, numSamples);
+        for (int ch = 0; ch < numChannels; ++ch)
+            voice.copyFrom(ch, 0, *job.dry, ch, 0, numSamples);
+        job.state->reverbs[voiceIndex]->processBlock(voice);
+    }
+
+    /**
+     * @brief What the modal channel tasks of one block share.
+     */
+    struct ModalJob {
+        /** The modal bank, prepared for the block */
+        ModalReverb *modes;
+        /** The wet signal, one channel per task */
+        juce::AudioBuffer<float> *wet;
+        /** The instance's kernels */
+        const Kernels::Table *kernels;
+    };
+
+    /**
+     * @brief Render one channel of the modal bank into the wet signal. May
+     * run on any thread, concurrently with the other channels.
+     * @param context The ModalJob.
+     * @param channel The channel.
+     */
+    void renderModalChannel(void *context, const int channel) {
+        juce::ScopedNoDenormals noDenormals;
+        const auto &job = *static_cast<const ModalJob *>(context);
+        job.modes->renderChannel(channel, job.wet->getWritePointer(channel),
+                                 job.wet->getNumSamples(), *job.kernels);
+    }
+} // namespace
 
 /**
  * @brief Constructor for the GraphVerb processor.
@@ -9,73 +68,267 @@ Graphverb::Graphverb() :
             BusesProperties()
                     .withInput("Input", juce::AudioChannelSet::stereo(), true)
                     .withOutput("Output", juce::AudioChannelSet::stereo(),
-                                true)),
+                                true)
+                    .withInput("Sidechain", juce::AudioChannelSet::stereo(),
+                               false)),
     parameters(*this, nullptr, "PARAMETERS", createParameterLayout()),
-    spectralAnalyzer(10, 512) {}
+    analysisWorker(AnalysisConfig{10, 512, numClusters}) {
+    memoryTracker.setBytes(MemoryTracker::Subsystem::scope,
+                           sizeof(audioBufferQueue) +
+                                   sizeof(scopeDataCollector));
+    analysisWorker.setFlightRecorder(&flightRecorder);
+    analysisWorker.setImpulseCapture(&impulseCapture);
+}
+
+/**
+ * @brief Destructor for the Graphverb processor.
+ */
+Graphverb::~Graphverb() {
+    analysisWorker.stop();
+    setTaskRunner(nullptr);
+}
 
 /**
  * @brief Prepare the processor for playback.
+ *
+ * Hosts may call this repeatedly, with or without releaseResources() in
+ * between, and some do so while audio is running. The current processing state
+ * is reused when it fits; otherwise a new one is built here and published for
+ * the audio thread to pick up on its next callback. A running analysis thread
+ * keeps running and only learns the new sample rate.
+ *
  * @param sampleRate The sample rate of the audio stream.
  * @param samplesPerBlock The number of samples per block to process.
  */
-void Graphverb::prepareToPlay(double sampleRate, int samplesPerBlock) {
-    spectralAnalyzer.reset();
-
-    threadShouldExit = false;
-    analysisThread = std::thread([this, sampleRate] {
-        std::vector<float> inputBuffer;
-        while (!threadShouldExit.load()) {
-            if (this->analysisInputQueue.pop(inputBuffer)) {
-                /// Run spectral + graph + clustering
-                spectralAnalyzer.pushSamples(
-                        inputBuffer.data(),
-                        static_cast<int>(inputBuffer.size()));
-                const auto &magnitudes = spectralAnalyzer.getLatestMagnitudes();
-                spectralGraph.buildGraph(magnitudes,
-                                         static_cast<float>(sampleRate), 1024);
-                const std::vector<int> clusterAssignments =
-                        CommunityClustering::clusterNodes(spectralGraph.nodes,
-                                                          12);
-                std::vector newEnergies(12, 0.0f);
-                std::vector clusterCounts(12, 0);
-                for (size_t i = 0; i < spectralGraph.nodes.size(); ++i) {
-                    const int cluster = clusterAssignments[i];
-                    newEnergies[cluster] += spectralGraph.nodes[i].magnitude;
-                    clusterCounts[cluster]++;
-                }
-                for (int i = 0; i < 12; ++i)
-                    newEnergies[i] =
-                            clusterCounts[i] > 0
-                                    ? (newEnergies[i] /
-                                       static_cast<float>(clusterCounts[i]))
-                                    : 0.0f;
-                /// Normalize
-                if (const float energySum = std::accumulate(
-                            newEnergies.begin(), newEnergies.end(), 0.0f);
-                    energySum > 0.0f) {
-                    for (float &e: newEnergies)
-                        e /= energySum;
-                }
-                /// Store atomically
-                {
-                    std::lock_guard lock(energyMutex);
-                    latestClusterEnergies = std::move(newEnergies);
-                }
-            } else {
-                /// avoid busy loop
-                std::this_thread::sleep_for(std::chrono::milliseconds(2));
-            }
+void Graphverb::prepareToPlay(const double sampleRate,
+                              const int samplesPerBlock) {
+    /// Only the main bus is processed; the sidechain is read in place
+    const int numChannels = juce::jmax(getMainBusNumInputChannels(),
+                                       getMainBusNumOutputChannels());
+    /// Sized once, for the first configuration, as the audio thread may be
+    /// recording into it by the next prepare
+    flightRecorder.allocate(
+            getFlightRecorderBlocks(sampleRate, samplesPerBlock),
+            getFlightRecorderFrames(sampleRate,
+                                    analysisWorker.getConfig().hopSize));
+    flightRecorder.arm(flightRecorderWarmupBlocks);
+    memoryTracker.setBytes(MemoryTracker::Subsystem::flightRecorder,
+                           flightRecorder.getMemoryBytes());
+    {
+        std::lock_guard lock(dspStateMutex);
+        /// The reverbs are built here rather than in the constructor, so
+        /// hosts scanning or loading many instances do not allocate their
+        /// delay lines
+        if (const DspState *current = currentDspState.load();
+            current == nullptr ||
+            !current->fits(sampleRate, numChannels, samplesPerBlock)) {
+            auto state = std::make_unique<DspState>(
+                    sampleRate, numChannels,
+                    juce::jmax(samplesPerBlock, declaredMaxBlockSize.load()),
+                    numClusters, modalModesPerChannel, *convolutionQueue);
+            currentDspState.store(state.get());
+            dspStates.push_back(std::move(state));
         }
-    });
+        collectDspStatesLocked();
+    }
+    /// Pick the fastest kernels for this configuration, queueing them for
+    /// the analysis thread to tune on first launch
+    analysisWorker.prepareKernels({sampleRate, samplesPerBlock,
+                                   analysisWorker.getFftSize(), numClusters});
+    {
+        std::lock_guard lock(replayMutex);
+        prepared = true;
+        /// A replay renders from its start again; the analysis stays off
+        replayRewind.store(true);
+        if (currentReplay.load() == nullptr)
+            analysisWorker.start(sampleRate);
+    }
+    /// Capture without a host UI, e.g. from a DAW session under test
+    const juce::String captureDirectory =
+            juce::SystemStats::getEnvironmentVariable("GRAPHVERB_CAPTURE_DIR",
+                                                      {});
+    if (captureDirectory.isNotEmpty() && !analysisWorker.isCapturing()) {
+        const juce::File directory(captureDirectory);
+        const juce::String name =
+                "graphverb-" +
+                juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S") + "-" +
+                juce::String::toHexString(
+                        juce::Random::getSystemRandom().nextInt()) +
+                ".gvcap";
+        /// Sized and opened by the analysis thread, not here
+        analysisWorker.requestCapture(directory.getChildFile(name),
+                                      defaultCaptureSeconds);
+    }
 }
 
 /**
  * @brief Release any resources used by the processor.
+ *
+ * The current processing state is kept, so the next prepareToPlay() with the
+ * same configuration is free.
  */
 void Graphverb::releaseResources() {
-    threadShouldExit = true;
-    if (analysisThread.joinable())
-        analysisThread.join();
+    {
+        std::lock_guard lock(replayMutex);
+        prepared = false;
+    }
+    analysisWorker.stop();
+    std::lock_guard lock(dspStateMutex);
+    collectDspStatesLocked();
+}
+
+/**
+ * @brief Free the states the audio thread can no longer reach and update the
+ * memory accounting. dspStateMutex must be held.
+ */
+void Graphverb::collectDspStatesLocked() {
+    /// The active slot is read before the fading one: the audio thread fills
+    /// the fading slot before it moves the active one on
+    const DspState *current = currentDspState.load();
+    const DspState *active = dspStatesInUse[0].load();
+    const DspState *fading = dspStatesInUse[1].load();
+    std::erase_if(dspStates, [&](const auto &state) {
+        return state.get() != current && state.get() != active &&
+               state.get() != fading;
+    });
+    size_t reverbBytes = 0, bufferBytes = 0;
+    for (const auto &state: dspStates) {
+        reverbBytes += state->reverbs.size() *
+                               CommunityReverb::getMemoryBytes(
+                                       state->sampleRate) +
+                       state->modalReverb.getMemoryBytes();
+        bufferBytes += state->getBufferBytes();
+    }
+    reverbBytes += impulseCapture.getMemoryBytes();
+    memoryTracker.setBytes(MemoryTracker::Subsystem::reverbs, reverbBytes);
+    memoryTracker.setBytes(MemoryTracker::Subsystem::processBuffers,
+                           bufferBytes);
+}
+
+/**
+ * @brief Get the state information of the processor.
+ * @param destData The block to write the state to.
+ */
+void Graphverb::getStateInformation(juce::MemoryBlock &destData) {
+    auto state = parameters.copyState();
+    state.setProperty(analysisStateId,
+                      analysisWorker.getSnapshot().toBinary().toBase64Encoding(),
+                      nullptr);
+    if (const auto xml = state.createXml())
+        copyXmlToBinary(*xml, destData);
+}
+
+/**
+ * @brief Set the state information of the processor.
+ * @param data Pointer to the state written by getStateInformation().
+ * @param sizeInBytes Size of the state in bytes.
+ */
+void Graphverb::setStateInformation(const void *data, const int sizeInBytes) {
+    const auto xml = getXmlFromBinary(data, sizeInBytes);
+    if (xml == nullptr || !xml->hasTagName(parameters.state.getType()))
+        return;
+    auto state = juce::ValueTree::fromXml(*xml);
+    const auto analysisState = state.getProperty(analysisStateId).toString();
+    state.removeProperty(analysisStateId, nullptr);
+    parameters.replaceState(state);
+    /// Sessions saved before the snapshot existed simply start cold
+    if (juce::MemoryBlock block;
+        analysisState.isNotEmpty() && block.fromBase64Encoding(analysisState))
+        if (const auto snapshot =
+                    AnalysisSnapshot::fromBinary(block.getData(),
+                                                 block.getSize()))
+            analysisWorker.restoreSnapshot(*snapshot);
+}
+
+/**
+ * @brief Change the analysis settings while running.
+ * @param config The new analysis settings.
+ */
+void Graphverb::setAnalysisConfig(const AnalysisConfig &config) {
+    AnalysisConfig limited = config;
+    limited.fftOrder =
+            juce::jlimit(8, AnalysisConfig::maxFftOrder, config.fftOrder);
+    limited.hopSize = juce::jlimit(1, limited.getFftSize(), config.hopSize);
+    limited.numClusters = juce::jlimit(1, numClusters, config.numClusters);
+    limited.maxIterations = juce::jmax(1, config.maxIterations);
+    limited.beatSubdivisions = juce::jlimit(0, 16, config.beatSubdivisions);
+    analysisWorker.setConfig(limited);
+}
+
+/**
+ * @brief Drive the reverbs from the energies recorded in an analysis capture
+ * instead of the live analysis, which is stopped.
+ * @param file The capture file.
+ * @return True if the capture was loaded.
+ */
+bool Graphverb::startAnalysisReplay(const juce::File &file) {
+    auto loaded = AnalysisReplay::load(file);
+    if (loaded == nullptr || loaded->getNumClusters() > numClusters)
+        return false;
+    std::lock_guard lock(replayMutex);
+    analysisWorker.stop();
+    replayRewind.store(true);
+    const AnalysisReplay *previous = currentReplay.exchange(loaded.get());
+    /// Wait out a block still reading the previous replay
+    while (previous != nullptr && replayInUse.load() == previous)
+        std::this_thread::yield();
+    replay = std::move(loaded);
+    return true;
+}
+
+/**
+ * @brief Return to the live analysis.
+ */
+void Graphverb::stopAnalysisReplay() {
+    std::lock_guard lock(replayMutex);
+    const AnalysisReplay *previous = currentReplay.exchange(nullptr);
+    if (previous == nullptr)
+        return;
+    while (replayInUse.load() == previous)
+        std::this_thread::yield();
+    replay.reset();
+    if (prepared)
+        analysisWorker.start(getSampleRate());
+}
+
+/**
+ * @brief Refresh the dynamic memory counters and take a snapshot.
+ * @return The per-subsystem memory footprint of this instance.
+ */
+MemoryTracker::Snapshot Graphverb::getMemoryFootprint() {
+    memoryTracker.setBytes(MemoryTracker::Subsystem::analysis,
+                           analysisWorker.getMemoryBytes());
+    memoryTracker.setBytes(MemoryTracker::Subsystem::analysisQueue,
+                           analysisWorker.getQueueCapacityBytes());
+    memoryTracker.reportQueueDepth(MemoryTracker::Queue::analysisInput,
+                                   analysisWorker.getQueueHighWaterBytes());
+    memoryTracker.reportQueueDepth(
+            MemoryTracker::Queue::scope,
+            static_cast<size_t>(audioBufferQueue.getHighWaterMark()) *
+                    AudioBufferQueue<float>::bufferSize * sizeof(float));
+    return memoryTracker.getSnapshot();
+}
+
+/**
+ * @brief Get the number of bytes an instance holds in what it sizes for its
+ * configuration.
+ * @param sampleRate The sample rate.
+ * @param numChannels The number of channels processed.
+ * @param blockSize The largest block size.
+ * @param hopSize The analysis hop size.
+ * @return The number of bytes.
+ */
+size_t Graphverb::getSizedMemoryBytes(const double sampleRate,
+                                      const int numChannels,
+                                      const int blockSize, const int hopSize) {
+    return static_cast<size_t>(numClusters) *
+                   CommunityReverb::getMemoryBytes(sampleRate) +
+           ModalReverb::getMemoryBytes(numChannels, modalModesPerChannel,
+                                       numClusters, blockSize) +
+           DspState::getBufferBytes(numChannels, blockSize, numClusters) +
+           FlightRecorder::getMemoryBytes(
+                   getFlightRecorderBlocks(sampleRate, blockSize),
+                   getFlightRecorderFrames(sampleRate, hopSize));
 }
 
 /**
@@ -88,6 +341,13 @@ bool Graphverb::isBusesLayoutSupported(const BusesLayout &layouts) const {
         layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
         return false;
 
+    /// The sidechain is optional, and mono or stereo when connected
+    if (const auto sidechain = layouts.getChannelSet(true, sidechainBus);
+        !sidechain.isDisabled() &&
+        sidechain != juce::AudioChannelSet::mono() &&
+        sidechain != juce::AudioChannelSet::stereo())
+        return false;
+
     return true;
 }
 
@@ -96,98 +356,783 @@ bool Graphverb::isBusesLayoutSupported(const BusesLayout &layouts) const {
  */
 void Graphverb::processBlock(juce::AudioBuffer<float> &buffer,
                              juce::MidiBuffer &) {
+    process(buffer, false);
+}
+
+/**
+ * @brief Process a block while the host bypasses the plugin.
+ */
+void Graphverb::processBlockBypassed(juce::AudioBuffer<float> &buffer,
+                                     juce::MidiBuffer &) {
+    process(buffer, true);
+}
+
+/**
+ * @brief Get the parameter hosts should use to bypass the plugin.
+ * @return The bypass parameter.
+ */
+juce::AudioProcessorParameter *Graphverb::getBypassParameter() const {
+    return parameters.getParameter("bypass");
+}
+
+/**
+ * @brief Process a block, bypassed or not.
+ * @param buffer The host buffer.
+ * @param hostBypassed Whether the host bypasses the plugin.
+ */
+void Graphverb::process(juce::AudioBuffer<float> &buffer,
+                        const bool hostBypassed) {
     juce::ScopedNoDenormals noDenormals;
 
     const int numSamples = buffer.getNumSamples();
     const int numChannels = buffer.getNumChannels();
-    std::vector monoBuffer(numSamples, 0.0f);
-
-    /// Stereo to mono conversion
-    if (numChannels >= 2) {
-        const float *left = buffer.getReadPointer(0);
-        const float *right = buffer.getReadPointer(1);
-        for (int i = 0; i < numSamples; ++i)
-            monoBuffer[i] = 0.5f * (left[i] + right[i]);
-    } else {
-        const float *ch = buffer.getReadPointer(0);
-        std::copy_n(ch, numSamples, monoBuffer.begin());
+
+    /// Nothing is built until prepareToPlay; pass the audio through
+    DspState *state = acquireDspState();
+    if (state == nullptr)
+        return;
+    const uint64_t startNs = FlightRecorder::now();
+
+    /// Keep NaN and infinity from the host out of the reverbs and analysis
+    int replacedSamples = 0;
+    for (int ch = 0; ch < numChannels; ++ch)
+        replacedSamples += SampleSanitiser::sanitise(buffer.getWritePointer(ch),
+                                                     numSamples);
+    if (replacedSamples > 0) {
+        nonFiniteInputSamples.fetch_add(static_cast<uint64_t>(replacedSamples),
+                                        std::memory_order_relaxed);
+        nonFiniteInputBlocks.fetch_add(1, std::memory_order_relaxed);
     }
 
-    /// Send monoBuffer to background thread for analysis
-    analysisInputQueue.push(monoBuffer);
+    /// Views onto the host buffer; referring to existing channels does not
+    /// allocate. The main output channels hold the main input, processed in
+    /// place, and a connected sidechain keys the analysis.
+    auto mainBus = getBusBuffer(buffer, false, 0);
+    const auto mainInput = getBusBuffer(buffer, true, 0);
+    const auto sidechain = getBusBuffer(buffer, true, sidechainBus);
+    const bool keyed = sidechain.getNumChannels() > 0;
+    keyedBySidechain.store(keyed, std::memory_order_relaxed);
 
-    /// Safely copy the latest energies from background thread
-    {
-        std::lock_guard lock(energyMutex);
-        if (!latestClusterEnergies.empty()) {
-            clusterEnergies = latestClusterEnergies;
+    const bool bypassed =
+            hostBypassed || *parameters.getRawParameterValue("bypass") >= 0.5f;
+    analysisWorker.setFrameDecimation(
+            bypassed ? juce::jmax(1, bypassAnalysisDecimation.load()) : 1);
+    followBeatGrid(numSamples, state->sampleRate);
+
+    /// A host may send more than it announced; split rather than allocate
+    const AnalysisReplay *activeReplay = acquireReplay();
+    const auto &keyBus = keyed ? sidechain : mainInput;
+    for (int start = 0; start < numSamples; start += state->blockCapacity) {
+        const int length = juce::jmin(state->blockCapacity, numSamples - start);
+        if (bypassed == wasBypassed) {
+            if (bypassed)
+                processBypassedChunk(*state, mainBus, keyBus, activeReplay,
+                                     start, length);
+            else
+                processChunk(*state, mainBus, keyBus, activeReplay, start,
+                             length);
+            continue;
+        }
+        /// Crossfade between the processed and the dry signal over the
+        /// first chunk; processChunk() leaves the dry copy in the state
+        processChunk(*state, mainBus, keyBus, activeReplay, start, length);
+        const float processedEnd = bypassed ? 0.0f : 1.0f;
+        for (int ch = 0;
+             ch < juce::jmin(mainBus.getNumChannels(), state->numChannels);
+             ++ch) {
+            mainBus.applyGainRamp(ch, start, length, 1.0f - processedEnd,
+                                  processedEnd);
+            mainBus.addFromWithRamp(ch, start,
+                                    state->dryBuffer.getReadPointer(ch),
+                                    length, processedEnd, 1.0f - processedEnd);
+        }
+        wasBypassed = bypassed;
+        tailRinging = bypassed && bypassRingsOutTails.load();
+        /// The tails ring out of the reverbs
+        leaveStaticMode(*state);
+        /// The trend from before a bypass says nothing about after it
+        energyPredictor.reset();
+        /// Without a tail, start clean when the bypass ends
+        if (bypassed && !tailRinging) {
+            for (const auto &reverb: state->reverbs)
+                reverb->reverb.reset();
+            state->modalReverb.reset();
         }
     }
+    replayInUse.store(nullptr);
+
+    /// Collect signal for scope; it returns at once while no scope is open
+    if (scopeEnabled.load(std::memory_order_relaxed))
+        scopeDataCollector.process(mainBus.getReadPointer(0),
+                                   static_cast<size_t>(numSamples));
+
+    recordBlock(
+            *state, startNs, numSamples,
+            static_cast<uint16_t>(
+                    (bypassed ? FlightRecorder::bypassed : 0) |
+                    (activeReplay != nullptr ? FlightRecorder::replaying : 0) |
+                    (keyed ? FlightRecorder::keyed : 0) |
+                    (replacedSamples > 0 ? FlightRecorder::nonFiniteInput
+                                         : 0) |
+                    (taskRunner.load(std::memory_order_relaxed) != nullptr
+                             ? FlightRecorder::parallelVoices
+                             : 0) |
+                    (state->staticMode == DspState::StaticMode::convolving
+                             ? FlightRecorder::staticReverb
+                             : 0) |
+                    (state->modalActive ? FlightRecorder::modalReverb : 0)));
+}
+
+/**
+ * @brief Append a block to the flight recorder. Audio thread only.
+ *
+ * A block over its deadline, or one leaving the analysis too far behind,
+ * triggers a dump, which the analysis thread writes.
+ *
+ * @param state The processing state.
+ * @param startNs Steady clock when the block started.
+ * @param numSamples The number of samples in the block.
+ * @param flags Combination of FlightRecorder::BlockFlags.
+ */
+void Graphverb::recordBlock(const DspState &state, const uint64_t startNs,
+                            const int numSamples, const uint16_t flags) {
+    FlightRecorder::BlockRecord record{};
+    record.timeNs = startNs;
+    record.durationUs =
+            static_cast<float>(FlightRecorder::now() - startNs) * 1.0e-3f;
+    record.budgetUs = static_cast<float>(numSamples * 1.0e6 /
+                                         state.sampleRate);
+    record.numSamples = static_cast<uint32_t>(numSamples);
+    record.queuedSamples = static_cast<uint32_t>(
+            analysisWorker.getQueuedBytes() / sizeof(float));
+    /// Voices without weight still run, but do not reach the output
+    if ((!wasBypassed || tailRinging) &&
+        state.staticMode != DspState::StaticMode::convolving)
+        for (const float energy: state.clusterEnergies)
+            if (energy > 0.0f)
+                ++record.activeVoices;
+    record.flags = flags;
+    flightRecorder.recordBlock(record);
+}
 
-    /// Resize reverbs if needed
-    constexpr int numClusters = 12;
-    if (communityReverbs.size() != numClusters) {
-        communityReverbs.clear();
-        for (int i = 0; i < numClusters; ++i)
-            communityReverbs.push_back(std::make_unique<CommunityReverb>());
+/**
+ * @brief Tell the analysis where the host's beat grid falls in this block.
+ *
+ * The grid is only followed while the transport runs with a known tempo and
+ * position; otherwise every frame is re-clustered, as without a grid.
+ *
+ * @param numSamples The number of samples in the block.
+ * @param sampleRate The sample rate.
+ */
+void Graphverb::followBeatGrid(const int numSamples, const double sampleRate) {
+    const int subdivisions = analysisWorker.getBeatSubdivisions();
+    juce::AudioPlayHead *playHead = subdivisions > 0 ? getPlayHead() : nullptr;
+    juce::Optional<juce::AudioPlayHead::PositionInfo> position;
+    if (playHead != nullptr)
+        position = playHead->getPosition();
+    const auto bpm = position ? position->getBpm() : juce::nullopt;
+    const auto ppq = position ? position->getPpqPosition() : juce::nullopt;
+    if (!position || !position->getIsPlaying() || !bpm || !ppq ||
+        *bpm <= 0.0) {
+        analysisWorker.setGridSynced(false);
+        return;
     }
-    /// Update reverb parameters
-    const float intensity = *parameters.getRawParameterValue("intensity");
-    for (int i = 0; i < numClusters; ++i) {
-        const bool expand = *parameters.getRawParameterValue("expand") >= 0.5f;
-        communityReverbs[i]->updateParameters(
-                (i < clusterEnergies.size() ? clusterEnergies[i] : 0.0f),
-                expand, intensity);
-    }
-
-    /// Prepare buffers
-    juce::AudioBuffer<float> dryBuffer;
-    dryBuffer.makeCopyOf(buffer);
-    juce::AudioBuffer<float> wetBuffer;
-    wetBuffer.makeCopyOf(buffer);
-    wetBuffer.clear();
-    juce::AudioBuffer<float> tempBuffer;
-    tempBuffer.makeCopyOf(buffer);
-
-    /// Apply per-cluster reverbs
-    if (*parameters.getRawParameterValue("bypass") < 0.5f) {
-        for (int i = 0; i < numClusters; ++i) {
-            tempBuffer.makeCopyOf(dryBuffer);
-            communityReverbs[i]->processBlock(tempBuffer);
-            const float weight =
-                    (i < clusterEnergies.size()) ? clusterEnergies[i] : 0.0f;
-
-            for (int ch = 0; ch < wetBuffer.getNumChannels(); ++ch) {
-                float *wet = wetBuffer.getWritePointer(ch);
-                const float *temp = tempBuffer.getReadPointer(ch);
-                for (int s = 0; s < wetBuffer.getNumSamples(); ++s) {
-                    wet[s] += weight * temp[s];
-                }
-            }
-        }
+    /// Positions in grid lines; a line at the very start of the block counts,
+    /// and a large block or a fast grid can hold several. Once the worker
+    /// drops lines, the rest of the block's would be dropped too
+    const double linesPerSample = *bpm * subdivisions / (60.0 * sampleRate);
+    const double start = *ppq * subdivisions;
+    const double end = start + numSamples * linesPerSample;
+    for (double line = std::ceil(start); line < end; line += 1.0)
+        if (!analysisWorker.markGridLine(
+                    static_cast<int>((line - start) / linesPerSample)))
+            break;
+    analysisWorker.setGridSynced(true);
+}
+
+/**
+ * @brief Pick up the latest published processing state. Audio thread only.
+ * @return The state to process with, or null before the first prepare.
+ */
+DspState *Graphverb::acquireDspState() {
+    if (currentDspState.load() == activeDspState)
+        return activeDspState;
+    /// Still protected by the active slot while it moves to the fading one
+    if (activeDspState != nullptr) {
+        fadingDspState = activeDspState;
+        dspStatesInUse[1].store(fadingDspState);
+    }
+    DspState *latest;
+    do {
+        latest = currentDspState.load();
+        dspStatesInUse[0].store(latest);
+    } while (latest != currentDspState.load());
+    activeDspState = latest;
+    return activeDspState;
+}
+
+/**
+ * @brief Pick up the latest published replay. Audio thread only.
+ * @return The replay to take energies from, or null for live analysis.
+ */
+const AnalysisReplay *Graphverb::acquireReplay() {
+    const AnalysisReplay *latest;
+    do {
+        latest = currentReplay.load();
+        replayInUse.store(latest);
+    } while (latest != currentReplay.load());
+    if (replayRewind.exchange(false))
+        replayPosition = 0;
+    return latest;
+}
+
+/**
+ * @brief Process part of a block with a state.
+ * @param state The processing state.
+ * @param mainBus The main bus channels of the host buffer.
+ * @param keyBus The channels driving the analysis, either the sidechain or the
+ * main input.
+ * @param activeReplay The replay supplying the energies, or null to use the
+ * live analysis.
+ * @param startSample The first sample to process.
+ * @param numSamples The number of samples, at most the state's capacity.
+ */
+void Graphverb::processChunk(DspState &state,
+                             juce::AudioBuffer<float> &mainBus,
+                             const juce::AudioBuffer<float> &keyBus,
+                             const AnalysisReplay *activeReplay,
+                             const int startSample, const int numSamples) {
+    const int numChannels = juce::jmin(mainBus.getNumChannels(),
+                                       state.numChannels);
+    /// Views onto the host buffer and the preallocated buffers
+    juce::AudioBuffer<float> io(mainBus.getArrayOfWritePointers(), numChannels,
+                                startSample, numSamples);
+    juce::AudioBuffer<float> dry(state.dryBuffer.getArrayOfWritePointers(),
+                                 numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        dry.copyFrom(ch, 0, io, ch, 0, numSamples);
+
+    if (activeReplay != nullptr) {
+        /// Replay: the recorded energies at this position, no analysis at all
+        activeReplay->fetchEnergies(replayPosition, state.clusterEnergies);
+        replayPosition += static_cast<uint64_t>(numSamples);
     } else {
-        wetBuffer.makeCopyOf(dryBuffer);
+        /// Send the key channels to the background thread for analysis; they
+        /// are downmixed straight into its queue, and a mono key is copied
+        /// as is
+        analysisWorker.push(keyBus.getArrayOfReadPointers(),
+                            keyBus.getNumChannels(), startSample, numSamples);
+
+        /// Copy the latest energies from the background thread without taking
+        /// its lock, and extrapolate them between frames rather than hold
+        /// them for a hop
+        if (uint64_t publication = 0;
+            analysisWorker.fetchEnergies(state.clusterEnergies,
+                                         &publication) &&
+            publication != lastPublication) {
+            energyPredictor.update(state.clusterEnergies, processedSamples);
+            lastPublication = publication;
+            /// The modes follow the bins as they move between clusters; the
+            /// assignments are copied lock-free as well
+            if (modalReverbEnabled.load(std::memory_order_relaxed) &&
+                analysisWorker.fetchAssignments(state.clusterAssignments))
+                state.modalReverb.setAssignments(
+                        state.clusterAssignments,
+                        static_cast<int>(state.clusterEnergies.size()));
+        }
+        if (predictEnergies.load(std::memory_order_relaxed))
+            energyPredictor.predict(processedSamples, state.clusterEnergies);
+        processedSamples += static_cast<uint64_t>(numSamples);
     }
 
+    juce::AudioBuffer<float> wet =
+            renderWetStatic(state, state.clusterEnergies, dry);
+
+    /// Crossfade from the outgoing state's tail over the first chunk, so a
+    /// reconfiguration does not cut the reverb off
+    crossfadeFromFadingState(wet, state.clusterEnergies, dry);
+
     /// Mix dry/wet and apply gain
+    const Kernels::Table &kernels = analysisWorker.getKernels();
     const float liveliness = *parameters.getRawParameterValue("liveliness");
     const float dryLevel = 1.0f - liveliness;
+    const float linearGain = getOutputGain();
+    for (int ch = 0; ch < numChannels; ++ch) {
+        float *out = io.getWritePointer(ch);
+        kernels.mixAndClip(out, wet.getReadPointer(ch), dryLevel,
+                           1.0f - dryLevel, linearGain, numSamples);
+        for (int s = 0; s < numSamples; ++s)
+            jassert(std::isfinite(out[s]));
+    }
+}
+
+/**
+ * @brief Crossfade a wet signal in from the outgoing state's tail, if the
+ * state was replaced since the last chunk, and release the outgoing state.
+ * @param wet The wet signal of the current state, faded in.
+ * @param energies The cluster energies weighting the reverbs.
+ * @param dry The dry signal.
+ */
+void Graphverb::crossfadeFromFadingState(juce::AudioBuffer<float> &wet,
+                                         const std::vector<float> &energies,
+                                         const juce::AudioBuffer<float> &dry) {
+    if (fadingDspState == nullptr)
+        return;
+    const int numChannels = dry.getNumChannels();
+    const int numSamples = dry.getNumSamples();
+    if (fadingDspState->numChannels >= numChannels &&
+        fadingDspState->blockCapacity >= numSamples) {
+        leaveStaticMode(*fadingDspState);
+        const juce::AudioBuffer<float> fadingWet =
+                renderWet(*fadingDspState, energies, dry);
+        for (int ch = 0; ch < numChannels; ++ch) {
+            wet.applyGainRamp(ch, 0, numSamples, 0.0f, 1.0f);
+            wet.addFromWithRamp(ch, 0, fadingWet.getReadPointer(ch),
+                                numSamples, 1.0f, 0.0f);
+        }
+    }
+    releaseFadingDspState();
+}
+
+/**
+ * @brief Release the outgoing state without rendering it.
+ */
+void Graphverb::releaseFadingDspState() {
+    fadingDspState = nullptr;
+    dspStatesInUse[1].store(nullptr);
+}
+
+/**
+ * @brief Process part of a bypassed block: the audio passes through, a ringing
+ * tail is added and the analysis is fed if enabled.
+ * @param state The processing state.
+ * @param mainBus The main bus channels of the host buffer.
+ * @param keyBus The channels driving the analysis.
+ * @param activeReplay The replay supplying the energies, or null.
+ * @param startSample The first sample to process.
+ * @param numSamples The number of samples, at most the state's capacity.
+ */
+void Graphverb::processBypassedChunk(DspState &state,
+                                     juce::AudioBuffer<float> &mainBus,
+                                     const juce::AudioBuffer<float> &keyBus,
+                                     const AnalysisReplay *activeReplay,
+                                     const int startSample,
+                                     const int numSamples) {
+    /// Keep a replay in step, or the analysis warm at its reduced rate, so
+    /// the energies are current when the bypass ends
+    if (activeReplay != nullptr)
+        replayPosition += static_cast<uint64_t>(numSamples);
+    else if (bypassAnalysisDecimation.load(std::memory_order_relaxed) > 0)
+        analysisWorker.push(keyBus.getArrayOfReadPointers(),
+                            keyBus.getNumChannels(), startSample, numSamples);
+    if (!tailRinging) {
+        /// Nothing to hand its tail to; free it rather than keep it, and
+        /// its stale tail, until the bypass ends
+        releaseFadingDspState();
+        return;
+    }
+
+    /// Ring the tails out from silence on top of the untouched dry signal,
+    /// the outgoing state's too if it was replaced meanwhile
+    const int numChannels = juce::jmin(mainBus.getNumChannels(),
+                                       state.numChannels);
+    juce::AudioBuffer<float> silence(state.dryBuffer.getArrayOfWritePointers(),
+                                     numChannels, numSamples);
+    silence.clear();
+    juce::AudioBuffer<float> wet =
+            renderWet(state, state.clusterEnergies, silence);
+    crossfadeFromFadingState(wet, state.clusterEnergies, silence);
+    const Kernels::Table &kernels = analysisWorker.getKernels();
+    const float wetLevel = *parameters.getRawParameterValue("liveliness") *
+                           getOutputGain();
+    float peak = 0.0f;
+    for (int ch = 0; ch < numChannels; ++ch) {
+        kernels.addWeighted(mainBus.getWritePointer(ch, startSample),
+                            wet.getReadPointer(ch), wetLevel, numSamples);
+        peak = juce::jmax(peak, wet.getMagnitude(ch, 0, numSamples));
+    }
+    /// Rung out: stop, and start clean when the bypass ends
+    if (peak < tailSilenceLevel) {
+        tailRinging = false;
+        for (const auto &reverb: state.reverbs)
+            reverb->reverb.reset();
+        state.modalReverb.reset();
+    }
+}
+
+/**
+ * @brief Get the tail length in seconds.
+ *
+ * A ringing tail is stopped once it falls below tailSilenceLevel, so that is
+ * how long the longest reverb tail is reported to ring. The modal bank decays
+ * at the mean comb length, and so faster, and the static mode convolves with
+ * a truncated capture of the same tail.
+ *
+ * @return The time the longest reverb tail takes to ring out.
+ */
+double Graphverb::getTailLengthSeconds() const {
+    return CommunityReverb::getLongestTailSeconds(tailSilenceLevel);
+}
+
+/**
+ * @brief Get the output gain set by the gain parameter.
+ * @return The linear gain.
+ */
+float Graphverb::getOutputGain() const {
     const float gain = *parameters.getRawParameterValue("gain");
     const float dB = juce::jmap(gain, 0.0f, 1.0f, -60.0f, 12.0f);
-    const float linearGain = juce::Decibels::decibelsToGain(dB);
-    const float *leftOutput = buffer.getWritePointer(0);
-    for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
-        float *out = buffer.getWritePointer(ch);
-        const float *wet = wetBuffer.getReadPointer(ch);
-        for (int s = 0; s < buffer.getNumSamples(); ++s) {
-            float mixed = dryLevel * out[s] + (1.0f - dryLevel) * wet[s];
-            mixed *= linearGain;
-            out[s] = std::tanh(mixed);
-            jassert(std::isfinite(out[s]));
+    return juce::Decibels::decibelsToGain(dB);
+}
+
+/**
+ * @brief Render the wet signal with the selected engine, crossfading over the
+ * chunk when the selection changes.
+ * @param state The processing state.
+ * @param energies The cluster energies weighting the reverbs.
+ * @param dry The dry signal.
+ * @return A view of the wet signal, the same size as the dry signal.
+ */
+juce::AudioBuffer<float>
+Graphverb::renderWet(DspState &state, const std::vector<float> &energies,
+                     const juce::AudioBuffer<float> &dry) {
+    const bool modal = modalReverbEnabled.load(std::memory_order_relaxed);
+    if (modal == state.modalActive)
+        return modal ? renderModes(state, energies, dry)
+                     : renderReverbs(state, energies, dry);
+
+    /// Run both over this chunk, fading the outgoing one out, then clear it
+    /// so it starts clean if selected again
+    const int numSamples = dry.getNumSamples();
+    juce::AudioBuffer<float> wet = renderReverbs(state, energies, dry);
+    const juce::AudioBuffer<float> modes = renderModes(state, energies, dry);
+    const float modesEnd = modal ? 1.0f : 0.0f;
+    for (int ch = 0; ch < dry.getNumChannels(); ++ch) {
+        wet.applyGainRamp(ch, 0, numSamples, modesEnd, 1.0f - modesEnd);
+        wet.addFromWithRamp(ch, 0, modes.getReadPointer(ch), numSamples,
+                            1.0f - modesEnd, modesEnd);
+    }
+    if (modal)
+        for (const auto &reverb: state.reverbs)
+            reverb->reverb.reset();
+    else
+        state.modalReverb.reset();
+    state.modalActive = modal;
+    return wet;
+}
+
+/**
+ * @brief Run the dry signal through a state's reverbs into its wet buffer.
+ * @param state The processing state.
+ * @param energies The cluster energies weighting the reverbs.
+ * @param dry The dry signal.
+ * @return A view of the wet signal, the same size as the dry signal.
+ */
+juce::AudioBuffer<float>
+Graphverb::renderReverbs(DspState &state, const std::vector<float> &energies,
+                         const juce::AudioBuffer<float> &dry) {
+    const int numChannels = dry.getNumChannels();
+    const int numSamples = dry.getNumSamples();
+    juce::AudioBuffer<float> wet(state.wetBuffer.getArrayOfWritePointers(),
+                                 numChannels, numSamples);
+    updateReverbParameters(state, energies);
+
+    /// Apply per-cluster reverbs, on the host's workers if it lends them
+    VoiceJob job{&state, &dry};
+    TaskRunner::run(taskRunner.load(std::memory_order_acquire),
+                    static_cast<int>(state.reverbs.size()), renderVoice, &job);
+
+    /// Mix in a fixed order, so the output does not depend on where the
+    /// voices ran
+    const Kernels::Table &kernels = analysisWorker.getKernels();
+    wet.clear();
+    for (size_t i = 0; i < state.reverbs.size(); ++i) {
+        const float weight = i < energies.size() ? energies[i] : 0.0f;
+        for (int ch = 0; ch < numChannels; ++ch)
+            kernels.addWeighted(wet.getWritePointer(ch),
+                                state.voiceBuffers[i].getReadPointer(ch),
+                                weight, numSamples);
+    }
+    return wet;
+}
+
+/**
+ * @brief Run the dry signal through a state's modal bank into its modal
+ * buffer.
+ *
+ * Each cluster's modes take the parameters its reverb would run with. The
+ * modes are the reverbs' wet part only, so the direct path is added here.
+ *
+ * @param state The processing state.
+ * @param energies The cluster energies weighting the modes.
+ * @param dry The dry signal.
+ * @return A view of the wet signal, the same size as the dry signal.
+ */
+juce::AudioBuffer<float>
+Graphverb::renderModes(DspState &state, const std::vector<float> &energies,
+                       const juce::AudioBuffer<float> &dry) {
+    const int numChannels = dry.getNumChannels();
+    const int numSamples = dry.getNumSamples();
+    juce::AudioBuffer<float> wet(state.modalBuffer.getArrayOfWritePointers(),
+                                 numChannels, numSamples);
+    updateReverbParameters(state, energies);
+    for (size_t i = 0; i < state.reverbs.size(); ++i)
+        state.modalReverb.setCluster(static_cast<int>(i),
+                                     i < energies.size() ? energies[i] : 0.0f,
+                                     state.reverbs[i]->params);
+    state.modalReverb.prepareBlock(dry);
+
+    /// One task per channel, on the host's workers if it lends them
+    const Kernels::Table &kernels = analysisWorker.getKernels();
+    ModalJob job{&state.modalReverb, &wet, &kernels};
+    TaskRunner::run(taskRunner.load(std::memory_order_acquire), numChannels,
+                    renderModalChannel, &job);
+    for (int ch = 0; ch < numChannels; ++ch)
+        wet.addFrom(ch, 0, dry, ch, 0, numSamples,
+                    state.modalReverb.getDirectGain());
+    return wet;
+}
+
+/**
+ * @brief Set each reverb's parameters from its cluster energy.
+ * @param state The processing state.
+ * @param energies The cluster energies.
+ */
+void Graphverb::updateReverbParameters(DspState &state,
+                                       const std::vector<float> &energies) {
+    const float intensity = *parameters.getRawParameterValue("intensity");
+    const bool expand = *parameters.getRawParameterValue("expand") >= 0.5f;
+    for (size_t i = 0; i < state.reverbs.size(); ++i)
+        state.reverbs[i]->updateParameters(
+                (i < energies.size() ? energies[i] : 0.0f), expand, intensity);
+}
+
+/**
+ * @brief Render the wet signal with the reverbs, the convolution standing in
+ * for them, or both, moving through the static modes.
+ *
+ * Every reverb adds its wet part, heard through the sum of the channels, and
+ * its direct path on each channel, so the convolution is fed the summed
+ * input on every channel and the direct path is added as a gain.
+ *
+ * @param state The processing state.
+ * @param energies The cluster energies weighting the reverbs.
+ * @param dry The dry signal.
+ * @return A view of the wet signal, the same size as the dry signal.
+ */
+juce::AudioBuffer<float>
+Graphverb::renderWetStatic(DspState &state, const std::vector<float> &energies,
+                           const juce::AudioBuffer<float> &dry) {
+    using Mode = DspState::StaticMode;
+    const int numChannels = dry.getNumChannels();
+    const int numSamples = dry.getNumSamples();
+    /// The convolution runs with all of the state's channels, and only
+    /// stands in for the reverbs
+    if (numChannels != state.numChannels ||
+        modalReverbEnabled.load(std::memory_order_relaxed) ||
+        state.modalActive) {
+        leaveStaticMode(state);
+        return renderWet(state, energies, dry);
+    }
+    updateReverbParameters(state, energies);
+    updateStaticMode(state, energies, numSamples);
+    const Mode mode = state.staticMode;
+    if (mode == Mode::live || mode == Mode::capturing)
+        return renderReverbs(state, energies, dry);
+
+    /// Fills the same wet buffer
+    juce::AudioBuffer<float> wet(state.wetBuffer.getArrayOfWritePointers(),
+                                 numChannels, numSamples);
+    if (mode != Mode::convolving)
+        renderReverbs(state, energies, dry);
+
+    juce::AudioBuffer<float> convolved(
+            state.convolutionBuffer.getArrayOfWritePointers(), numChannels,
+            numSamples);
+    if (mode == Mode::ringingOut) {
+        /// Only the tail of the input from before the reverbs restarted
+        convolved.clear();
+    } else {
+        convolved.copyFrom(0, 0, dry, 0, 0, numSamples);
+        for (int ch = 1; ch < numChannels; ++ch)
+            convolved.addFrom(0, 0, dry, ch, 0, numSamples);
+        for (int ch = 1; ch < numChannels; ++ch)
+            convolved.copyFrom(ch, 0, convolved, 0, 0, numSamples);
+    }
+    juce::dsp::AudioBlock<float> block(convolved);
+    state.convolution.process(juce::dsp::ProcessContextReplacing<float>(block));
+    if (mode != Mode::ringingOut)
+        for (int ch = 0; ch < numChannels; ++ch)
+            convolved.addFrom(ch, 0, dry, ch, 0, numSamples, state.directGain);
+
+    switch (mode) {
+        case Mode::crossfading: {
+            const auto fadeSamples = static_cast<float>(
+                    staticCrossfadeSeconds * state.sampleRate);
+            const float startGain = juce::jlimit(
+                    0.0f, 1.0f, 1.0f - state.staticCountdown / fadeSamples);
+            const float endGain = juce::jlimit(
+                    0.0f, 1.0f,
+                    1.0f - (state.staticCountdown - numSamples) / fadeSamples);
+            for (int ch = 0; ch < numChannels; ++ch) {
+                wet.applyGainRamp(ch, 0, numSamples, 1.0f - startGain,
+                                  1.0f - endGain);
+                wet.addFromWithRamp(ch, 0, convolved.getReadPointer(ch),
+                                    numSamples, startGain, endGain);
+            }
+            break;
         }
+        case Mode::convolving:
+            for (int ch = 0; ch < numChannels; ++ch)
+                wet.copyFrom(ch, 0, convolved, ch, 0, numSamples);
+            break;
+        case Mode::ringingOut:
+            for (int ch = 0; ch < numChannels; ++ch)
+                wet.addFrom(ch, 0, convolved, ch, 0, numSamples);
+            break;
+        default:
+            /// Warming up: the convolution only fills up
+            break;
+    }
+    state.staticCountdown -= numSamples;
+    return wet;
+}
+
+/**
+ * @brief Move a state to its next static mode, if the weights or the rendered
+ * capture call for it.
+ *
+ * The bank is compared with where it stood when the weights last moved, so a
+ * slow drift also counts as movement once it adds up to the tolerance.
+ *
+ * @param state The processing state.
+ * @param energies The cluster energies.
+ * @param numSamples The number of samples about to be processed.
+ */
+void Graphverb::updateStaticMode(DspState &state,
+                                 const std::vector<float> &energies,
+                                 const int numSamples) {
+    using Mode = DspState::StaticMode;
+    ImpulseCapture::Request &bank = state.steadyBank;
+    const int numVoices = juce::jmin(static_cast<int>(state.reverbs.size()),
+                                     ImpulseCapture::maxVoices);
+    const auto weightOf = [&energies](const int voice) {
+        return static_cast<size_t>(voice) < energies.size()
+                       ? energies[static_cast<size_t>(voice)]
+                       : 0.0f;
+    };
+    bool steady = bank.numVoices == numVoices;
+    for (int v = 0; v < numVoices && steady; ++v) {
+        const auto voice = static_cast<size_t>(v);
+        const auto &now = state.reverbs[voice]->params;
+        const auto &then = bank.parameters[voice];
+        steady = std::abs(weightOf(v) - bank.weights[voice]) <=
+                         staticTolerance &&
+                 std::abs(now.roomSize - then.roomSize) <= staticTolerance &&
+                 std::abs(now.wetLevel - then.wetLevel) <= staticTolerance;
     }
-    /// Collect signal for scope
-    scopeDataCollector.process(leftOutput, static_cast<size_t>(numSamples));
+
+    const bool enabled =
+            staticReverbEnabled.load(std::memory_order_relaxed) &&
+            state.canConvolve();
+    const bool moving = !enabled || !steady;
+    switch (state.staticMode) {
+        case Mode::live:
+            if (!moving &&
+                state.steadySamples >= staticSettleSeconds * state.sampleRate &&
+                impulseCapture.request(bank))
+                state.staticMode = Mode::capturing;
+            break;
+        case Mode::capturing:
+            if (moving) {
+                impulseCapture.cancel();
+                state.staticMode = Mode::live;
+            } else if (impulseCapture.loadInto(state.convolution,
+                                               state.sampleRate,
+                                               state.numChannels)) {
+                state.directGain = impulseCapture.getDirectGain();
+                state.impulseLength = impulseCapture.getImpulseLength();
+                state.convolution.reset();
+                state.staticMode = Mode::warming;
+                state.staticCountdown = static_cast<int>(
+                        staticWarmupSeconds * state.sampleRate);
+            }
+            break;
+        case Mode::warming:
+            /// The reverbs never stopped, so they simply carry on
+            if (moving)
+                state.staticMode = Mode::live;
+            /// The convolution loads the impulse response in the background;
+            /// wait until it runs with it
+            else if (state.staticCountdown <= 0 &&
+                     state.convolution.getCurrentIRSize() ==
+                             state.impulseLength) {
+                state.staticMode = Mode::crossfading;
+                state.staticCountdown = static_cast<int>(
+                        staticCrossfadeSeconds * state.sampleRate);
+            }
+            break;
+        case Mode::crossfading:
+            if (moving)
+                state.staticMode = Mode::live;
+            else if (state.staticCountdown <= 0)
+                state.staticMode = Mode::convolving;
+            break;
+        case Mode::convolving:
+            if (moving) {
+                /// Both are linear: the restarted reverbs take the input from
+                /// here on, and the convolution rings out what came before
+                for (const auto &reverb: state.reverbs)
+                    reverb->reverb.reset();
+                state.staticMode = Mode::ringingOut;
+                state.staticCountdown = state.impulseLength;
+            }
+            break;
+        case Mode::ringingOut:
+            if (state.staticCountdown <= 0) {
+                state.convolution.reset();
+                state.staticMode = Mode::live;
+            }
+            break;
+    }
+
+    if (steady) {
+        state.steadySamples += numSamples;
+    } else {
+        bank.sampleRate = state.sampleRate;
+        bank.numChannels = state.numChannels;
+        bank.numVoices = numVoices;
+        for (int v = 0; v < numVoices; ++v) {
+            const auto voice = static_cast<size_t>(v);
+            bank.parameters[voice] = state.reverbs[voice]->params;
+            bank.weights[voice] = weightOf(v);
+        }
+        state.steadySamples = 0;
+    }
+    staticReverbActive.store(state.staticMode == Mode::convolving,
+                             std::memory_order_relaxed);
+}
+
+/**
+ * @brief Return a state to the reverbs alone at once, e.g. for a bypass.
+ *
+ * Reverbs the convolution stood in for start clean, so a stale tail is not
+ * played; the convolution's own tail is dropped.
+ *
+ * @param state The processing state.
+ */
+void Graphverb::leaveStaticMode(DspState &state) {
+    using Mode = DspState::StaticMode;
+    if (state.staticMode == Mode::live)
+        return;
+    if (state.staticMode == Mode::capturing)
+        impulseCapture.cancel();
+    if (state.staticMode == Mode::convolving)
+        for (const auto &reverb: state.reverbs)
+            reverb->reverb.reset();
+    state.convolution.reset();
+    state.staticMode = Mode::live;
+    state.steadySamples = 0;
+    staticReverbActive.store(false, std::memory_order_relaxed);
 }
 
 /**
@@ -7,7 +7,7 @@
  */
 GraphverbEditor::GraphverbEditor(Graphverb &p) :
     AudioProcessorEditor(p), processor(p), scope(p.getAudioBufferQueue()),
-    clusterEnergy(p), clusterVisualizer(p),
+    clusterEnergy(p), clusterVisualizer(p), telemetryOverlay(p),
     livelinessKnob(p.getParameters(), "liveliness", "Liveliness"),
     gainKnob(p.getParameters(), "gain", "Gain"),
     intensityKnob(p.getParameters(), "intensity", "Intensity"),
@@ -22,6 +22,13 @@ GraphverbEditor::GraphverbEditor(Graphverb &p) :
     addAndMakeVisible(clusterVisualizer);
     addAndMakeVisible(bypassButton);
     addAndMakeVisible(expandButton);
+    addChildComponent(telemetryOverlay);
+    clusterVisualizer.addMouseListener(this, false);
+
+    /// The scope's sample and spectrum arrays live inside the editor; its FFT
+    /// and window are shared and accounted by SharedTables
+    processor.getMemoryTracker().setBytes(MemoryTracker::Subsystem::editor,
+                                          sizeof(GraphverbEditor));
 
     setSize(450, 200);
     setResizable(true, true);
@@ -29,6 +36,14 @@ GraphverbEditor::GraphverbEditor(Graphverb &p) :
     startTimerHz(60);
 }
 
+/**
+ * @brief Destructor for the GraphVerbEditor.
+ */
+GraphverbEditor::~GraphverbEditor() {
+    clusterVisualizer.removeMouseListener(this);
+    processor.getMemoryTracker().setBytes(MemoryTracker::Subsystem::editor, 0);
+}
+
 /**
  * @brief Paint the editor's background.
  * @param g The graphics context used for painting.
@@ -62,6 +77,19 @@ void GraphverbEditor::resized() {
     scope.setBounds(clusterVisualizerArea.reduced(10));
     clusterEnergy.setBounds(clusterVisualizerArea.reduced(10));
     clusterVisualizer.setBounds(clusterArea.reduced(10));
+    telemetryOverlay.setBounds(getLocalBounds().reduced(10));
+}
+
+/**
+ * @brief Toggle the telemetry overlay on a double-click of the cluster
+ * visualizer.
+ * @param event The mouse event.
+ */
+void GraphverbEditor::mouseDoubleClick(const juce::MouseEvent &event) {
+    if (event.eventComponent == &clusterVisualizer) {
+        telemetryOverlay.setVisible(!telemetryOverlay.isVisible());
+        telemetryOverlay.toFront(false);
+    }
 }
 
 /**
@@ -0,0 +1,174 @@
+#include "ImpulseCapture.h"
+
+/**
+ * @brief Ask for a capture.
+ * @param request The reverb bank.
+ * @return True if the capture was queued.
+ */
+bool ImpulseCapture::request(const Request &request) {
+    int current = phase.load(std::memory_order_acquire);
+    /// A capture cancelled just as it finished is dropped here
+    if (current == ready) {
+        phase.store(idle, std::memory_order_relaxed);
+        current = idle;
+    }
+    if (current != idle)
+        return false;
+    pending = request;
+    cancelled.store(false, std::memory_order_relaxed);
+    phase.store(requested, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Drop the capture being rendered or waiting.
+ */
+void ImpulseCapture::cancel() {
+    int expected = ready;
+    if (!phase.compare_exchange_strong(expected, idle,
+                                       std::memory_order_acq_rel))
+        cancelled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Hand a finished capture to a convolution, if it was rendered for the
+ * given format.
+ *
+ * The impulse response is moved into the convolution, which builds its
+ * partitions on its own background thread.
+ *
+ * @param convolution The convolution, prepared for the format.
+ * @param sampleRate The sample rate the convolution runs at.
+ * @param numChannels The number of channels it runs with.
+ * @return True if an impulse response was loaded.
+ */
+bool ImpulseCapture::loadInto(juce::dsp::Convolution &convolution,
+                              const double sampleRate, const int numChannels) {
+    if (phase.load(std::memory_order_acquire) != ready)
+        return false;
+    /// Rendered for a state that has since been replaced
+    if (pending.sampleRate != sampleRate ||
+        pending.numChannels != numChannels) {
+        phase.store(idle, std::memory_order_release);
+        return false;
+    }
+    directGain = renderedDirectGain;
+    impulseLength = impulse.getNumSamples();
+    convolution.loadImpulseResponse(
+            std::move(impulse), sampleRate,
+            numChannels > 1 ? juce::dsp::Convolution::Stereo::yes
+                            : juce::dsp::Convolution::Stereo::no,
+            juce::dsp::Convolution::Trim::no,
+            juce::dsp::Convolution::Normalise::no);
+    phase.store(idle, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Render the next slice of the requested capture, if any.
+ */
+void ImpulseCapture::renderIfRequested() {
+    const int current = phase.load(std::memory_order_acquire);
+    if (current != requested && current != rendering)
+        return;
+    if (cancelled.exchange(false, std::memory_order_relaxed)) {
+        phase.store(idle, std::memory_order_release);
+        return;
+    }
+    if (current == requested) {
+        beginRender();
+        phase.store(rendering, std::memory_order_relaxed);
+        return;
+    }
+    if (renderSlice()) {
+        finishRender();
+        phase.store(ready, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Set up the copies of the reverbs and the buffers for the pending
+ * capture.
+ *
+ * Setting the sample rate after the parameters skips the parameter smoothing,
+ * so the copies start out exactly as the reverbs they stand for have settled.
+ */
+void ImpulseCapture::beginRender() {
+    const int numChannels = pending.numChannels;
+    while (static_cast<int>(voices.size()) < pending.numVoices)
+        voices.push_back(std::make_unique<juce::Reverb>());
+    for (int v = 0; v < pending.numVoices; ++v) {
+        juce::Reverb &voice = *voices[static_cast<size_t>(v)];
+        voice.setParameters(pending.parameters[static_cast<size_t>(v)]);
+        voice.setSampleRate(pending.sampleRate);
+        voice.reset();
+    }
+    const auto length =
+            static_cast<int>(std::ceil(maxSeconds * pending.sampleRate));
+    impulse.setSize(numChannels, length, false, false, true);
+    impulse.clear();
+    scratch.setSize(numChannels, sliceSamples, false, false, true);
+    rendered = 0;
+    memoryBytes.store(
+            static_cast<size_t>(numChannels) *
+                    static_cast<size_t>(length + sliceSamples) *
+                    sizeof(float) +
+                    voices.size() * sizeof(juce::Reverb),
+            std::memory_order_relaxed);
+}
+
+/**
+ * @brief Render one slice of the capture.
+ * @return True if the impulse response is complete: it has reached the
+ * longest length, or a slice came out silent.
+ */
+bool ImpulseCapture::renderSlice() {
+    const int numChannels = pending.numChannels;
+    const int numSamples =
+            juce::jmin(sliceSamples, impulse.getNumSamples() - rendered);
+    for (int v = 0; v < pending.numVoices; ++v) {
+        const float weight = pending.weights[static_cast<size_t>(v)];
+        if (weight == 0.0f)
+            continue;
+        juce::Reverb &voice = *voices[static_cast<size_t>(v)];
+        scratch.clear();
+        if (rendered == 0)
+            scratch.setSample(0, 0, 1.0f);
+        if (numChannels > 1)
+            voice.processStereo(scratch.getWritePointer(0),
+                                scratch.getWritePointer(1), numSamples);
+        else
+            voice.processMono(scratch.getWritePointer(0), numSamples);
+        for (int ch = 0; ch < numChannels; ++ch)
+            impulse.addFrom(ch, rendered, scratch, ch, 0, numSamples, weight);
+    }
+    float peak = 0.0f;
+    for (int ch = 0; ch < numChannels; ++ch)
+        peak = juce::jmax(peak, impulse.getMagnitude(ch, rendered, numSamples));
+    /// The first slice is never silent: it holds the direct path
+    rendered += numSamples;
+    return rendered >= impulse.getNumSamples() || peak < silenceLevel;
+}
+
+/**
+ * @brief Split off the direct path and trim the impulse response.
+ *
+ * Each reverb adds its dry signal to the channel it came in on, so it cannot
+ * be convolved with the summed input like the rest. The combs delay the wet
+ * part by over a thousand samples, so the first sample of the impulse channel
+ * is the direct path alone; it is taken out and applied as a gain instead. A
+ * response cut off at the longest length is faded out, so the cut does not
+ * ring through the convolution.
+ */
+void ImpulseCapture::finishRender() {
+    renderedDirectGain = impulse.getSample(0, 0);
+    impulse.setSample(0, 0, 0.0f);
+    if (rendered >= impulse.getNumSamples()) {
+        const int fadeSamples = juce::jmin(
+                rendered, static_cast<int>(0.05 * pending.sampleRate));
+        for (int ch = 0; ch < impulse.getNumChannels(); ++ch)
+            impulse.applyGainRamp(ch, rendered - fadeSamples, fadeSamples,
+                                  1.0f, 0.0f);
+    }
+    impulse.setSize(impulse.getNumChannels(), rendered, true, false, true);
+}
@@ -0,0 +1,581 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <iostream>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include "AnalysisCaptureWriter.h"
+#include "AnalysisConfig.h"
+#include "CommunityClustering.h"
+#include "HarnessUtils.h"
+#include "SampleSanitiser.h"
+#include "SpectralAnalyzer.h"
+#include "SpectralGraph.h"
+
+namespace {
+    /**
+     * @brief The analysis of one frame.
+     */
+    struct FrameResult {
+        std::vector<float> magnitudes;
+        /** Cluster of each bin */
+        std::vector<int> assignments;
+        std::vector<Centroid> centroids;
+        /** Mean magnitude of each cluster, normalised to sum to one */
+        std::vector<float> energies;
+        int iterations = 0;
+        float stageMicroseconds[AnalysisCapture::numStages]{};
+    };
+
+    /**
+     * @brief The analysis of a run of consecutive frames.
+     */
+    struct ChunkResult {
+        /** Index of the first frame in the file */
+        int64_t firstFrame = 0;
+        std::vector<FrameResult> frames;
+        /** Centroids after the frame before the first, from the warm-up */
+        std::vector<Centroid> seamCentroids;
+        bool failed = false;
+    };
+
+    /**
+     * @brief How a file is split up and analysed.
+     */
+    struct Settings {
+        AnalysisConfig config;
+        /** Frames analysed, and output, per chunk */
+        int chunkFrames = 256;
+        /** Frames analysed before a chunk, so its clustering starts warm */
+        int warmupFrames = 16;
+        int numThreads = 1;
+    };
+
+    /**
+     * @brief Get the time elapsed since a point, in microseconds.
+     * @param start The point.
+     * @return The elapsed time.
+     */
+    float elapsedMicroseconds(
+            const std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<float, std::micro>(
+                       std::chrono::steady_clock::now() - start)
+                .count();
+    }
+
+    /**
+     * @brief Open an audio file, mapped into memory if its format allows,
+     * otherwise streamed.
+     * @param file The file.
+     * @return The reader, or null if the file could not be read.
+     */
+    std::unique_ptr<juce::AudioFormatReader>
+    openReader(const juce::File &file) {
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        if (auto *format =
+                    formats.findFormatForFileExtension(file.getFileExtension()))
+            if (std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(
+                        format->createMemoryMappedReader(file));
+                mapped != nullptr && mapped->mapEntireFile())
+                return mapped;
+        return std::unique_ptr<juce::AudioFormatReader>(
+                formats.createReaderFor(file));
+    }
+
+    /**
+     * @brief Get the number of whole frames in a number of samples.
+     * @param numSamples The number of samples.
+     * @param config The analysis configuration.
+     * @return The number of frames.
+     */
+    int64_t countFrames(const int64_t numSamples,
+                        const AnalysisConfig &config) {
+        const int fftSize = config.getFftSize();
+        if (numSamples < fftSize)
+            return 0;
+        return (numSamples - fftSize) / config.hopSize + 1;
+    }
+
+    /**
+     * @brief Map a centroid to the space the clustering measures distances
+     * in.
+     * @param centroid The centroid.
+     * @return The log frequency and the magnitude in decibels.
+     */
+    std::pair<float, float> toFeatures(const Centroid &centroid) {
+        return {std::log(centroid.frequency + 1e-6f),
+                20.0f * std::log10(centroid.magnitude + 1e-6f)};
+    }
+
+    /**
+     * @brief Analyse a chunk of a file, from a cold start a few frames before
+     * it.
+     *
+     * Frame i of the file is the window starting at sample i * hopSize, so a
+     * fresh analyzer fed from there produces exactly the spectra of a
+     * sequential run; only the clustering's starting centroids differ, which
+     * the warm-up frames make up for.
+     *
+     * @param reader The file, opened for this thread.
+     * @param settings The analysis settings.
+     * @param firstFrame Index of the chunk's first frame.
+     * @param endFrame Index of the frame after the chunk's last.
+     * @return The chunk.
+     */
+    ChunkResult analyseChunk(juce::AudioFormatReader &reader,
+                             const Settings &settings, const int64_t firstFrame,
+                             const int64_t endFrame) {
+        const AnalysisConfig &config = settings.config;
+        const int fftSize = config.getFftSize();
+        const int hopSize = config.hopSize;
+        const int64_t startFrame =
+                std::max<int64_t>(0, firstFrame - settings.warmupFrames);
+        const auto numSamples = static_cast<int>(
+                (endFrame - 1 - startFrame) * hopSize + fftSize);
+
+        ChunkResult chunk;
+        chunk.firstFrame = firstFrame;
+        const int numChannels = static_cast<int>(reader.numChannels);
+        juce::AudioBuffer<float> buffer(numChannels, numSamples);
+        if (!reader.read(&buffer, 0, numSamples, startFrame * hopSize, true,
+                         true)) {
+            chunk.failed = true;
+            return chunk;
+        }
+        /// Downmixed the way the plugin feeds its analysis
+        std::vector<float> mono(static_cast<size_t>(numSamples));
+        std::copy_n(buffer.getReadPointer(0), numSamples, mono.begin());
+        for (int ch = 1; ch < numChannels; ++ch)
+            juce::FloatVectorOperations::add(mono.data(),
+                                             buffer.getReadPointer(ch),
+                                             numSamples);
+        if (numChannels > 1)
+            juce::FloatVectorOperations::multiply(
+                    mono.data(), 1.0f / static_cast<float>(numChannels),
+                    numSamples);
+        SampleSanitiser::sanitise(mono.data(), numSamples);
+
+        SpectralAnalyzer analyzer(config.fftOrder, hopSize);
+        SpectralGraph graph;
+        std::vector<Centroid> centroids;
+        const int numClusters = config.numClusters;
+        chunk.frames.reserve(static_cast<size_t>(endFrame - firstFrame));
+        for (int64_t frame = startFrame; frame < endFrame; ++frame) {
+            FrameResult result;
+            auto start = std::chrono::steady_clock::now();
+            if (frame == startFrame)
+                analyzer.pushSamples(mono.data(), fftSize);
+            else
+                analyzer.pushSamples(
+                        mono.data() + (frame - startFrame - 1) * hopSize +
+                                fftSize,
+                        hopSize);
+            result.stageMicroseconds[AnalysisCapture::spectral] =
+                    elapsedMicroseconds(start);
+            start = std::chrono::steady_clock::now();
+            graph.buildGraph(analyzer.getLatestMagnitudes(),
+                             static_cast<float>(reader.sampleRate), fftSize);
+            result.stageMicroseconds[AnalysisCapture::graph] =
+                    elapsedMicroseconds(start);
+            start = std::chrono::steady_clock::now();
+            result.assignments = CommunityClustering::clusterNodes(
+                    graph.nodes, centroids, numClusters, config.maxIterations,
+                    &result.iterations);
+            result.stageMicroseconds[AnalysisCapture::clustering] =
+                    elapsedMicroseconds(start);
+            if (frame == firstFrame - 1)
+                chunk.seamCentroids = centroids;
+            if (frame < firstFrame)
+                continue;
+
+            start = std::chrono::steady_clock::now();
+            std::vector counts(static_cast<size_t>(numClusters), 0);
+            result.energies.assign(static_cast<size_t>(numClusters), 0.0f);
+            for (size_t i = 0; i < graph.nodes.size(); ++i) {
+                result.energies[result.assignments[i]] +=
+                        graph.nodes[i].magnitude;
+                counts[result.assignments[i]]++;
+            }
+            for (int i = 0; i < numClusters; ++i)
+                if (counts[i] > 0)
+                    result.energies[i] /= static_cast<float>(counts[i]);
+            if (const float energySum = std::accumulate(
+                        result.energies.begin(), result.energies.end(), 0.0f);
+                energySum > 0.0f)
+                for (float &energy: result.energies)
+                    energy /= energySum;
+            result.magnitudes = analyzer.getLatestMagnitudes();
+            result.centroids = centroids;
+            result.stageMicroseconds[AnalysisCapture::publish] =
+                    elapsedMicroseconds(start);
+            chunk.frames.push_back(std::move(result));
+        }
+        return chunk;
+    }
+
+    /**
+     * @brief Relabel a chunk's clusters to follow on from the previous
+     * chunk's, as a sequential run would have kept them.
+     *
+     * Both chunks clustered the frame before this chunk, so its centroids
+     * from the warm-up are paired greedily, nearest first, with the previous
+     * chunk's last centroids, and every frame of the chunk is relabelled
+     * accordingly.
+     *
+     * @param chunk The chunk.
+     * @param previous The previous chunk's last centroids, already relabelled.
+     */
+    void alignChunk(ChunkResult &chunk, const std::vector<Centroid> &previous) {
+        const size_t k = previous.size();
+        if (k == 0 || chunk.seamCentroids.size() != k)
+            return;
+        std::vector<std::tuple<float, size_t, size_t>> pairs;
+        pairs.reserve(k * k);
+        for (size_t from = 0; from < k; ++from)
+            for (size_t to = 0; to < k; ++to) {
+                const auto [fromLogFrequency, fromDecibels] =
+                        toFeatures(chunk.seamCentroids[from]);
+                const auto [toLogFrequency, toDecibels] =
+                        toFeatures(previous[to]);
+                const float dx = fromLogFrequency - toLogFrequency;
+                const float dy = fromDecibels - toDecibels;
+                pairs.emplace_back(dx * dx + dy * dy, from, to);
+            }
+        std::ranges::sort(pairs);
+        std::vector<int> label(k, -1);
+        std::vector taken(k, false);
+        for (const auto &[distance, from, to]: pairs)
+            if (label[from] < 0 && !taken[to]) {
+                label[from] = static_cast<int>(to);
+                taken[to] = true;
+            }
+
+        for (FrameResult &frame: chunk.frames) {
+            for (int &assignment: frame.assignments)
+                assignment = label[static_cast<size_t>(assignment)];
+            const std::vector<Centroid> centroids = frame.centroids;
+            const std::vector<float> energies = frame.energies;
+            for (size_t from = 0; from < k; ++from) {
+                frame.centroids[static_cast<size_t>(label[from])] =
+                        centroids[from];
+                frame.energies[static_cast<size_t>(label[from])] =
+                        energies[from];
+            }
+        }
+    }
+
+    /**
+     * @brief Writes frames to a comma-separated file, one row per frame.
+     */
+    class CsvSink {
+    public:
+        /**
+         * @brief Constructor for the CsvSink. Writes the header row.
+         * @param file The file, replaced.
+         * @param numClusters The number of clusters.
+         * @param numBins The number of bins.
+         */
+        CsvSink(const juce::File &file, const int numClusters,
+                const int numBins) :
+            stream(file) {
+            if (!stream.openedOk() || !stream.setPosition(0) ||
+                !stream.truncate().wasOk())
+                return;
+            stream << "frame,sample_position,iterations";
+            for (int i = 0; i < numClusters; ++i)
+                stream << ",energy_" << i;
+            for (int i = 0; i < numClusters; ++i)
+                stream << ",frequency_" << i << ",magnitude_" << i;
+            for (int i = 0; i < numBins; ++i)
+                stream << ",bin_" << i;
+            stream << "\n";
+        }
+
+        /**
+         * @brief Check if the file could be opened.
+         * @return True if it was.
+         */
+        [[nodiscard]] bool isOpen() const { return stream.openedOk(); }
+
+        /**
+         * @brief Append a frame.
+         * @param index Index of the frame in the file.
+         * @param samplePosition Number of samples up to the frame's end.
+         * @param frame The frame.
+         */
+        void write(const int64_t index, const int64_t samplePosition,
+                   const FrameResult &frame) {
+            stream << static_cast<juce::int64>(index) << ","
+                   << static_cast<juce::int64>(samplePosition) << ","
+                   << frame.iterations;
+            for (const float energy: frame.energies)
+                stream << "," << juce::String(energy, 6);
+            for (const Centroid &centroid: frame.centroids)
+                stream << "," << juce::String(centroid.frequency, 2) << ","
+                       << juce::String(centroid.magnitude, 6);
+            for (const int assignment: frame.assignments)
+                stream << "," << assignment;
+            stream << "\n";
+        }
+
+        /**
+         * @brief Flush the file.
+         * @return True if everything was written.
+         */
+        bool finish() {
+            stream.flush();
+            return stream.getStatus().wasOk();
+        }
+
+    private:
+        juce::FileOutputStream stream;
+    };
+
+    /**
+     * @brief Analyse one file and write its frames.
+     *
+     * Chunks are analysed by a pool of threads, each with its own reader,
+     * while this thread relabels and writes them in order. At most a few
+     * chunks per thread are held at once, so memory does not grow with the
+     * length of the file.
+     *
+     * @param input The audio file.
+     * @param output The file to write, a capture if it ends in .gvcap and a
+     * comma-separated file otherwise.
+     * @param settings The analysis settings.
+     * @return True on success.
+     */
+    bool analyseFile(const juce::File &input, const juce::File &output,
+                     const Settings &settings) {
+        const std::unique_ptr<juce::AudioFormatReader> probe =
+                openReader(input);
+        if (probe == nullptr || probe->numChannels == 0) {
+            std::cerr << "Could not read " << input.getFullPathName()
+                      << std::endl;
+            return false;
+        }
+        const AnalysisConfig &config = settings.config;
+        const double sampleRate = probe->sampleRate;
+        const int64_t numFrames = countFrames(probe->lengthInSamples, config);
+        if (numFrames == 0) {
+            std::cerr << input.getFullPathName()
+                      << " is shorter than one frame" << std::endl;
+            return false;
+        }
+        const int64_t numChunks =
+                (numFrames + settings.chunkFrames - 1) / settings.chunkFrames;
+        const int numBins = config.getFftSize() / 2;
+
+        std::unique_ptr<AnalysisCaptureWriter> capture;
+        std::unique_ptr<CsvSink> csv;
+        if (output.hasFileExtension("gvcap"))
+            capture = AnalysisCaptureWriter::create(
+                    output, numBins, config.numClusters,
+                    static_cast<uint64_t>(numFrames));
+        else
+            csv = std::make_unique<CsvSink>(output, config.numClusters,
+                                            numBins);
+        if (csv != nullptr && !csv->isOpen())
+            csv.reset();
+        if (capture == nullptr && csv == nullptr) {
+            std::cerr << "Could not write " << output.getFullPathName()
+                      << std::endl;
+            return false;
+        }
+
+        const auto startTime = HarnessUtils::Clock::now();
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::vector<std::unique_ptr<ChunkResult>> chunks(
+                static_cast<size_t>(numChunks));
+        int64_t nextChunk = 0;
+        int64_t nextToWrite = 0;
+        bool aborted = false;
+        const int64_t maxInFlight = 2 * settings.numThreads;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < settings.numThreads; ++t)
+            threads.emplace_back([&] {
+                const std::unique_ptr<juce::AudioFormatReader> reader =
+                        openReader(input);
+                juce::ScopedNoDenormals noDenormals;
+                while (true) {
+                    int64_t index;
+                    {
+                        std::unique_lock lock(mutex);
+                        changed.wait(lock, [&] {
+                            return aborted || nextChunk >= numChunks ||
+                                   nextChunk < nextToWrite + maxInFlight;
+                        });
+                        if (aborted || nextChunk >= numChunks)
+                            return;
+                        index = nextChunk++;
+                    }
+                    const int64_t first = index * settings.chunkFrames;
+                    auto chunk = std::make_unique<ChunkResult>();
+                    if (reader == nullptr)
+                        chunk->failed = true;
+                    else
+                        *chunk = analyseChunk(
+                                *reader, settings, first,
+                                std::min(first + settings.chunkFrames,
+                                         numFrames));
+                    std::lock_guard lock(mutex);
+                    chunks[static_cast<size_t>(index)] = std::move(chunk);
+                    changed.notify_all();
+                }
+            });
+
+        std::vector<Centroid> previousCentroids;
+        bool failed = false;
+        for (int64_t index = 0; index < numChunks && !failed; ++index) {
+            std::unique_ptr<ChunkResult> chunk;
+            {
+                std::unique_lock lock(mutex);
+                changed.wait(lock, [&] {
+                    return chunks[static_cast<size_t>(index)] != nullptr;
+                });
+                chunk = std::move(chunks[static_cast<size_t>(index)]);
+            }
+            if (chunk->failed) {
+                std::cerr << "Could not read " << input.getFullPathName()
+                          << std::endl;
+                failed = true;
+                break;
+            }
+            alignChunk(*chunk, previousCentroids);
+            for (size_t i = 0; i < chunk->frames.size(); ++i) {
+                const FrameResult &frame = chunk->frames[i];
+                const auto frameIndex =
+                        chunk->firstFrame + static_cast<int64_t>(i);
+                const int64_t samplePosition =
+                        frameIndex * config.hopSize + config.getFftSize();
+                if (csv != nullptr) {
+                    csv->write(frameIndex, samplePosition, frame);
+                    continue;
+                }
+                AnalysisCaptureWriter::Frame record;
+                record.samplePosition = static_cast<uint64_t>(samplePosition);
+                record.sampleRate = sampleRate;
+                record.fftSize = config.getFftSize();
+                record.hopSize = config.hopSize;
+                record.magnitudes = frame.magnitudes.data();
+                record.numBins = static_cast<int>(frame.magnitudes.size());
+                record.assignments = frame.assignments.data();
+                record.centroids = frame.centroids.data();
+                record.energies = frame.energies.data();
+                record.numClusters = config.numClusters;
+                record.iterations = frame.iterations;
+                record.stageMicroseconds = frame.stageMicroseconds;
+                capture->append(record);
+            }
+            if (!chunk->frames.empty())
+                previousCentroids = chunk->frames.back().centroids;
+            std::lock_guard lock(mutex);
+            ++nextToWrite;
+            changed.notify_all();
+        }
+        {
+            std::lock_guard lock(mutex);
+            aborted = true;
+            changed.notify_all();
+        }
+        for (auto &thread: threads)
+            thread.join();
+        if (failed || (csv != nullptr && !csv->finish())) {
+            std::cerr << "Could not write " << output.getFullPathName()
+                      << std::endl;
+            return false;
+        }
+
+        const double seconds =
+                std::chrono::duration<double>(HarnessUtils::Clock::now() -
+                                              startTime)
+                        .count();
+        const double audioSeconds =
+                static_cast<double>(probe->lengthInSamples) / sampleRate;
+        std::cout << input.getFileName() << ": " << numFrames << " frames in "
+                  << numChunks << " chunks, " << seconds << " s ("
+                  << audioSeconds / std::max(seconds, 1.0e-9)
+                  << "x real time) -> " << output.getFullPathName()
+                  << std::endl;
+        return true;
+    }
+} // namespace
+
+/**
+ * @brief Runs the analysis pipeline alone over audio files and exports the
+ * cluster timeline of each.
+ *
+ * Every frame's cluster assignments, centroids and energies are written to a
+ * comma-separated file, or with --format=capture to an analysis capture that
+ * AnalysisCaptureReader reads and the plugin can replay. Each file is split
+ * into chunks of frames analysed in parallel; a chunk starts its clustering
+ * a few frames early and its cluster labels are matched to the previous
+ * chunk's, so the timeline has no seams. Audio files whose format supports it
+ * are memory-mapped, others are streamed.
+ *
+ * Usage: graphverb_analyze <file>... [--out-dir=path] [--format=csv|capture]
+ *                          [--fft=N] [--hop=N] [--clusters=K]
+ *                          [--iterations=N] [--threads=N] [--chunk=N]
+ *                          [--warmup=N]
+ */
+int main(int argc, char *argv[]) {
+    const juce::ArgumentList args(argc, argv);
+    Settings settings;
+    AnalysisConfig &config = settings.config;
+    const int fftSize = HarnessUtils::getIntOption(args, "--fft", 1024);
+    config.fftOrder = juce::jlimit(6, 15, juce::roundToInt(std::log2(fftSize)));
+    config.hopSize = juce::jlimit(
+            1, config.getFftSize(),
+            HarnessUtils::getIntOption(args, "--hop",
+                                       config.getFftSize() / 2));
+    config.numClusters = juce::jlimit(
+            1, 255, HarnessUtils::getIntOption(args, "--clusters", 12));
+    config.maxIterations = juce::jmax(
+            1, HarnessUtils::getIntOption(args, "--iterations", 100));
+    settings.numThreads = juce::jmax(
+            1, HarnessUtils::getIntOption(
+                       args, "--threads",
+                       juce::SystemStats::getNumCpus()));
+    settings.chunkFrames =
+            juce::jmax(1, HarnessUtils::getIntOption(args, "--chunk", 256));
+    settings.warmupFrames =
+            juce::jmax(1, HarnessUtils::getIntOption(args, "--warmup", 16));
+    const juce::String extension =
+            args.getValueForOption("--format") == "capture" ? ".gvcap"
+                                                            : ".csv";
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    int numInputs = 0;
+    bool failed = false;
+    for (const auto &argument: args.arguments) {
+        if (argument.isOption())
+            continue;
+        const juce::File input = argument.resolveAsFile();
+        const juce::File directory =
+                args.containsOption("--out-dir")
+                        ? args.getFileForOption("--out-dir")
+                        : input.getParentDirectory();
+        directory.createDirectory();
+        const juce::File output = directory.getChildFile(
+                input.getFileNameWithoutExtension() + extension);
+        failed |= !analyseFile(input, output, settings);
+        ++numInputs;
+    }
+    if (numInputs == 0) {
+        std::cerr << "Usage: graphverb_analyze <file>... [--out-dir=path] "
+                     "[--format=csv|capture] [--fft=N] [--hop=N] "
+                     "[--clusters=K] [--iterations=N] [--threads=N] "
+                     "[--chunk=N] [--warmup=N]"
+                  << std::endl;
+        return 1;
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,58 @@
+#include <iostream>
+#include "HarnessUtils.h"
+#include "KernelAutotuner.h"
+
+/**
+ * @brief Runs the kernel autotuner on demand.
+ *
+ * The plugin tunes automatically the first time it is prepared for a
+ * configuration on a machine. This tool re-tunes with a longer timing budget,
+ * prints the timing of every kernel variant and replaces the cache entry, e.g.
+ * after a CPU microcode or compiler update.
+ *
+ * Usage: graphverb_autotune [--rate=R] [--block=N] [--fft=N] [--clusters=K]
+ *                           [--seconds=S] [--cache=path] [--dry-run]
+ */
+int main(int argc, char *argv[]) {
+    const juce::ArgumentList args(argc, argv);
+    KernelAutotuner::Config config;
+    config.sampleRate = HarnessUtils::getDoubleOption(args, "--rate", 48000);
+    config.blockSize = HarnessUtils::getIntOption(args, "--block", 512);
+    config.fftSize = HarnessUtils::getIntOption(args, "--fft", 1024);
+    config.numClusters = HarnessUtils::getIntOption(args, "--clusters", 12);
+    const double seconds =
+            HarnessUtils::getDoubleOption(args, "--seconds", 0.05);
+    const juce::File cacheFile =
+            args.containsOption("--cache")
+                    ? juce::File::getCurrentWorkingDirectory().getChildFile(
+                              args.getValueForOption("--cache"))
+                    : KernelAutotuner::getDefaultCacheFile();
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    std::cout << juce::SystemStats::getCpuVendor() << " "
+              << juce::SystemStats::getCpuModel() << ", automatic choice "
+              << Kernels::getName(Kernels::getActiveIsa()) << std::endl;
+    KernelAutotuner::Timings timings;
+    const auto choice = KernelAutotuner::tune(config, seconds, &timings);
+    for (int kernel = 0; kernel < Kernels::numKernels; ++kernel) {
+        std::cout << juce::String(KernelAutotuner::getKernelName(kernel))
+                             .paddedRight(' ', 16);
+        for (int i = 0; i < static_cast<int>(Kernels::Isa::count); ++i)
+            if (const double time = timings[kernel][static_cast<size_t>(i)];
+                time > 0.0)
+                std::cout << Kernels::getName(static_cast<Kernels::Isa>(i))
+                          << " " << time * 1.0e6 << " us   ";
+        std::cout << "-> " << Kernels::getName(choice[kernel]) << std::endl;
+    }
+
+    if (args.containsOption("--dry-run"))
+        return 0;
+    if (!KernelAutotuner::save(cacheFile, config, choice)) {
+        std::cerr << "Could not write " << cacheFile.getFullPathName()
+                  << std::endl;
+        return 1;
+    }
+    std::cout << "Saved to " << cacheFile.getFullPathName() << std::endl;
+    return 0;
+}
@@ -0,0 +1,572 @@
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <thread>
+#include "AnalysisWorker.h"
+#include "Graphverb.h"
+#include "HarnessUtils.h"
+#include "KernelAutotuner.h"
+#include "Kernels.h"
+#include "SampleSanitiser.h"
+#include "SharedTables.h"
+#include "TestSignalGenerator.h"
+
+/**
+ * @brief Offline benchmark for the Graphverb processor and analysis pipeline.
+ *
+ * Every scenario feeds the same amount of audio through a freshly prepared
+ * processor and, separately, through the analysis pipeline on the calling
+ * thread. The scenarios are the seeded test signal corpus, so numbers can be
+ * compared across machines, plus pathological denormal and non-finite inputs.
+ * Timings are compared against the white noise scenario so that denormal or
+ * non-finite slow paths show up as a ratio well above one. The processor's
+ * peak memory footprint is checked against a cap derived from the sample
+ * rate and block size, so a change that grows it noticeably fails the run.
+ * The processor is then run bypassed, and fails if that costs more than a
+ * fraction of processing.
+ * With --modal the processor renders the modal bank instead of the reverbs.
+ * Finally the analysis pipeline runs on --analysis-instances threads at once,
+ * as with several plugin instances, and fails if a block costs more than
+ * --max-ratio times what it costs on its own.
+ *
+ * Usage: graphverb_bench [--seconds=S] [--rate=R] [--block=N]
+ *                        [--max-ratio=R] [--max-footprint-kb=K]
+ *                        [--max-bypass-ratio=R] [--no-ftz] [--modal]
+ *                        [--analysis-instances=N] [--json=path]
+ */
+namespace {
+    /**
+     * @brief Fills a block of the scenario's input signal.
+     * @param buffer The buffer to fill; every channel gets the same signal.
+     * @param position The sample position of the first sample in the block.
+     * @param sampleRate The sample rate.
+     */
+    using SignalFunction = std::function<void(
+            juce::AudioBuffer<float> &buffer, juce::int64 position,
+            double sampleRate)>;
+
+    /**
+     * @brief A named input signal to benchmark.
+     */
+    struct Scenario {
+        juce::String name;
+        SignalFunction fill;
+    };
+
+    /**
+     * @brief Timings and counters measured for one scenario.
+     */
+    struct ScenarioResult {
+        juce::String name;
+        HarnessUtils::DurationStats processTimes;
+        HarnessUtils::DurationStats bypassTimes;
+        HarnessUtils::DurationStats analysisTimes;
+        juce::uint64 nonFiniteInputSamples = 0;
+        juce::uint64 nonFiniteOutputSamples = 0;
+        MemoryTracker::Snapshot memory;
+        size_t sharedTableBytes = 0;
+    };
+
+    /**
+     * @brief The footprint one stereo instance may peak at in a
+     * configuration, at the default analysis settings.
+     */
+    struct FootprintBudget {
+        int sampleRate;
+        int blockSize;
+        size_t kilobytes;
+    };
+
+    /**
+     * Pinned footprint budgets. These are budgets, not predictions: they were
+     * set with about 25% headroom over the footprint when they were last
+     * changed, and a subsystem that grows past them fails the run until they
+     * are raised here, on purpose, in the same change.
+     */
+    constexpr FootprintBudget footprintBudgets[] = {
+            {44100, 64, 3072},   {44100, 128, 2944},  {44100, 256, 2816},
+            {44100, 512, 2816},  {44100, 1024, 2944}, {44100, 2048, 3072},
+            {48000, 64, 3200},   {48000, 128, 3072},  {48000, 256, 2944},
+            {48000, 512, 2944},  {48000, 1024, 3072}, {48000, 2048, 3200},
+            {88200, 64, 5120},   {88200, 128, 4736},  {88200, 256, 4480},
+            {88200, 512, 4480},  {88200, 1024, 4480}, {88200, 2048, 4608},
+            {96000, 64, 5376},   {96000, 128, 4992},  {96000, 256, 4736},
+            {96000, 512, 4736},  {96000, 1024, 4736}, {96000, 2048, 4864},
+    };
+
+    /**
+     * @brief Get the pinned footprint budget of a configuration.
+     * @param sampleRate The sample rate.
+     * @param blockSize The block size.
+     * @return The budget in bytes, or nothing if none is pinned.
+     */
+    std::optional<size_t> getFootprintBudget(const double sampleRate,
+                                             const int blockSize) {
+        for (const FootprintBudget &budget: footprintBudgets)
+            if (budget.sampleRate == juce::roundToInt(sampleRate) &&
+                budget.blockSize == blockSize)
+                return budget.kilobytes * 1024;
+        return std::nullopt;
+    }
+
+    /**
+     * @brief Write the same value-generating function into every channel.
+     * @param buffer The buffer to fill.
+     * @param position The sample position of the first sample in the block.
+     * @param generator Function mapping a sample position to a value.
+     */
+    template<typename Generator>
+    void fillAllChannels(juce::AudioBuffer<float> &buffer,
+                         const juce::int64 position, Generator &&generator) {
+        for (int s = 0; s < buffer.getNumSamples(); ++s) {
+            const float value = generator(position + s);
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                buffer.setSample(ch, s, value);
+        }
+    }
+
+    /**
+     * @brief Create a signal function that streams a test corpus signal.
+     *
+     * The generator restarts whenever position zero is requested, so every
+     * pass over a scenario sees exactly the same input.
+     *
+     * @param name The corpus signal name.
+     * @return The signal function.
+     */
+    SignalFunction corpusSignal(const std::string &name) {
+        auto generator =
+                std::make_shared<std::unique_ptr<TestSignalGenerator>>();
+        return [name, generator](juce::AudioBuffer<float> &buffer,
+                                 const juce::int64 position,
+                                 const double sampleRate) {
+            if (position == 0 || *generator == nullptr)
+                *generator = std::make_unique<TestSignalGenerator>(
+                        TestSignalGenerator::getCorpusSettings(name,
+                                                               sampleRate));
+            (*generator)->generate(buffer.getWritePointer(0),
+                                   buffer.getNumSamples());
+            for (int ch = 1; ch < buffer.getNumChannels(); ++ch)
+                buffer.copyFrom(ch, 0, buffer, 0, 0, buffer.getNumSamples());
+        };
+    }
+
+    /**
+     * @brief Build the list of benchmark scenarios.
+     * @return The scenarios, with the white noise baseline first.
+     */
+    std::vector<Scenario> createScenarios() {
+        std::vector<Scenario> scenarios;
+        scenarios.push_back({"white-noise", corpusSignal("white-noise")});
+        for (const auto &name: TestSignalGenerator::getCorpusNames())
+            if (name != "white-noise")
+                scenarios.push_back({name, corpusSignal(name)});
+        /// A short burst followed by an exponential decay long enough to pass
+        /// through the whole denormal range before the next burst
+        scenarios.push_back(
+                {"decaying-tail", [](auto &buffer, auto position,
+                                     const double sampleRate) {
+                     juce::Random random(position);
+                     const auto period = static_cast<juce::int64>(6.0 *
+                                                                  sampleRate);
+                     fillAllChannels(buffer, position, [&](juce::int64 pos) {
+                         const double t = static_cast<double>(pos % period) /
+                                          sampleRate;
+                         const double envelope =
+                                 t < 0.1 ? 0.5 : 0.5 * std::exp(-(t - 0.1) /
+                                                                0.045);
+                         return static_cast<float>(
+                                 envelope * (2.0 * random.nextDouble() - 1.0));
+                     });
+                 }});
+        scenarios.push_back(
+                {"subnormal", [](auto &buffer, auto position, double) {
+                     juce::Random random(position);
+                     fillAllChannels(buffer, position, [&](juce::int64) {
+                         return std::numeric_limits<float>::denorm_min() *
+                                static_cast<float>(random.nextInt(1 << 20) -
+                                                   (1 << 19));
+                     });
+                 }});
+        scenarios.push_back(
+                {"non-finite", [](auto &buffer, auto position, double) {
+                     juce::Random random(position);
+                     fillAllChannels(buffer, position, [&](juce::int64 pos) {
+                         switch (pos % 331) {
+                             case 0:
+                                 return std::numeric_limits<float>::quiet_NaN();
+                             case 110:
+                                 return std::numeric_limits<float>::infinity();
+                             case 220:
+                                 return -std::numeric_limits<float>::infinity();
+                             default:
+                                 return 0.25f *
+                                        (2.0f * random.nextFloat() - 1.0f);
+                         }
+                     });
+                 }});
+        return scenarios;
+    }
+
+    /**
+     * @brief Run one scenario through a processor and the analysis pipeline.
+     * @param scenario The scenario to run.
+     * @param sampleRate The sample rate.
+     * @param blockSize The block size.
+     * @param numBlocks The number of blocks to process.
+     * @param useFtz Whether the analysis runs with FTZ/DAZ, as the worker does.
+     * @param useModes Whether the processor renders the modal bank.
+     * @return The measured timings and counters.
+     */
+    ScenarioResult runScenario(const Scenario &scenario,
+                               const double sampleRate, const int blockSize,
+                               const int numBlocks, const bool useFtz,
+                               const bool useModes) {
+        ScenarioResult result;
+        result.name = scenario.name;
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        juce::MidiBuffer midi;
+
+        /// Full processor, with the analysis worker running in the background
+        {
+            Graphverb processor;
+            processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+            processor.setModalReverb(useModes);
+            processor.prepareToPlay(sampleRate, blockSize);
+            for (int b = 0; b < numBlocks; ++b) {
+                scenario.fill(buffer, static_cast<juce::int64>(b) * blockSize,
+                              sampleRate);
+                const auto start = HarnessUtils::Clock::now();
+                processor.processBlock(buffer, midi);
+                result.processTimes.add(HarnessUtils::elapsedMicroseconds(
+                        start, HarnessUtils::Clock::now()));
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                    result.nonFiniteOutputSamples +=
+                            static_cast<juce::uint64>(SampleSanitiser::sanitise(
+                                    buffer.getWritePointer(ch), blockSize));
+            }
+            result.memory = processor.getMemoryFootprint();
+            result.sharedTableBytes = SharedTables::getMemoryBytes();
+
+            /// Bypassed by the host, without a tail, so every block takes the
+            /// steady bypass path
+            processor.setBypassBehaviour(false, 4);
+            for (int b = 0; b < numBlocks; ++b) {
+                scenario.fill(buffer, static_cast<juce::int64>(b) * blockSize,
+                              sampleRate);
+                const auto start = HarnessUtils::Clock::now();
+                processor.processBlockBypassed(buffer, midi);
+                result.bypassTimes.add(HarnessUtils::elapsedMicroseconds(
+                        start, HarnessUtils::Clock::now()));
+            }
+            processor.releaseResources();
+            result.nonFiniteInputSamples = processor.getNonFiniteInputSamples();
+        }
+
+        /// Analysis pipeline on this thread, measured per block
+        {
+            std::optional<juce::ScopedNoDenormals> noDenormals;
+            if (useFtz)
+                noDenormals.emplace();
+            AnalysisWorker worker(
+                    AnalysisConfig{10, 512, Graphverb::numClusters});
+            for (int b = 0; b < numBlocks; ++b) {
+                scenario.fill(buffer, static_cast<juce::int64>(b) * blockSize,
+                              sampleRate);
+                SampleSanitiser::sanitise(buffer.getWritePointer(0), blockSize);
+                const auto start = HarnessUtils::Clock::now();
+                worker.analyseBlock(buffer.getReadPointer(0), blockSize,
+                                    sampleRate);
+                result.analysisTimes.add(HarnessUtils::elapsedMicroseconds(
+                        start, HarnessUtils::Clock::now()));
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Run the analysis pipeline of several instances at once, one
+     * thread each, on white noise.
+     * @param sampleRate The sample rate.
+     * @param blockSize The block size.
+     * @param numBlocks The number of blocks each instance analyses.
+     * @param useFtz Whether to flush denormals to zero.
+     * @param numInstances The number of instances.
+     * @return The time of every block of every instance.
+     */
+    HarnessUtils::DurationStats
+    runConcurrentAnalysis(const double sampleRate, const int blockSize,
+                          const int numBlocks, const bool useFtz,
+                          const int numInstances) {
+        std::vector<HarnessUtils::DurationStats> times(
+                static_cast<size_t>(numInstances));
+        std::vector<std::thread> threads;
+        for (auto &instanceTimes: times) {
+            threads.emplace_back([&instanceTimes, sampleRate, blockSize,
+                                  numBlocks, useFtz] {
+                std::optional<juce::ScopedNoDenormals> noDenormals;
+                if (useFtz)
+                    noDenormals.emplace();
+                const SignalFunction fill = corpusSignal("white-noise");
+                juce::AudioBuffer<float> buffer(1, blockSize);
+                AnalysisWorker worker(
+                        AnalysisConfig{10, 512, Graphverb::numClusters});
+                for (int b = 0; b < numBlocks; ++b) {
+                    fill(buffer, static_cast<juce::int64>(b) * blockSize,
+                         sampleRate);
+                    const auto start = HarnessUtils::Clock::now();
+                    worker.analyseBlock(buffer.getReadPointer(0), blockSize,
+                                        sampleRate);
+                    instanceTimes.add(HarnessUtils::elapsedMicroseconds(
+                            start, HarnessUtils::Clock::now()));
+                }
+            });
+        }
+        for (auto &thread: threads)
+            thread.join();
+        HarnessUtils::DurationStats merged;
+        for (const auto &instanceTimes: times)
+            merged.merge(instanceTimes);
+        return merged;
+    }
+
+    /**
+     * @brief Convert duration statistics to a JSON object.
+     * @param stats The statistics to convert.
+     * @return The JSON object.
+     */
+    juce::var statsToJson(const HarnessUtils::DurationStats &stats) {
+        auto *object = new juce::DynamicObject();
+        object->setProperty("mean_us", stats.mean());
+        object->setProperty("p99_us", stats.percentile(99.0));
+        object->setProperty("max_us", stats.max());
+        return object;
+    }
+
+    /**
+     * @brief Convert a memory footprint snapshot to a JSON object.
+     * @param snapshot The snapshot to convert.
+     * @return The JSON object.
+     */
+    juce::var memoryToJson(const MemoryTracker::Snapshot &snapshot) {
+        auto *subsystems = new juce::DynamicObject();
+        for (size_t i = 0; i < MemoryTracker::numSubsystems; ++i) {
+            auto *subsystem = new juce::DynamicObject();
+            subsystem->setProperty("current", static_cast<juce::int64>(
+                                                      snapshot.current[i]));
+            subsystem->setProperty("peak", static_cast<juce::int64>(
+                                                   snapshot.peak[i]));
+            subsystems->setProperty(
+                    MemoryTracker::getName(
+                            static_cast<MemoryTracker::Subsystem>(i)),
+                    subsystem);
+        }
+        auto *queues = new juce::DynamicObject();
+        for (size_t i = 0; i < MemoryTracker::numQueues; ++i)
+            queues->setProperty(
+                    MemoryTracker::getName(static_cast<MemoryTracker::Queue>(i)),
+                    static_cast<juce::int64>(snapshot.queueHighWater[i]));
+        auto *object = new juce::DynamicObject();
+        object->setProperty("subsystems", subsystems);
+        object->setProperty("queue_high_water", queues);
+        object->setProperty("total_peak",
+                            static_cast<juce::int64>(snapshot.totalPeak));
+        return object;
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const juce::ArgumentList args(argc, argv);
+    const double seconds = HarnessUtils::getDoubleOption(args, "--seconds", 8);
+    const double sampleRate =
+            HarnessUtils::getDoubleOption(args, "--rate", 48000);
+    const int blockSize = HarnessUtils::getIntOption(args, "--block", 512);
+    const double maxRatio =
+            HarnessUtils::getDoubleOption(args, "--max-ratio", 2.0);
+    std::optional<size_t> footprintBudget =
+            getFootprintBudget(sampleRate, blockSize);
+    if (args.containsOption("--max-footprint-kb"))
+        footprintBudget = static_cast<size_t>(HarnessUtils::getIntOption(
+                                  args, "--max-footprint-kb", 0)) *
+                          1024;
+    if (!footprintBudget.has_value()) {
+        std::cerr << "No footprint budget is pinned for " << sampleRate
+                  << " Hz / " << blockSize
+                  << " samples; add one or pass --max-footprint-kb"
+                  << std::endl;
+        return 1;
+    }
+    const size_t maxFootprint = *footprintBudget;
+    /// Reported next to the budget, never used to set it
+    const size_t sizedFootprint = Graphverb::getSizedMemoryBytes(
+            sampleRate, 2, blockSize, AnalysisConfig{}.hopSize);
+    const double maxBypassRatio =
+            HarnessUtils::getDoubleOption(args, "--max-bypass-ratio", 0.1);
+    const bool useFtz = !args.containsOption("--no-ftz");
+    const bool useModes = args.containsOption("--modal");
+    /// No more threads than cores, so only contention inside the pipeline
+    /// shows up, not the scheduler
+    const int analysisInstances = std::clamp(
+            HarnessUtils::getIntOption(args, "--analysis-instances", 4), 1,
+            std::max(1, static_cast<int>(
+                                std::thread::hardware_concurrency())));
+    /// Not calibrated on enough machines to gate on by default, so it is
+    /// only reported unless a limit is given
+    std::optional<double> maxConcurrentRatio;
+    if (args.containsOption("--max-concurrent-ratio"))
+        maxConcurrentRatio = HarnessUtils::getDoubleOption(
+                args, "--max-concurrent-ratio", 0.0);
+    const int numBlocks = std::max(
+            1, static_cast<int>(seconds * sampleRate / blockSize));
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    std::cout << "kernels: " << Kernels::getName(Kernels::getActiveIsa())
+              << std::endl
+              << "footprint budget/sized (KB): " << maxFootprint / 1024
+              << " / " << sizedFootprint / 1024 << std::endl;
+    /// A run asked to time one variant must not quietly time another
+    if (Kernels::isForceRejected()) {
+        std::cerr << "FAIL: GRAPHVERB_FORCE_ISA names a variant this machine "
+                     "cannot run"
+                  << std::endl;
+        return 1;
+    }
+    std::vector<ScenarioResult> results;
+    for (const auto &scenario: createScenarios())
+        results.push_back(runScenario(scenario, sampleRate, blockSize,
+                                      numBlocks, useFtz, useModes));
+
+    bool failed = false;
+    const auto &baseline = results.front();
+    juce::Array<juce::var> scenarioJson;
+    std::cout << "scenario          process mean/p99 (us)   "
+                 "analysis mean/p99 (us)   ratio   peak (KB)" << std::endl;
+    for (const auto &result: results) {
+        const double processRatio =
+                result.processTimes.mean() / baseline.processTimes.mean();
+        const double analysisRatio =
+                result.analysisTimes.mean() / baseline.analysisTimes.mean();
+        const double ratio = std::max(processRatio, analysisRatio);
+        std::cout << result.name.paddedRight(' ', 18) << " "
+                  << result.processTimes.mean() << " / "
+                  << result.processTimes.percentile(99.0) << "   "
+                  << result.analysisTimes.mean() << " / "
+                  << result.analysisTimes.percentile(99.0) << "   " << ratio
+                  << "   " << result.memory.totalPeak / 1024 << std::endl;
+        if (ratio > maxRatio) {
+            std::cerr << "FAIL: " << result.name << " is " << ratio
+                      << "x slower than " << baseline.name << std::endl;
+            failed = true;
+        }
+        /// Medians, so the one crossfaded block does not count
+        if (const double bypassRatio = result.bypassTimes.percentile(50.0) /
+                                       result.processTimes.percentile(50.0);
+            bypassRatio > maxBypassRatio) {
+            std::cerr << "FAIL: " << result.name << " costs " << bypassRatio
+                      << "x of processing while bypassed" << std::endl;
+            failed = true;
+        }
+        if (result.nonFiniteOutputSamples > 0) {
+            std::cerr << "FAIL: " << result.name << " produced "
+                      << result.nonFiniteOutputSamples
+                      << " non-finite output samples" << std::endl;
+            failed = true;
+        }
+        if (result.memory.totalPeak > maxFootprint) {
+            std::cerr << "FAIL: " << result.name << " peaked at "
+                      << result.memory.totalPeak / 1024
+                      << " KB, over the " << maxFootprint / 1024
+                      << " KB footprint budget" << std::endl;
+            failed = true;
+        }
+
+        auto *object = new juce::DynamicObject();
+        object->setProperty("name", result.name);
+        object->setProperty("process", statsToJson(result.processTimes));
+        object->setProperty("bypass", statsToJson(result.bypassTimes));
+        object->setProperty("analysis", statsToJson(result.analysisTimes));
+        object->setProperty("ratio", ratio);
+        object->setProperty("non_finite_input_samples",
+                            static_cast<juce::int64>(
+                                    result.nonFiniteInputSamples));
+        object->setProperty("non_finite_output_samples",
+                            static_cast<juce::int64>(
+                                    result.nonFiniteOutputSamples));
+        object->setProperty("memory", memoryToJson(result.memory));
+        object->setProperty("shared_table_bytes",
+                            static_cast<juce::int64>(result.sharedTableBytes));
+        scenarioJson.add(object);
+    }
+
+    /// One instance has nothing to contend with
+    const auto concurrentTimes =
+            analysisInstances > 1
+                    ? runConcurrentAnalysis(sampleRate, blockSize, numBlocks,
+                                            useFtz, analysisInstances)
+                    : baseline.analysisTimes;
+    const double concurrentRatio =
+            concurrentTimes.mean() / baseline.analysisTimes.mean();
+    if (analysisInstances > 1)
+        std::cout << "analysis on " << analysisInstances
+                  << " instances mean/p99 (us): " << concurrentTimes.mean()
+                  << " / " << concurrentTimes.percentile(99.0)
+                  << "   ratio " << concurrentRatio << std::endl;
+    else
+        std::cout << "analysis on several instances skipped: one core or "
+                     "instance"
+                  << std::endl;
+    if (maxConcurrentRatio.has_value() && analysisInstances > 1 &&
+        concurrentRatio > *maxConcurrentRatio) {
+        std::cerr << "FAIL: analysis on " << analysisInstances
+                  << " instances is " << concurrentRatio
+                  << "x slower than on one" << std::endl;
+        failed = true;
+    }
+
+    /// Every run would pay for tuning again
+    const uint64_t failedCacheWrites = KernelAutotuner::getNumFailedSaves();
+    if (failedCacheWrites > 0) {
+        std::cerr << "FAIL: " << failedCacheWrites
+                  << " tuned kernel choices could not be cached in "
+                  << KernelAutotuner::getDefaultCacheFile().getFullPathName()
+                  << std::endl;
+        failed = true;
+    }
+
+    if (args.containsOption("--json")) {
+        auto *root = new juce::DynamicObject();
+        root->setProperty("sample_rate", sampleRate);
+        root->setProperty("block_size", blockSize);
+        root->setProperty("ftz", useFtz);
+        root->setProperty("modal", useModes);
+        root->setProperty("kernels",
+                          juce::String(Kernels::getName(
+                                  Kernels::getActiveIsa())));
+        root->setProperty("kernel_cache_write_failures",
+                          static_cast<juce::int64>(failedCacheWrites));
+        root->setProperty("max_footprint_bytes",
+                          static_cast<juce::int64>(maxFootprint));
+        root->setProperty("sized_footprint_bytes",
+                          static_cast<juce::int64>(sizedFootprint));
+        root->setProperty("max_bypass_ratio", maxBypassRatio);
+        root->setProperty("scenarios", scenarioJson);
+        auto *concurrent = new juce::DynamicObject();
+        concurrent->setProperty("instances", analysisInstances);
+        concurrent->setProperty("analysis", statsToJson(concurrentTimes));
+        concurrent->setProperty("ratio", concurrentRatio);
+        if (maxConcurrentRatio.has_value())
+            concurrent->setProperty("max_ratio", *maxConcurrentRatio);
+        root->setProperty("concurrent_analysis", concurrent);
+        const juce::File file = juce::File::getCurrentWorkingDirectory()
+                                        .getChildFile(args.getValueForOption(
+                                                "--json"));
+        if (!file.replaceWithText(juce::JSON::toString(juce::var(root)))) {
+            std::cerr << "Could not write " << file.getFullPathName()
+                      << std::endl;
+            failed = true;
+        }
+    }
+    return failed ? 1 : 0;
+}
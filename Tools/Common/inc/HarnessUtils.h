@@ -0,0 +1,175 @@
+#ifndef HARNESS_UTILS_H
+#define HARNESS_UTILS_H
+
+#include <algorithm>
+#include <chrono>
+#include <juce_core/juce_core.h>
+#include <vector>
+
+#if JUCE_LINUX
+#include <dirent.h>
+#elif JUCE_MAC
+#include <mach/mach.h>
+#endif
+
+/**
+ * @brief Small helpers shared by the headless harness and benchmark tools.
+ */
+namespace HarnessUtils {
+    /** Clock used for all harness timings. */
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Read an integer option such as "--instances=8".
+     * @param args The parsed command line.
+     * @param option The option name, including the leading dashes.
+     * @param fallback The value to use if the option is missing.
+     * @return The option value.
+     */
+    inline int getIntOption(const juce::ArgumentList &args,
+                            const juce::StringRef option, const int fallback) {
+        if (!args.containsOption(option))
+            return fallback;
+        return args.getValueForOption(option).getIntValue();
+    }
+
+    /**
+     * @brief Read a floating point option such as "--seconds=2.5".
+     * @param args The parsed command line.
+     * @param option The option name, including the leading dashes.
+     * @param fallback The value to use if the option is missing.
+     * @return The option value.
+     */
+    inline double getDoubleOption(const juce::ArgumentList &args,
+                                  const juce::StringRef option,
+                                  const double fallback) {
+        if (!args.containsOption(option))
+            return fallback;
+        return args.getValueForOption(option).getDoubleValue();
+    }
+
+    /**
+     * @brief Count the threads currently owned by this process.
+     * @return The number of threads, or -1 if the platform is unsupported.
+     */
+    inline int countProcessThreads() {
+#if JUCE_LINUX
+        int count = 0;
+        if (DIR *dir = opendir("/proc/self/task")) {
+            while (const dirent *entry = readdir(dir))
+                if (entry->d_name[0] != '.')
+                    ++count;
+            closedir(dir);
+        }
+        return count;
+#elif JUCE_MAC
+        thread_act_array_t threads;
+        mach_msg_type_number_t count = 0;
+        if (task_threads(mach_task_self(), &threads, &count) != KERN_SUCCESS)
+            return -1;
+        for (mach_msg_type_number_t i = 0; i < count; ++i)
+            mach_port_deallocate(mach_task_self(), threads[i]);
+        vm_deallocate(mach_task_self(),
+                      reinterpret_cast<vm_address_t>(threads),
+                      sizeof(thread_t) * count);
+        return static_cast<int>(count);
+#else
+        return -1;
+#endif
+    }
+
+    /**
+     * @brief Collects durations and reports summary statistics.
+     *
+     * Storage is reserved up front so recording from a timed loop does not
+     * allocate until the reserved capacity is exceeded.
+     */
+    class DurationStats {
+    public:
+        /**
+         * @brief Constructor for the DurationStats.
+         * @param expectedSamples The number of samples to reserve space for.
+         */
+        explicit DurationStats(const size_t expectedSamples = 1 << 16) {
+            samples.reserve(expectedSamples);
+        }
+
+        /**
+         * @brief Record a duration.
+         * @param microseconds The duration in microseconds.
+         */
+        void add(const double microseconds) { samples.push_back(microseconds); }
+
+        /**
+         * @brief Merge the samples from another set of statistics.
+         * @param other The statistics to merge.
+         */
+        void merge(const DurationStats &other) {
+            samples.insert(samples.end(), other.samples.begin(),
+                           other.samples.end());
+        }
+
+        /**
+         * @brief Get the number of recorded durations.
+         * @return The number of durations.
+         */
+        [[nodiscard]] size_t count() const { return samples.size(); }
+
+        /**
+         * @brief Get the mean of the recorded durations.
+         * @return The mean in microseconds, or 0 if empty.
+         */
+        [[nodiscard]] double mean() const {
+            if (samples.empty())
+                return 0.0;
+            double sum = 0.0;
+            for (const double s: samples)
+                sum += s;
+            return sum / static_cast<double>(samples.size());
+        }
+
+        /**
+         * @brief Get a percentile of the recorded durations.
+         * @param p The percentile in [0, 100].
+         * @return The percentile in microseconds, or 0 if empty.
+         */
+        [[nodiscard]] double percentile(const double p) const {
+            if (samples.empty())
+                return 0.0;
+            std::vector<double> sorted(samples);
+            const auto rank = static_cast<size_t>(
+                    std::clamp(p, 0.0, 100.0) / 100.0 *
+                    static_cast<double>(sorted.size() - 1));
+            std::nth_element(sorted.begin(), sorted.begin() + rank,
+                             sorted.end());
+            return sorted[rank];
+        }
+
+        /**
+         * @brief Get the largest recorded duration.
+         * @return The maximum in microseconds, or 0 if empty.
+         */
+        [[nodiscard]] double max() const {
+            if (samples.empty())
+                return 0.0;
+            return *std::max_element(samples.begin(), samples.end());
+        }
+
+    private:
+        /** The recorded durations in microseconds. */
+        std::vector<double> samples;
+    };
+
+    /**
+     * @brief Get the elapsed time between two clock readings.
+     * @param start The earlier reading.
+     * @param end The later reading.
+     * @return The elapsed time in microseconds.
+     */
+    inline double elapsedMicroseconds(const Clock::time_point start,
+                                      const Clock::time_point end) {
+        return std::chrono::duration<double, std::micro>(end - start).count();
+    }
+} // namespace HarnessUtils
+
+#endif // HARNESS_UTILS_H
@@ -0,0 +1,164 @@
+#include <iostream>
+#include "Graphverb.h"
+#include "HarnessUtils.h"
+#include "TestSignalGenerator.h"
+
+/**
+ * @brief Per-instance lifecycle benchmark, as seen by a host loading a large
+ * session or scanning plugins.
+ *
+ * One warm-up instance pays the process-wide one-off costs (shared tables,
+ * kernel autotuning) and is reported separately as the cold figures. Then a
+ * scan pass constructs and destroys instances without preparing them, and a
+ * session pass constructs N instances, prepares them all, processes a first
+ * block on each and destroys them all. Every phase is timed per instance and
+ * its p99 is checked against a budget.
+ *
+ * Usage: graphverb_instantiate [--instances=N] [--rate=R] [--block=N]
+ *                              [--max-scan-us=U] [--max-construct-us=U]
+ *                              [--max-prepare-us=U] [--max-first-block-us=U]
+ *                              [--max-destruct-us=U] [--json=path]
+ */
+namespace {
+    /**
+     * @brief A timed lifecycle phase and its budget.
+     */
+    struct Phase {
+        juce::String name;
+        double budgetUs = 0.0;
+        HarnessUtils::DurationStats durations;
+    };
+
+    /**
+     * @brief Time a callable.
+     * @param function The callable.
+     * @return The elapsed time in microseconds.
+     */
+    template<typename Function>
+    double timeUs(Function &&function) {
+        const auto start = HarnessUtils::Clock::now();
+        function();
+        return HarnessUtils::elapsedMicroseconds(start,
+                                                 HarnessUtils::Clock::now());
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const juce::ArgumentList args(argc, argv);
+    const int numInstances =
+            HarnessUtils::getIntOption(args, "--instances", 60);
+    const double sampleRate =
+            HarnessUtils::getDoubleOption(args, "--rate", 48000);
+    const int blockSize = HarnessUtils::getIntOption(args, "--block", 512);
+
+    Phase scan{"scan", HarnessUtils::getDoubleOption(args, "--max-scan-us",
+                                                     1000)};
+    Phase construct{"construct", HarnessUtils::getDoubleOption(
+                                         args, "--max-construct-us", 1000)};
+    Phase prepare{"prepare", HarnessUtils::getDoubleOption(
+                                     args, "--max-prepare-us", 10000)};
+    Phase firstBlock{"first_block", HarnessUtils::getDoubleOption(
+                                            args, "--max-first-block-us",
+                                            2000)};
+    Phase destruct{"destruct", HarnessUtils::getDoubleOption(
+                                       args, "--max-destruct-us", 5000)};
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    TestSignalGenerator generator(
+            TestSignalGenerator::getCorpusSettings("pink-noise", sampleRate));
+    juce::AudioBuffer<float> input(2, blockSize);
+    generator.generate(input.getWritePointer(0), blockSize);
+    input.copyFrom(1, 0, input, 0, 0, blockSize);
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+
+    /// Cold instance: the first one in the process
+    std::unique_ptr<Graphverb> cold;
+    Phase coldPhases[] = {{"construct"}, {"prepare"}, {"first_block"},
+                          {"destruct"}};
+    coldPhases[0].durations.add(
+            timeUs([&] { cold = std::make_unique<Graphverb>(); }));
+    coldPhases[1].durations.add(timeUs([&] {
+        cold->setRateAndBufferSizeDetails(sampleRate, blockSize);
+        cold->prepareToPlay(sampleRate, blockSize);
+    }));
+    buffer.makeCopyOf(input, true);
+    coldPhases[2].durations.add(
+            timeUs([&] { cold->processBlock(buffer, midi); }));
+    coldPhases[3].durations.add(timeUs([&] { cold.reset(); }));
+
+    /// Plugin scan: construct and destroy without preparing
+    for (int i = 0; i < numInstances; ++i)
+        scan.durations.add(timeUs([] { Graphverb scanned; }));
+
+    /// Session load: every instance alive at once, as in a project
+    std::vector<std::unique_ptr<Graphverb>> instances(
+            static_cast<size_t>(numInstances));
+    for (auto &instance: instances)
+        construct.durations.add(
+                timeUs([&] { instance = std::make_unique<Graphverb>(); }));
+    for (const auto &instance: instances)
+        prepare.durations.add(timeUs([&] {
+            instance->setRateAndBufferSizeDetails(sampleRate, blockSize);
+            instance->prepareToPlay(sampleRate, blockSize);
+        }));
+    for (const auto &instance: instances) {
+        buffer.makeCopyOf(input, true);
+        firstBlock.durations.add(
+                timeUs([&] { instance->processBlock(buffer, midi); }));
+    }
+    for (auto &instance: instances)
+        destruct.durations.add(timeUs([&] { instance.reset(); }));
+
+    bool failed = false;
+    juce::Array<juce::var> phaseJson;
+    std::cout << "cold instance (us): ";
+    for (const auto &phase: coldPhases)
+        std::cout << phase.name << " " << phase.durations.max() << "  ";
+    std::cout << std::endl;
+    std::cout << "phase         mean/p99/max (us)          budget (us)"
+              << std::endl;
+    for (const Phase *phase: {&scan, &construct, &prepare, &firstBlock,
+                              &destruct}) {
+        const double p99 = phase->durations.percentile(99.0);
+        std::cout << phase->name.paddedRight(' ', 13) << " "
+                  << phase->durations.mean() << " / " << p99 << " / "
+                  << phase->durations.max() << "   " << phase->budgetUs
+                  << std::endl;
+        if (p99 > phase->budgetUs) {
+            std::cerr << "FAIL: " << phase->name << " p99 " << p99
+                      << " us is over the " << phase->budgetUs
+                      << " us budget" << std::endl;
+            failed = true;
+        }
+        auto *object = new juce::DynamicObject();
+        object->setProperty("name", phase->name);
+        object->setProperty("mean_us", phase->durations.mean());
+        object->setProperty("p99_us", p99);
+        object->setProperty("max_us", phase->durations.max());
+        object->setProperty("budget_us", phase->budgetUs);
+        phaseJson.add(object);
+    }
+
+    if (args.containsOption("--json")) {
+        auto *coldJson = new juce::DynamicObject();
+        for (const auto &phase: coldPhases)
+            coldJson->setProperty(phase.name + "_us", phase.durations.max());
+        auto *root = new juce::DynamicObject();
+        root->setProperty("instances", numInstances);
+        root->setProperty("sample_rate", sampleRate);
+        root->setProperty("block_size", blockSize);
+        root->setProperty("cold", coldJson);
+        root->setProperty("phases", phaseJson);
+        const juce::File file = juce::File::getCurrentWorkingDirectory()
+                                        .getChildFile(args.getValueForOption(
+                                                "--json"));
+        if (!file.replaceWithText(juce::JSON::toString(juce::var(root)))) {
+            std::cerr << "Could not write " << file.getFullPathName()
+                      << std::endl;
+            failed = true;
+        }
+    }
+    return failed ? 1 : 0;
+}
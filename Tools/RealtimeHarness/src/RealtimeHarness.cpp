@@ -0,0 +1,315 @@
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include "Graphverb.h"
+#include "HarnessUtils.h"
+#include "TestSignalGenerator.h"
+
+#if JUCE_LINUX || JUCE_MAC
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+/**
+ * @brief Simulated real-time callback harness for the Graphverb processor.
+ *
+ * Drives one or more processors from a thread that behaves like an audio
+ * device callback: it wakes once per block period, processes every instance
+ * and goes back to sleep. Records the callback duration, the wake-up jitter
+ * and the number of callbacks that finished after their deadline. With
+ * --search it looks for the largest number of instances one callback thread
+ * can run within budget, which is the per-core capacity figure. Only the
+ * callback thread is pinned; the instances' analysis threads are scheduled
+ * freely by the OS, as they are in a host.
+ *
+ * Usage: graphverb_realtime [--instances=N] [--rate=R] [--block=N]
+ *                           [--seconds=S] [--fifo] [--cpu=K] [--load=N]
+ *                           [--signal=NAME] [--budget=F] [--search]
+ *                           [--json=path]
+ */
+namespace {
+    /**
+     * @brief Options shared by every trial.
+     */
+    struct Options {
+        double sampleRate = 48000.0;
+        int blockSize = 64;
+        double seconds = 5.0;
+        bool fifo = false;
+        int cpu = -1;
+        int loadThreads = 0;
+        std::string signal = "pink-noise";
+        double budget = 0.8;
+    };
+
+    /**
+     * @brief Measurements of one trial.
+     */
+    struct TrialResult {
+        int instances = 0;
+        long long callbacks = 0;
+        long long deadlineMisses = 0;
+        double periodUs = 0.0;
+        HarnessUtils::DurationStats durations;
+        HarnessUtils::DurationStats jitter;
+        bool realtimeGranted = false;
+
+        /**
+         * @brief Check if the trial stayed within budget.
+         * @param budget Fraction of the period the p99 duration may use.
+         * @return True if there were no misses and p99 was within budget.
+         */
+        [[nodiscard]] bool passed(const double budget) const {
+            return deadlineMisses == 0 &&
+                   durations.percentile(99.0) <= budget * periodUs;
+        }
+    };
+
+    /**
+     * @brief Give the calling thread real-time priority and/or pin it.
+     * @param fifo Whether to request SCHED_FIFO.
+     * @param cpu The CPU to pin to, or -1 to leave unpinned.
+     * @return True if SCHED_FIFO was requested and granted.
+     */
+    bool configureCallbackThread(const bool fifo, const int cpu) {
+        bool granted = false;
+#if JUCE_LINUX
+        if (cpu >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpu, &set);
+            if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+                std::cerr << "Could not pin callback thread to CPU " << cpu
+                          << std::endl;
+        }
+#else
+        juce::ignoreUnused(cpu);
+#endif
+#if JUCE_LINUX || JUCE_MAC
+        if (fifo) {
+            sched_param param{};
+            param.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+            granted = pthread_setschedparam(pthread_self(), SCHED_FIFO,
+                                            &param) == 0;
+            if (!granted)
+                std::cerr << "SCHED_FIFO not granted, running with normal "
+                             "priority" << std::endl;
+        }
+#else
+        juce::ignoreUnused(fifo);
+#endif
+        return granted;
+    }
+
+    /**
+     * @brief Body of a background load thread: streams through memory and
+     * does floating point work until told to stop.
+     * @param shouldExit Flag set when the trial ends.
+     */
+    void backgroundLoad(const std::atomic<bool> &shouldExit) {
+        std::vector<float> data(1 << 20, 1.0f);
+        float accumulator = 0.0f;
+        while (!shouldExit.load(std::memory_order_relaxed)) {
+            for (float &value: data) {
+                value = value * 0.999f + 0.001f;
+                accumulator += std::sqrt(value);
+            }
+        }
+        juce::ignoreUnused(accumulator);
+    }
+
+    /**
+     * @brief Run the callback loop for a number of instances.
+     * @param options The trial options.
+     * @param numInstances The number of instances processed per callback.
+     * @return The trial measurements.
+     */
+    TrialResult runTrial(const Options &options, const int numInstances) {
+        TrialResult result;
+        result.instances = numInstances;
+        result.periodUs = 1.0e6 * options.blockSize / options.sampleRate;
+
+        std::vector<std::unique_ptr<Graphverb>> processors;
+        for (int i = 0; i < numInstances; ++i) {
+            auto processor = std::make_unique<Graphverb>();
+            processor->setRateAndBufferSizeDetails(options.sampleRate,
+                                                   options.blockSize);
+            processor->prepareToPlay(options.sampleRate, options.blockSize);
+            processors.push_back(std::move(processor));
+        }
+
+        std::atomic<bool> shouldExit{false};
+        std::vector<std::thread> loadThreads;
+        for (int i = 0; i < options.loadThreads; ++i)
+            loadThreads.emplace_back(backgroundLoad, std::cref(shouldExit));
+
+        std::thread callbackThread([&] {
+            result.realtimeGranted =
+                    configureCallbackThread(options.fifo, options.cpu);
+            TestSignalGenerator generator(TestSignalGenerator::getCorpusSettings(
+                    options.signal, options.sampleRate));
+            juce::AudioBuffer<float> input(2, options.blockSize);
+            juce::AudioBuffer<float> buffer(2, options.blockSize);
+            juce::MidiBuffer midi;
+            const auto period = std::chrono::duration_cast<
+                    HarnessUtils::Clock::duration>(
+                    std::chrono::duration<double, std::micro>(
+                            result.periodUs));
+            const auto numCallbacks = static_cast<long long>(
+                    options.seconds * 1.0e6 / result.periodUs);
+            auto wake = HarnessUtils::Clock::now() + period;
+            for (long long c = 0; c < numCallbacks; ++c) {
+                /// The device hands over a new block once per period
+                generator.generate(input.getWritePointer(0),
+                                   options.blockSize);
+                input.copyFrom(1, 0, input, 0, 0, options.blockSize);
+                std::this_thread::sleep_until(wake);
+                const auto start = HarnessUtils::Clock::now();
+                for (const auto &processor: processors) {
+                    buffer.makeCopyOf(input, true);
+                    processor->processBlock(buffer, midi);
+                }
+                const auto end = HarnessUtils::Clock::now();
+                result.durations.add(
+                        HarnessUtils::elapsedMicroseconds(start, end));
+                result.jitter.add(
+                        HarnessUtils::elapsedMicroseconds(wake, start));
+                result.callbacks++;
+                if (end > wake + period)
+                    result.deadlineMisses++;
+                wake += period;
+                /// A late callback does not get to make up for lost time
+                if (end > wake)
+                    wake = end;
+            }
+        });
+        callbackThread.join();
+
+        shouldExit = true;
+        for (auto &thread: loadThreads)
+            thread.join();
+        for (const auto &processor: processors)
+            processor->releaseResources();
+        return result;
+    }
+
+    /**
+     * @brief Print one trial's measurements.
+     * @param result The trial measurements.
+     * @param budget Fraction of the period the p99 duration may use.
+     */
+    void printTrial(const TrialResult &result, const double budget) {
+        std::cout << result.instances << " instance(s): " << result.callbacks
+                  << " callbacks, " << result.deadlineMisses
+                  << " misses, duration mean/p99/max "
+                  << result.durations.mean() << "/"
+                  << result.durations.percentile(99.0) << "/"
+                  << result.durations.max() << " us, jitter p99/max "
+                  << result.jitter.percentile(99.0) << "/"
+                  << result.jitter.max() << " us, period " << result.periodUs
+                  << " us -> " << (result.passed(budget) ? "PASS" : "FAIL")
+                  << std::endl;
+    }
+
+    /**
+     * @brief Convert a trial's measurements to a JSON object.
+     * @param result The trial measurements.
+     * @param budget Fraction of the period the p99 duration may use.
+     * @return The JSON object.
+     */
+    juce::var trialToJson(const TrialResult &result, const double budget) {
+        auto *object = new juce::DynamicObject();
+        object->setProperty("instances", result.instances);
+        object->setProperty("callbacks",
+                            static_cast<juce::int64>(result.callbacks));
+        object->setProperty("deadline_misses",
+                            static_cast<juce::int64>(result.deadlineMisses));
+        object->setProperty("period_us", result.periodUs);
+        object->setProperty("duration_mean_us", result.durations.mean());
+        object->setProperty("duration_p99_us",
+                            result.durations.percentile(99.0));
+        object->setProperty("duration_max_us", result.durations.max());
+        object->setProperty("jitter_p99_us", result.jitter.percentile(99.0));
+        object->setProperty("jitter_max_us", result.jitter.max());
+        object->setProperty("realtime", result.realtimeGranted);
+        object->setProperty("passed", result.passed(budget));
+        return object;
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const juce::ArgumentList args(argc, argv);
+    Options options;
+    options.sampleRate = HarnessUtils::getDoubleOption(args, "--rate", 48000);
+    options.blockSize = HarnessUtils::getIntOption(args, "--block", 64);
+    options.seconds = HarnessUtils::getDoubleOption(args, "--seconds", 5);
+    options.fifo = args.containsOption("--fifo");
+    options.cpu = HarnessUtils::getIntOption(args, "--cpu", -1);
+    options.loadThreads = HarnessUtils::getIntOption(args, "--load", 0);
+    options.budget = HarnessUtils::getDoubleOption(args, "--budget", 0.8);
+    if (args.containsOption("--signal"))
+        options.signal = args.getValueForOption("--signal").toStdString();
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::Array<juce::var> trials;
+    int capacity = 0;
+    bool failed = false;
+    if (args.containsOption("--search")) {
+        /// Double until a trial fails, then bisect between the last pass
+        /// and the first failure
+        constexpr int maxInstances = 4096;
+        int low = 0;
+        int high = 1;
+        while (high <= maxInstances) {
+            const auto result = runTrial(options, high);
+            printTrial(result, options.budget);
+            trials.add(trialToJson(result, options.budget));
+            if (!result.passed(options.budget))
+                break;
+            low = high;
+            high *= 2;
+        }
+        while (high - low > 1) {
+            const int mid = low + (high - low) / 2;
+            const auto result = runTrial(options, mid);
+            printTrial(result, options.budget);
+            trials.add(trialToJson(result, options.budget));
+            if (result.passed(options.budget))
+                low = mid;
+            else
+                high = mid;
+        }
+        capacity = low;
+        std::cout << "capacity: " << capacity << " instance(s) per core at "
+                  << options.blockSize << " samples / " << options.sampleRate
+                  << " Hz" << std::endl;
+    } else {
+        const auto result = runTrial(
+                options, HarnessUtils::getIntOption(args, "--instances", 1));
+        printTrial(result, options.budget);
+        trials.add(trialToJson(result, options.budget));
+        failed = !result.passed(options.budget);
+    }
+
+    if (args.containsOption("--json")) {
+        auto *root = new juce::DynamicObject();
+        root->setProperty("sample_rate", options.sampleRate);
+        root->setProperty("block_size", options.blockSize);
+        root->setProperty("budget", options.budget);
+        root->setProperty("load_threads", options.loadThreads);
+        root->setProperty("signal", juce::String(options.signal));
+        root->setProperty("capacity", capacity);
+        root->setProperty("trials", trials);
+        const juce::File file = juce::File::getCurrentWorkingDirectory()
+                                        .getChildFile(args.getValueForOption(
+                                                "--json"));
+        if (!file.replaceWithText(juce::JSON::toString(juce::var(root)))) {
+            std::cerr << "Could not write " << file.getFullPathName()
+                      << std::endl;
+            failed = true;
+        }
+    }
+    return failed ? 1 : 0;
+}
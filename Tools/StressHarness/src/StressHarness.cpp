@@ -0,0 +1,352 @@
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <juce_events/juce_events.h>
+#include "Graphverb.h"
+#include "HarnessUtils.h"
+
+/**
+ * @brief Multi-instance lifecycle stress harness for the Graphverb processor.
+ *
+ * Creates a number of processors and drives them from several simulated audio
+ * threads with randomised block sizes, sample-rate changes, release/prepare
+ * churn and bypass toggles, while the main thread repeatedly opens and closes
+ * editors. With --hot the main thread also re-prepares running instances at
+ * new sample rates, as some hosts do, and changes their analysis settings,
+ * exercising the hand-over of processing state to the audio thread and of
+ * configurations to the analysis thread. Fails if analysis threads are leaked,
+ * or if more than --max-miss-ratio of the callbacks miss their deadline. Build
+ * with ASAN_ON or TSAN_ON in a Debug build to run it under a sanitizer, with
+ * a looser miss ratio.
+ *
+ * Usage: graphverb_stress [--instances=N] [--threads=N] [--seconds=S]
+ *                         [--seed=N] [--editor] [--hot] [--max-miss-ratio=R]
+ */
+namespace {
+    /** Sample rates the harness switches between. */
+    constexpr double sampleRates[] = {44100.0, 48000.0, 88200.0, 96000.0};
+
+    /** Maximum block sizes the harness switches between. */
+    constexpr int maxBlockSizes[] = {64, 128, 256, 512, 1024, 2048};
+
+    /**
+     * @brief Play head of a simulated host: a running transport at a fixed
+     * tempo, advanced after every callback.
+     */
+    class TransportPlayHead final : public juce::AudioPlayHead {
+    public:
+        /**
+         * @brief Get the current transport position.
+         * @return The position.
+         */
+        juce::Optional<PositionInfo> getPosition() const override {
+            return info;
+        }
+
+        /**
+         * @brief Start the transport at a tempo.
+         * @param bpm The tempo in beats per minute.
+         */
+        void start(const double bpm) {
+            info.setBpm(bpm);
+            info.setPpqPosition(0.0);
+            info.setIsPlaying(true);
+        }
+
+        /**
+         * @brief Advance the transport by a block.
+         * @param numSamples The number of samples in the block.
+         * @param sampleRate The sample rate.
+         */
+        void advance(const int numSamples, const double sampleRate) {
+            info.setPpqPosition(*info.getPpqPosition() +
+                                numSamples * *info.getBpm() /
+                                        (60.0 * sampleRate));
+        }
+
+    private:
+        PositionInfo info;
+    };
+
+    /**
+     * @brief State of one processor driven by a simulated audio thread.
+     */
+    struct Instance {
+        std::unique_ptr<Graphverb> processor;
+        TransportPlayHead playHead;
+        double sampleRate = 48000.0;
+        int maxBlockSize = 512;
+        bool prepared = false;
+    };
+
+    /**
+     * @brief Counters reported by one simulated audio thread.
+     */
+    struct ThreadReport {
+        HarnessUtils::DurationStats callbackTimes;
+        long long callbacks = 0;
+        long long deadlineMisses = 0;
+        long long reconfigurations = 0;
+        long long bypassToggles = 0;
+    };
+
+    /**
+     * @brief Prepare an instance for a new configuration.
+     * @param instance The instance to prepare.
+     * @param rng The random generator used to choose the configuration.
+     * @param release Whether to call releaseResources() first.
+     */
+    void reconfigure(Instance &instance, std::mt19937 &rng,
+                     const bool release) {
+        std::uniform_int_distribution<size_t> rateDist(
+                0, std::size(sampleRates) - 1);
+        std::uniform_int_distribution<size_t> blockDist(
+                0, std::size(maxBlockSizes) - 1);
+        if (release && instance.prepared)
+            instance.processor->releaseResources();
+        instance.sampleRate = sampleRates[rateDist(rng)];
+        instance.maxBlockSize = maxBlockSizes[blockDist(rng)];
+        instance.processor->setRateAndBufferSizeDetails(instance.sampleRate,
+                                                        instance.maxBlockSize);
+        instance.processor->prepareToPlay(instance.sampleRate,
+                                          instance.maxBlockSize);
+        instance.prepared = true;
+    }
+
+    /**
+     * @brief Body of a simulated audio thread.
+     * @param instances The instances owned by this thread.
+     * @param seed The random seed for this thread.
+     * @param shouldExit Flag set by the main thread to stop the run.
+     * @param report The report to fill in.
+     */
+    void audioThread(std::vector<Instance *> instances, const unsigned seed,
+                     const std::atomic<bool> &shouldExit,
+                     ThreadReport &report) {
+        std::mt19937 rng(seed);
+        std::uniform_real_distribution eventDist(0.0, 1.0);
+        std::uniform_real_distribution sampleDist(-1.0f, 1.0f);
+        juce::AudioBuffer<float> buffer(2, maxBlockSizes[std::size(
+                                                   maxBlockSizes) - 1]);
+        juce::MidiBuffer midi;
+
+        std::uniform_real_distribution tempoDist(70.0, 180.0);
+        for (auto *instance: instances) {
+            instance->playHead.start(tempoDist(rng));
+            instance->processor->setPlayHead(&instance->playHead);
+            reconfigure(*instance, rng, false);
+        }
+
+        while (!shouldExit.load()) {
+            /// All instances of a thread share one callback, as in a host
+            int blockSize = maxBlockSizes[std::size(maxBlockSizes) - 1];
+            for (const auto *instance: instances)
+                blockSize = std::min(blockSize, instance->maxBlockSize);
+            std::uniform_int_distribution blockDist(1, blockSize);
+            blockSize = blockDist(rng);
+            buffer.setSize(2, blockSize, false, false, true);
+
+            for (auto *instance: instances) {
+                if (const double event = eventDist(rng); event < 0.005) {
+                    reconfigure(*instance, rng, event < 0.0025);
+                    report.reconfigurations++;
+                    blockSize = std::min(blockSize, instance->maxBlockSize);
+                    buffer.setSize(2, blockSize, false, false, true);
+                } else if (event < 0.02) {
+                    auto *bypass =
+                            instance->processor->getParameters().getParameter(
+                                    "bypass");
+                    bypass->setValueNotifyingHost(
+                            bypass->getValue() < 0.5f ? 1.0f : 0.0f);
+                    report.bypassToggles++;
+                }
+            }
+
+            const auto start = HarnessUtils::Clock::now();
+            for (auto *instance: instances) {
+                for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+                    float *data = buffer.getWritePointer(ch);
+                    for (int s = 0; s < blockSize; ++s)
+                        data[s] = 0.25f * sampleDist(rng);
+                }
+                instance->processor->processBlock(buffer, midi);
+                instance->playHead.advance(blockSize, instance->sampleRate);
+            }
+            const double elapsed = HarnessUtils::elapsedMicroseconds(
+                    start, HarnessUtils::Clock::now());
+
+            /// Every instance on a thread runs at the slowest rate's budget
+            double sampleRate = sampleRates[std::size(sampleRates) - 1];
+            for (const auto *instance: instances)
+                sampleRate = std::min(sampleRate, instance->sampleRate);
+            const double budget = 1.0e6 * blockSize / sampleRate;
+            report.callbackTimes.add(elapsed);
+            report.callbacks++;
+            if (elapsed > budget)
+                report.deadlineMisses++;
+        }
+
+        for (auto *instance: instances)
+            instance->processor->releaseResources();
+    }
+} // namespace
+
+int main(int argc, char *argv[]) {
+    const juce::ArgumentList args(argc, argv);
+    const int numInstances =
+            std::max(1, HarnessUtils::getIntOption(args, "--instances", 16));
+    const int numThreads = std::clamp(
+            HarnessUtils::getIntOption(args, "--threads", 4), 1, numInstances);
+    const double seconds = HarnessUtils::getDoubleOption(args, "--seconds", 10);
+    const auto seed = static_cast<unsigned>(
+            HarnessUtils::getIntOption(args, "--seed", 1234));
+    const bool churnEditors = args.containsOption("--editor");
+    const bool hotReconfigure = args.containsOption("--hot");
+    const double maxMissRatio =
+            HarnessUtils::getDoubleOption(args, "--max-miss-ratio", 0.01);
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const int baselineThreads = HarnessUtils::countProcessThreads();
+
+    /// Overloaded on purpose, so keep its flight-recorder dumps out of the
+    /// user's application data
+    const juce::TemporaryFile traceDirectory;
+    std::vector<Instance> instances(static_cast<size_t>(numInstances));
+    for (auto &instance: instances) {
+        instance.processor = std::make_unique<Graphverb>();
+        instance.processor->getFlightRecorder().setDirectory(
+                traceDirectory.getFile());
+    }
+
+    std::vector<ThreadReport> reports(static_cast<size_t>(numThreads));
+    std::vector<std::thread> threads;
+    std::atomic<bool> shouldExit{false};
+    for (int t = 0; t < numThreads; ++t) {
+        std::vector<Instance *> owned;
+        for (int i = t; i < numInstances; i += numThreads)
+            owned.push_back(&instances[static_cast<size_t>(i)]);
+        threads.emplace_back(audioThread, std::move(owned),
+                             seed + static_cast<unsigned>(t),
+                             std::cref(shouldExit),
+                             std::ref(reports[static_cast<size_t>(t)]));
+    }
+
+    /// Upper bound: one analysis thread per instance plus the audio threads,
+    /// and the convolution loader the instances share
+    const int maxExpectedThreads =
+            baselineThreads + numInstances + numThreads + 1;
+    int peakThreads = baselineThreads;
+    long long editorCycles = 0;
+    long long hotReconfigurations = 0;
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution instanceDist(0, numInstances - 1);
+    std::uniform_int_distribution<size_t> rateDist(0,
+                                                   std::size(sampleRates) - 1);
+    const auto end = HarnessUtils::Clock::now() +
+                     std::chrono::duration<double>(seconds);
+    while (HarnessUtils::Clock::now() < end) {
+        if (churnEditors) {
+            auto &processor =
+                    *instances[static_cast<size_t>(instanceDist(rng))]
+                             .processor;
+            std::unique_ptr<juce::AudioProcessorEditor> editor(
+                    processor.createEditorIfNeeded());
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(20);
+            editor.reset();
+            editorCycles++;
+        }
+        if (hotReconfigure) {
+            /// Sized for the largest block the audio threads may send
+            instances[static_cast<size_t>(instanceDist(rng))]
+                    .processor->prepareToPlay(
+                            sampleRates[rateDist(rng)],
+                            maxBlockSizes[std::size(maxBlockSizes) - 1]);
+            std::uniform_int_distribution orderDist(9, 11);
+            std::uniform_int_distribution clusterDist(4, Graphverb::numClusters);
+            AnalysisConfig config;
+            config.fftOrder = orderDist(rng);
+            config.hopSize = config.getFftSize() / 2;
+            config.numClusters = clusterDist(rng);
+            config.separateHarmonicPercussive = (rng() & 1) != 0;
+            config.beatSubdivisions = (rng() & 2) != 0 ? 4 : 0;
+            auto &processor =
+                    *instances[static_cast<size_t>(instanceDist(rng))]
+                             .processor;
+            processor.setAnalysisConfig(config);
+            processor.setStaticReverb((rng() & 4) != 0);
+            processor.setModalReverb((rng() & 8) != 0);
+            hotReconfigurations++;
+        }
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(10);
+        peakThreads =
+                std::max(peakThreads, HarnessUtils::countProcessThreads());
+    }
+
+    shouldExit = true;
+    for (auto &thread: threads)
+        thread.join();
+    threads.clear();
+    uint64_t traceDumps = 0, failedCaptures = 0;
+    for (const auto &instance: instances) {
+        traceDumps += instance.processor->getFlightRecorder().getNumDumps();
+        failedCaptures += instance.processor->getNumFailedAnalysisCaptures();
+    }
+    instances.clear();
+    traceDirectory.getFile().deleteRecursively();
+    juce::MessageManager::getInstance()->runDispatchLoopUntil(50);
+    const int finalThreads = HarnessUtils::countProcessThreads();
+
+    HarnessUtils::DurationStats callbackTimes;
+    long long callbacks = 0, misses = 0, reconfigurations = 0, toggles = 0;
+    for (const auto &report: reports) {
+        callbackTimes.merge(report.callbackTimes);
+        callbacks += report.callbacks;
+        misses += report.deadlineMisses;
+        reconfigurations += report.reconfigurations;
+        toggles += report.bypassToggles;
+    }
+
+    std::cout << "instances:          " << numInstances << "\n"
+              << "audio threads:      " << numThreads << "\n"
+              << "callbacks:          " << callbacks << "\n"
+              << "reconfigurations:   " << reconfigurations << "\n"
+              << "hot reconfigs:      " << hotReconfigurations << "\n"
+              << "bypass toggles:     " << toggles << "\n"
+              << "editor cycles:      " << editorCycles << "\n"
+              << "deadline misses:    " << misses << "\n"
+              << "trace dumps:        " << traceDumps << "\n"
+              << "failed captures:    " << failedCaptures << "\n"
+              << "callback mean (us): " << callbackTimes.mean() << "\n"
+              << "callback p99 (us):  " << callbackTimes.percentile(99.0)
+              << "\n"
+              << "callback max (us):  " << callbackTimes.max() << "\n"
+              << "threads baseline/peak/final: " << baselineThreads << "/"
+              << peakThreads << "/" << finalThreads << std::endl;
+
+    bool failed = false;
+    if (baselineThreads >= 0 && peakThreads > maxExpectedThreads) {
+        std::cerr << "FAIL: thread count exceeded " << maxExpectedThreads
+                  << std::endl;
+        failed = true;
+    }
+    if (baselineThreads >= 0 && finalThreads > baselineThreads) {
+        std::cerr << "FAIL: " << finalThreads - baselineThreads
+                  << " thread(s) leaked" << std::endl;
+        failed = true;
+    }
+    if (callbacks > 0 &&
+        static_cast<double>(misses) > maxMissRatio * callbacks) {
+        std::cerr << "FAIL: " << misses << " of " << callbacks
+                  << " callbacks missed their deadline, above "
+                  << maxMissRatio << std::endl;
+        failed = true;
+    }
+    if (failedCaptures > 0) {
+        std::cerr << "FAIL: " << failedCaptures
+                  << " GRAPHVERB_CAPTURE_DIR capture(s) could not be started"
+                  << std::endl;
+        failed = true;
+    }
+    return failed ? 1 : 0;
+}